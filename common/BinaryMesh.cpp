@@ -0,0 +1,240 @@
+#include "BinaryMesh.h"
+
+#include <sys/stat.h>
+#ifdef TARGET_WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    const char MAGIC[4] = { 'P', 'M', 'B', 'M' };
+
+    // everything in the header is a 32 bit unsigned int so the arrays that
+    // follow it are all four byte aligned which is all that they need
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t mode;
+        uint32_t numVertices;
+        uint32_t numNormals;
+        uint32_t numColors;
+        uint32_t numTexCoords;
+        uint32_t numIndices;
+    };
+
+    // maps a whole file into memory read only
+    class MappedFile
+    {
+    public:
+        MappedFile(const string& path) : data(NULL), size(0)
+        {
+#ifdef TARGET_WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            mapping = NULL;
+            if (file == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart) return;
+            mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping) return;
+            data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data) size = fileSize.QuadPart;
+#else
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat info;
+            if (fstat(fd, &info) || !info.st_size) return;
+            void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) return;
+            data = (const unsigned char*)mapped;
+            size = info.st_size;
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef TARGET_WIN32
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (data) munmap((void*)data, size);
+            if (fd >= 0) close(fd);
+#endif
+        }
+
+        const unsigned char* data;
+        size_t size;
+
+    private:
+#ifdef TARGET_WIN32
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int fd;
+#endif
+    };
+
+    // copy an array out of the mapped file into a vector and move on past it
+    template<typename T>
+    bool readArray(const unsigned char*& data, const unsigned char* end, unsigned count, vector<T>& out)
+    {
+        const size_t numBytes = count * sizeof(T);
+        if (end - data < (ptrdiff_t)numBytes) return false;
+        out.resize(count);
+        if (count) memcpy(&out[0], data, numBytes);
+        data += numBytes;
+        return true;
+    }
+
+    template<typename T>
+    void writeArray(ofstream& file, const vector<T>& data)
+    {
+        if (!data.empty()) file.write((const char*)&data[0], data.size() * sizeof(T));
+    }
+}
+
+bool BinaryMesh::save(const ofMesh& mesh, const string& path)
+{
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.mode = mesh.getMode();
+    header.numVertices = mesh.getNumVertices();
+    header.numNormals = mesh.getNumNormals();
+    header.numColors = mesh.getNumColors();
+    header.numTexCoords = mesh.getNumTexCoords();
+    header.numIndices = mesh.getNumIndices();
+
+    // write to a temporary file and then move it into place so
+    // that we never leave a half written file behind
+    const string absolutePath = ofToDataPath(path, true);
+    const string temporaryPath = absolutePath + ".tmp";
+    {
+        ofstream file(temporaryPath.c_str(), ios::binary | ios::trunc);
+        if (!file)
+        {
+            ofLogError("BinaryMesh") << "couldn't open " << temporaryPath << " for writing";
+            return false;
+        }
+
+        file.write((const char*)&header, sizeof(header));
+        writeArray(file, mesh.getVertices());
+        writeArray(file, mesh.getNormals());
+        writeArray(file, mesh.getColors());
+        writeArray(file, mesh.getTexCoords());
+
+        // indices are always saved as 32 bit so files work whatever ofIndexType is
+        vector<uint32_t> indices(mesh.getIndices().begin(), mesh.getIndices().end());
+        writeArray(file, indices);
+
+        if (!file)
+        {
+            ofLogError("BinaryMesh") << "couldn't write " << temporaryPath;
+            return false;
+        }
+    }
+    return ofFile::moveFromTo(temporaryPath, absolutePath, false, true);
+}
+
+bool BinaryMesh::load(const string& path, ofMesh& mesh)
+{
+    MappedFile file(ofToDataPath(path, true));
+    if (!file.data)
+    {
+        ofLogError("BinaryMesh") << "couldn't map " << path;
+        return false;
+    }
+
+    if (file.size < sizeof(Header))
+    {
+        ofLogError("BinaryMesh") << path << " is too small to be a binary mesh";
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)))
+    {
+        ofLogError("BinaryMesh") << path << " is not a binary mesh";
+        return false;
+    }
+    if (header.version != VERSION)
+    {
+        ofLogError("BinaryMesh") << path << " is version " << header.version << ", we can only load version " << VERSION;
+        return false;
+    }
+
+    // read everything before touching the mesh so a truncated
+    // file doesn't leave it with some arrays from the file
+    const unsigned char* data = file.data + sizeof(header);
+    const unsigned char* end = file.data + file.size;
+    vector<ofVec3f> vertices;
+    vector<ofVec3f> normals;
+    vector<ofFloatColor> colors;
+    vector<ofVec2f> texCoords;
+    vector<uint32_t> indices;
+    if (!readArray(data, end, header.numVertices, vertices) ||
+        !readArray(data, end, header.numNormals, normals) ||
+        !readArray(data, end, header.numColors, colors) ||
+        !readArray(data, end, header.numTexCoords, texCoords) ||
+        !readArray(data, end, header.numIndices, indices))
+    {
+        ofLogError("BinaryMesh") << path << " is truncated";
+        return false;
+    }
+    mesh.getVertices().swap(vertices);
+    mesh.getNormals().swap(normals);
+    mesh.getColors().swap(colors);
+    mesh.getTexCoords().swap(texCoords);
+    mesh.getIndices().assign(indices.begin(), indices.end());
+    mesh.setMode((ofPrimitiveMode)header.mode);
+
+    // getting the arrays from the mesh to write into marks them as
+    // changed so a vbo mesh will upload them the next time it's drawn
+    return true;
+}
+
+bool BinaryMesh::isUpToDate(const string& path, const string& sourcePath)
+{
+    struct stat binaryInfo;
+    if (stat(ofToDataPath(path, true).c_str(), &binaryInfo)) return false;
+
+    // with no ply there's nothing newer to load instead, save writes the
+    // ply before the binary mesh so they usually have the same time
+    struct stat sourceInfo;
+    if (stat(ofToDataPath(sourcePath, true).c_str(), &sourceInfo)) return true;
+    return binaryInfo.st_mtime >= sourceInfo.st_mtime;
+}
+
+string BinaryMesh::benchmark(unsigned resolution)
+{
+    const ofMesh source = ofMesh::box(100.f, 100.f, 100.f, resolution, resolution, resolution);
+    const string plyPath = "benchmark.ply";
+    const string binaryPath = "benchmark.mesh";
+    source.save(plyPath);
+    save(source, binaryPath);
+
+    ofMesh mesh;
+    unsigned long long start = ofGetElapsedTimeMicros();
+    mesh.load(plyPath);
+    const float plyMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+
+    start = ofGetElapsedTimeMicros();
+    load(binaryPath, mesh);
+    const float binaryMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+
+    stringstream report;
+    report << source.getNumVertices() << " vertices, " << source.getNumIndices() << " indices: "
+           << "ply " << plyMillis << "ms (" << ofFile(plyPath).getSize() / 1024 << "KB), "
+           << "binary " << binaryMillis << "ms (" << ofFile(binaryPath).getSize() / 1024 << "KB), "
+           << plyMillis / max(binaryMillis, .001f) << " times faster";
+
+    ofFile::removeFile(plyPath);
+    ofFile::removeFile(binaryPath);
+    return report.str();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ofMain.h"
+
+// saves and loads meshes in a simple versioned binary format
+//
+// a ply file has to be parsed number by number which gets slow once meshes
+// have hundreds of thousands of vertices, a binary mesh file is just a
+// header followed by the vertex, normal, colour, texture coordinate and
+// index arrays exactly as they are laid out in memory, so loading one is
+// a case of memory mapping the file and copying each array straight into
+// the mesh, from where it goes straight into the vbo when the mesh is drawn
+//
+// ply is still the format to use for moving meshes in and out of other
+// software, this is just a faster cache of the same data
+class BinaryMesh
+{
+public:
+    static const unsigned VERSION = 1;
+
+    static bool save(const ofMesh& mesh, const string& path);
+    // mesh is only changed if the whole file loads
+    static bool load(const string& path, ofMesh& mesh);
+
+    // whether the binary mesh at path exists and was saved since sourcePath,
+    // the ply it's a cache of, last changed, if the ply is newer it's been
+    // edited elsewhere and the binary mesh should be made again from it
+    static bool isUpToDate(const string& path, const string& sourcePath);
+
+    // makes a dense mesh, saves it as both ply and binary and
+    // returns a report of how long each one takes to load
+    static string benchmark(unsigned resolution = 128);
+};
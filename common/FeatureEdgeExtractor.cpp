@@ -0,0 +1,292 @@
+#include "FeatureEdgeExtractor.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    // each thread gets at least this many vertices, triangles or edges
+    const unsigned MIN_ITEMS_PER_THREAD = 4096;
+
+    // the cell that a vertex is welded in is 21 bits in each of x, y and z
+    const unsigned CELL_BITS = 21;
+    const uint64_t MAX_CELL = (1u << CELL_BITS) - 1;
+
+    // the half edges of degenerate triangles sort to the end and are left out
+    const uint64_t NO_EDGE = ~0ull;
+    const uint32_t NO_VERTEX = ~0u;
+
+    // a vertex's weld cell or a half edge's two vertices, with which
+    // vertex or half edge it is, sorting these puts the same keys next to
+    // each other, in the same order however many threads sorted them
+    struct KeyedIndex
+    {
+        uint64_t key;
+        uint32_t index;
+
+        bool operator<(const KeyedIndex& other) const
+        {
+            return key < other.key || (key == other.key && index < other.index);
+        }
+    };
+
+    // maxThreads of 0 means all of the shared pool's threads
+    unsigned getNumThreads(size_t size, unsigned maxThreads)
+    {
+        if (!maxThreads) maxThreads = WorkerPool::get().getNumThreads();
+        return ofClamp(size / MIN_ITEMS_PER_THREAD, 1, maxThreads);
+    }
+
+    // split [0, size) between up to maxThreads threads and call body with each part
+    void parallelFor(size_t size, unsigned maxThreads, const function<void(size_t, size_t)>& body)
+    {
+        WorkerPool::get().parallelFor(size, getNumThreads(size, maxThreads), body);
+    }
+
+    // each thread sorts its own part and then the parts are merged in pairs,
+    // the pairs in parallel, until there's only one left
+    void parallelSort(vector<KeyedIndex>& items, unsigned maxThreads)
+    {
+        const unsigned numParts = getNumThreads(items.size(), maxThreads);
+        vector<size_t> bounds(numParts + 1);
+        for (unsigned i = 0; i <= numParts; ++i) bounds[i] = items.size() * i / numParts;
+
+        WorkerPool::get().run(numParts, [&](unsigned part)
+        {
+            sort(items.begin() + bounds[part], items.begin() + bounds[part + 1]);
+        });
+        for (unsigned width = 1; width < numParts; width *= 2)
+        {
+            WorkerPool::get().run((numParts + 2 * width - 1) / (2 * width), [&](unsigned pair)
+            {
+                const unsigned first = 2 * width * pair;
+                const unsigned middle = min(numParts, first + width);
+                const unsigned last = min(numParts, first + 2 * width);
+                inplace_merge(items.begin() + bounds[first], items.begin() + bounds[middle], items.begin() + bounds[last]);
+            });
+        }
+    }
+
+    uint64_t getCell(float value, float low, float cellSize)
+    {
+        return min<uint64_t>(MAX_CELL, max(0.f, (value - low) / cellSize));
+    }
+}
+
+FeatureEdgeExtractor::Stats::Stats() :
+    numTriangles(0),
+    numWeldedVertices(0),
+    numEdges(0),
+    numFeatureEdges(0),
+    numBoundaryEdges(0),
+    numNonManifoldEdges(0),
+    weldMillis(0.f),
+    edgeMillis(0.f),
+    totalMillis(0.f)
+{
+}
+
+ofMesh FeatureEdgeExtractor::extract(const ofMesh& mesh, float featureAngle, float weldDistance, unsigned maxThreads, Stats* stats)
+{
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    ofMesh outline;
+    outline.setMode(OF_PRIMITIVE_LINES);
+    if (mesh.getMode() != OF_PRIMITIVE_TRIANGLES)
+    {
+        ofLogError("FeatureEdgeExtractor") << "can only find the edges of OF_PRIMITIVE_TRIANGLES meshes";
+        return outline;
+    }
+
+    const vector<ofVec3f>& vertices = mesh.getVertices();
+    const vector<ofIndexType>& indices = mesh.getIndices();
+    const bool indexed = mesh.hasIndices();
+    const unsigned numTriangles = (indexed ? indices.size() : vertices.size()) / 3;
+    if (vertices.empty() || !numTriangles) return outline;
+
+    // the grid has to cover the whole mesh with the cells we've got, if
+    // weldDistance is too small for that then the cells get bigger
+    ofVec3f low = vertices[0];
+    ofVec3f high = vertices[0];
+    for (const ofVec3f& vertex : vertices)
+    {
+        low.set(min(low.x, vertex.x), min(low.y, vertex.y), min(low.z, vertex.z));
+        high.set(max(high.x, vertex.x), max(high.y, vertex.y), max(high.z, vertex.z));
+    }
+    const ofVec3f size = high - low;
+    const float cellSize = max(max(weldDistance, 1e-12f), max(size.x, max(size.y, size.z)) / MAX_CELL);
+
+    // weld: every vertex in the same cell becomes the first of them, the
+    // same position repeated, which is what we're really welding, always
+    // lands in the same cell
+    vector<KeyedIndex> cells(vertices.size());
+    parallelFor(vertices.size(), maxThreads, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            cells[i].key = getCell(vertices[i].x, low.x, cellSize) << (2 * CELL_BITS) |
+                           getCell(vertices[i].y, low.y, cellSize) << CELL_BITS |
+                           getCell(vertices[i].z, low.z, cellSize);
+            cells[i].index = i;
+        }
+    });
+    parallelSort(cells, maxThreads);
+
+    vector<uint32_t> welded(vertices.size());
+    vector<ofVec3f> weldedVertices;
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        if (!i || cells[i].key != cells[i - 1].key) weldedVertices.push_back(vertices[cells[i].index]);
+        welded[cells[i].index] = weldedVertices.size() - 1;
+    }
+    cells = vector<KeyedIndex>();
+    const unsigned long long weldEnd = ofGetElapsedTimeMicros();
+
+    // each triangle's face normal and its three half edges, half edge
+    // 3 * t + k goes from corner k of triangle t to the next corner
+    vector<uint32_t> corners(3 * numTriangles);
+    vector<ofVec3f> normals(numTriangles);
+    vector<KeyedIndex> halfEdges(3 * numTriangles);
+    parallelFor(numTriangles, maxThreads, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                corners[3 * t + k] = welded[indexed ? indices[3 * t + k] : 3 * t + k];
+            }
+            const uint32_t* corner = &corners[3 * t];
+            const ofVec3f& a = weldedVertices[corner[0]];
+            normals[t] = (weldedVertices[corner[1]] - a).getCrossed(weldedVertices[corner[2]] - a);
+
+            // triangles that have been welded down to a line or that
+            // have no area don't have a normal or any edges of their own
+            const float length = normals[t].length();
+            const bool degenerate = corner[0] == corner[1] || corner[1] == corner[2] || corner[2] == corner[0] || length <= 0.f;
+            if (!degenerate) normals[t] /= length;
+
+            // the key is the same for both directions along the edge so twins sort together
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                const uint64_t from = corner[k];
+                const uint64_t to = corner[(k + 1) % 3];
+                halfEdges[3 * t + k].key = degenerate ? NO_EDGE : min(from, to) << 32 | max(from, to);
+                halfEdges[3 * t + k].index = 3 * t + k;
+            }
+        }
+    });
+    parallelSort(halfEdges, maxThreads);
+
+    // each thread takes a run of the sorted half edges, moved on to the start
+    // of the next edge so that every edge is looked at by exactly one thread
+    const float minCos = cos(ofDegToRad(featureAngle));
+    const unsigned numThreads = getNumThreads(halfEdges.size(), maxThreads);
+    vector<vector<uint64_t> > kept(numThreads);
+    vector<Stats> threadStats(numThreads);
+    WorkerPool::get().run(numThreads, [&](unsigned part)
+    {
+        size_t i = halfEdges.size() * part / numThreads;
+        const size_t end = halfEdges.size() * (part + 1) / numThreads;
+        while (i > 0 && i < halfEdges.size() && halfEdges[i].key == halfEdges[i - 1].key) ++i;
+
+        while (i < end && halfEdges[i].key != NO_EDGE)
+        {
+            size_t twin = i + 1;
+            while (twin < halfEdges.size() && halfEdges[twin].key == halfEdges[i].key) ++twin;
+            const size_t count = twin - i;
+            ++threadStats[part].numEdges;
+
+            bool keep = true;
+            if (count == 1) ++threadStats[part].numBoundaryEdges;
+            else if (count > 2) ++threadStats[part].numNonManifoldEdges;
+            else
+            {
+                // if the triangles are wound different ways then both half
+                // edges go the same way and one of the normals is flipped
+                const uint32_t first = halfEdges[i].index;
+                const uint32_t second = halfEdges[i + 1].index;
+                const bool sameWay = corners[first] == corners[second];
+                const float cosAngle = normals[first / 3].dot(normals[second / 3]) * (sameWay ? -1.f : 1.f);
+                keep = cosAngle < minCos;
+                if (keep) ++threadStats[part].numFeatureEdges;
+            }
+            if (keep) kept[part].push_back(halfEdges[i].key);
+            i = twin;
+        }
+    });
+    halfEdges = vector<KeyedIndex>();
+
+    // only the vertices that the kept edges use go into the outline, in
+    // the order they're first used so it's the same every time
+    vector<uint32_t> outlineIndex(weldedVertices.size(), NO_VERTEX);
+    for (const vector<uint64_t>& edges : kept)
+    {
+        for (uint64_t edge : edges)
+        {
+            const uint32_t ends[] = { uint32_t(edge >> 32), uint32_t(edge & 0xffffffff) };
+            for (uint32_t end : ends)
+            {
+                if (outlineIndex[end] == NO_VERTEX)
+                {
+                    outlineIndex[end] = outline.getNumVertices();
+                    outline.addVertex(weldedVertices[end]);
+                }
+                outline.addIndex(outlineIndex[end]);
+            }
+        }
+    }
+
+    if (stats)
+    {
+        *stats = Stats();
+        for (const Stats& threadStat : threadStats)
+        {
+            stats->numEdges += threadStat.numEdges;
+            stats->numFeatureEdges += threadStat.numFeatureEdges;
+            stats->numBoundaryEdges += threadStat.numBoundaryEdges;
+            stats->numNonManifoldEdges += threadStat.numNonManifoldEdges;
+        }
+        const unsigned long long end = ofGetElapsedTimeMicros();
+        stats->numTriangles = numTriangles;
+        stats->numWeldedVertices = weldedVertices.size();
+        stats->weldMillis = (weldEnd - start) / 1000.f;
+        stats->edgeMillis = (end - weldEnd) / 1000.f;
+        stats->totalMillis = (end - start) / 1000.f;
+    }
+    return outline;
+}
+
+void FeatureEdgeExtractor::scaleAboutCentre(ofMesh& mesh, float scale)
+{
+    vector<ofVec3f>& vertices = mesh.getVertices();
+    if (vertices.empty()) return;
+
+    ofVec3f low = vertices[0];
+    ofVec3f high = vertices[0];
+    for (const ofVec3f& vertex : vertices)
+    {
+        low.set(min(low.x, vertex.x), min(low.y, vertex.y), min(low.z, vertex.z));
+        high.set(max(high.x, vertex.x), max(high.y, vertex.y), max(high.z, vertex.z));
+    }
+
+    const ofVec3f centre = (low + high) / 2.f;
+    for (ofVec3f& vertex : vertices) vertex = centre + (vertex - centre) * scale;
+}
+
+string FeatureEdgeExtractor::benchmark(unsigned resolution)
+{
+    // every face of the box is split into lots of triangles that lie flat
+    // against each other, and the faces don't share their vertices, so we
+    // should get back the box's 12 edges split up as finely as the faces are
+    const ofMesh source = ofMesh::box(100.f, 100.f, 100.f, resolution, resolution, resolution);
+
+    Stats single;
+    extract(source, 30.f, .001f, 1, &single);
+    Stats multi;
+    const ofMesh outline = extract(source, 30.f, .001f, 0, &multi);
+
+    stringstream report;
+    report << multi.numTriangles << " triangles, " << multi.numWeldedVertices << " welded vertices, "
+           << multi.numEdges << " edges, " << outline.getNumIndices() / 2 << " kept (" << multi.numFeatureEdges
+           << " feature, " << multi.numBoundaryEdges << " boundary, " << multi.numNonManifoldEdges << " non manifold): "
+           << "1 thread " << single.totalMillis << "ms, " << WorkerPool::get().getNumThreads() << " threads "
+           << multi.totalMillis << "ms (weld " << multi.weldMillis << "ms, edges " << multi.edgeMillis << "ms)";
+    return report.str();
+}
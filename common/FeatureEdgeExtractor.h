@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ofMain.h"
+
+// builds an outline mesh for any triangle mesh
+//
+// the outline of the box is written out by hand as 24 indices, which is
+// fine for a box but not for a scanned sculpture, so instead we keep the
+// edges where the surface folds: those whose two triangles meet at more
+// than featureAngle degrees, plus the boundary edges that only have one
+// triangle and any edges shared by more than two
+//
+// meshes often repeat the same position for every face that uses it, e.g.
+// ofMesh::box() and anything loaded from an stl, so the vertices are welded
+// first, anything in the same weldDistance sized cell of a grid is one vertex,
+// then every triangle's three half edges are sorted by the vertices they join
+// so each one ends up next to its twin on the neighbouring triangle, the
+// sorting, the normals and the angles are all split across threads
+//
+// the result is an OF_PRIMITIVE_LINES mesh with each edge in it once and
+// only the welded vertices that the edges use
+class FeatureEdgeExtractor
+{
+public:
+    struct Stats
+    {
+        Stats();
+
+        unsigned numTriangles;
+        unsigned numWeldedVertices;
+        unsigned numEdges;
+        unsigned numFeatureEdges;
+        unsigned numBoundaryEdges;
+        unsigned numNonManifoldEdges;
+        float weldMillis;
+        float edgeMillis;
+        float totalMillis;
+    };
+
+    // mesh has to be OF_PRIMITIVE_TRIANGLES, with or without indices, maxThreads
+    // of 0 means as many as there are cores, stats is filled in if it's given
+    static ofMesh extract(const ofMesh& mesh, float featureAngle = 30.f, float weldDistance = .001f,
+                          unsigned maxThreads = 0, Stats* stats = NULL);
+
+    // scale mesh about the middle of its bounding box, the model an outline
+    // is extracted from is drawn a little smaller than the outline so the
+    // outline is just outside it all the way round and isn't hidden by it
+    static void scaleAboutCentre(ofMesh& mesh, float scale);
+
+    // extracts the outline of a dense box with one thread and with
+    // all of them and returns a report of how long each one takes
+    static string benchmark(unsigned resolution = 400);
+};
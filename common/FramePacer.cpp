@@ -0,0 +1,292 @@
+#include "FramePacer.h"
+#include "HeadlessBenchmark.h"
+
+#ifndef TARGET_OPENGLES
+    #include "ofAppGLFWWindow.h"
+#endif
+
+namespace
+{
+    // a frame that arrives more than this many refreshes after
+    // the last one has missed the refresh it was meant for
+    const float MISSED_DEADLINE_REFRESHES = 1.5f;
+
+    // if most frames come quicker than this many refreshes apart
+    // then swapping the buffers isn't waiting for the refresh
+    const float MIN_VSYNC_REFRESHES = .75f;
+
+    // in low latency mode we leave enough time for this fraction of recent frames
+    const float WORK_PERCENTILE = .9f;
+
+    // the value that fraction of values are below, ignoring the zeros
+    // that haven't been filled in yet, or 0 if they're all zeros
+    float getPercentile(vector<float> values, float fraction)
+    {
+        values.erase(remove(values.begin(), values.end(), 0.f), values.end());
+        if (values.empty()) return 0.f;
+        sort(values.begin(), values.end());
+        return values[min<size_t>(values.size() - 1, floor(fraction * values.size()))];
+    }
+}
+
+FramePacer::FramePacer() :
+    enabled(false),
+    fallbackRefreshRate(60.f),
+    detectedRefreshRate(0.f),
+    refreshMicros(1000000.f / 60.f),
+    vsyncWorking(true),
+    lastFrameStart(0),
+    nextDeadline(0),
+    workStart(0),
+    intervals(HISTORY_LENGTH, 0.f),
+    workTimes(HISTORY_LENGTH, 0.f),
+    latencies(HISTORY_LENGTH, 0.f),
+    historyIndex(0),
+    numFrames(0),
+    numMissedDeadlines(0),
+    numRepeatedRefreshes(0),
+    lastWorkMicros(0),
+    lastWaitMicros(0)
+{
+}
+
+FramePacer::~FramePacer()
+{
+    if (!enabled) return;
+    ofRemoveListener(ofEvents().update, this, &FramePacer::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+    ofRemoveListener(ofEvents().draw, this, &FramePacer::onDraw, OF_EVENT_ORDER_AFTER_APP);
+}
+
+void FramePacer::setup(float fallbackRefreshRate)
+{
+    // no more sleeping to hit a frame rate, swapping the buffers
+    // waits for the refresh instead
+    ofSetFrameRate(0);
+    ofSetVerticalSync(true);
+
+    parameters.setName("framePacing");
+    parameters.add(lowLatency.set("lowLatency", false));
+    parameters.add(safetyMarginMillis.set("safetyMarginMillis", 2.f, 0.f, 10.f));
+
+    this->fallbackRefreshRate = fallbackRefreshRate;
+    detectedRefreshRate = detectRefreshRate();
+    refreshMicros = 1000000.f / (detectedRefreshRate > 0.f ? detectedRefreshRate : fallbackRefreshRate);
+    if (detectedRefreshRate > 0.f) ofLogNotice("FramePacer") << "display refreshes at " << detectedRefreshRate << "Hz";
+    else ofLogWarning("FramePacer") << "couldn't find the display's refresh rate, assuming " << fallbackRefreshRate << "Hz";
+
+    // we're around the app's update() and draw() so that we can wait
+    // before it starts and see how long it took when it's finished
+    if (!enabled)
+    {
+        ofAddListener(ofEvents().update, this, &FramePacer::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+        ofAddListener(ofEvents().draw, this, &FramePacer::onDraw, OF_EVENT_ORDER_AFTER_APP);
+        enabled = true;
+    }
+}
+
+float FramePacer::getIntervalMillis() const
+{
+    float sum = 0.f;
+    unsigned count = 0;
+    for (unsigned i = 0; i < intervals.size(); ++i)
+    {
+        if (intervals[i] == 0.f) continue;
+        sum += intervals[i];
+        ++count;
+    }
+    return count ? sum / count / 1000.f : 0.f;
+}
+
+float FramePacer::getIntervalJitterMillis() const
+{
+    const float mean = 1000.f * getIntervalMillis();
+    float sum = 0.f;
+    unsigned count = 0;
+    for (unsigned i = 0; i < intervals.size(); ++i)
+    {
+        if (intervals[i] == 0.f) continue;
+        sum += (intervals[i] - mean) * (intervals[i] - mean);
+        ++count;
+    }
+    return count ? sqrt(sum / count) / 1000.f : 0.f;
+}
+
+float FramePacer::getLatencyMillis() const
+{
+    return getPercentile(latencies, .5f) / 1000.f;
+}
+
+void FramePacer::resetCounters()
+{
+    fill(intervals.begin(), intervals.end(), 0.f);
+    fill(workTimes.begin(), workTimes.end(), 0.f);
+    fill(latencies.begin(), latencies.end(), 0.f);
+    historyIndex = 0;
+    numFrames = 0;
+    numMissedDeadlines = 0;
+    numRepeatedRefreshes = 0;
+
+    // give vsync another chance in case it was the driver settings that changed
+    vsyncWorking = true;
+}
+
+string FramePacer::getStatus() const
+{
+    stringstream status;
+    status << fixed << setprecision(2)
+           << getRefreshRate() << "Hz " << (vsyncWorking ? "with vsync" : "without vsync, sleeping instead")
+           << (lowLatency ? ", low latency" : "")
+           << "\nframe interval " << getIntervalMillis() << "ms +/- " << getIntervalJitterMillis() << "ms"
+           << ", work " << getLastWorkMillis() << "ms, waited " << getLastWaitMillis() << "ms"
+           << "\ninput to refresh " << getLatencyMillis() << "ms"
+           << "\n" << numMissedDeadlines << " missed deadlines, " << numRepeatedRefreshes
+           << " repeated refreshes in " << numFrames << " frames";
+    return status.str();
+}
+
+void FramePacer::onUpdate(ofEventArgs& args)
+{
+    // benchmarks run as fast as they can
+    if (HeadlessBenchmark::isRunning()) return;
+
+    // in low latency mode we wait for the last frame to really have been
+    // swapped, otherwise the driver can queue it up and return straight away
+    // and we wouldn't know when the refresh was to count back from
+    if (lowLatency && vsyncWorking) glFinish();
+
+    const unsigned long long now = ofGetElapsedTimeMicros();
+
+    // when this frame needs to be finished by, with vsync it's the refresh
+    // after the one we've just waited for, without it we keep our own
+    // refreshes, starting them again from now if we've missed one
+    unsigned long long deadline = now + refreshMicros;
+    if (!vsyncWorking)
+    {
+        if (now > nextDeadline) nextDeadline = deadline;
+        deadline = nextDeadline;
+        nextDeadline += refreshMicros;
+    }
+    const unsigned long long refresh = deadline - refreshMicros;
+
+    if (lastFrameStart)
+    {
+        const float interval = refresh > lastFrameStart ? refresh - lastFrameStart : refreshMicros;
+        intervals[historyIndex] = interval;
+        ++numFrames;
+
+        // the last frame went up at the refresh we've just waited for
+        if (workStart && refresh > workStart) latencies[historyIndex] = refresh - workStart;
+
+        const float refreshes = interval / refreshMicros;
+        if (refreshes > MISSED_DEADLINE_REFRESHES)
+        {
+            ++numMissedDeadlines;
+            numRepeatedRefreshes += (unsigned long)(refreshes + .5f) - 1;
+        }
+
+        if (++historyIndex == HISTORY_LENGTH)
+        {
+            historyIndex = 0;
+
+            // look at which monitor we're on every so often
+            // in case the window's been moved to another one
+            detectedRefreshRate = detectRefreshRate();
+            const float nominalMicros = 1000000.f / (detectedRefreshRate > 0.f ? detectedRefreshRate : fallbackRefreshRate);
+
+            if (vsyncWorking && getPercentile(intervals, .5f) < MIN_VSYNC_REFRESHES * nominalMicros)
+            {
+                ofLogWarning("FramePacer") << "frames are coming faster than the display refreshes, vsync must be off in the driver so we'll sleep instead";
+                vsyncWorking = false;
+                nextDeadline = 0;
+            }
+
+            // monitors are often a little off their nominal rate, e.g. 59.94Hz,
+            // so when we have vsync we use the average of the frames that took
+            // one refresh, if most of them did, to keep our timing exact
+            refreshMicros = nominalMicros;
+            if (vsyncWorking)
+            {
+                float sum = 0.f;
+                unsigned count = 0;
+                for (unsigned i = 0; i < HISTORY_LENGTH; ++i)
+                {
+                    if (fabs(intervals[i] - nominalMicros) > .1f * nominalMicros) continue;
+                    sum += intervals[i];
+                    ++count;
+                }
+                if (count > HISTORY_LENGTH / 2) refreshMicros = sum / count;
+            }
+        }
+    }
+    lastFrameStart = refresh;
+
+    // in low latency mode we leave just enough time before the deadline for
+    // the frame to be drawn, going by how long recent frames have taken,
+    // without vsync we otherwise wait for our own refresh to come round
+    unsigned long long start = refresh;
+    if (lowLatency)
+    {
+        const float work = getPercentile(workTimes, WORK_PERCENTILE) + 1000.f * safetyMarginMillis;
+        start = work < deadline ? deadline - work : 0;
+    }
+    if (start > now) waitUntil(start);
+
+    workStart = ofGetElapsedTimeMicros();
+    lastWaitMicros = workStart - now;
+}
+
+void FramePacer::onDraw(ofEventArgs& args)
+{
+    if (HeadlessBenchmark::isRunning() || !workStart) return;
+
+    lastWorkMicros = ofGetElapsedTimeMicros() - workStart;
+    workTimes[historyIndex] = lastWorkMicros;
+}
+
+float FramePacer::detectRefreshRate()
+{
+#ifndef TARGET_OPENGLES
+    ofAppGLFWWindow* window = dynamic_cast<ofAppGLFWWindow*>(ofGetWindowPtr());
+    if (!window || !window->getGLFWWindow()) return 0.f;
+
+    // a window that's fullscreen on a monitor knows which one it's on, otherwise
+    // we find the monitor that the middle of the window is on
+    GLFWmonitor* monitor = glfwGetWindowMonitor(window->getGLFWWindow());
+    if (!monitor)
+    {
+        int x, y, width, height;
+        glfwGetWindowPos(window->getGLFWWindow(), &x, &y);
+        glfwGetWindowSize(window->getGLFWWindow(), &width, &height);
+        const ofVec2f centre(x + .5f * width, y + .5f * height);
+
+        int numMonitors = 0;
+        GLFWmonitor** monitors = glfwGetMonitors(&numMonitors);
+        for (int i = 0; i < numMonitors && !monitor; ++i)
+        {
+            const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
+            if (!mode) continue;
+            int monitorX, monitorY;
+            glfwGetMonitorPos(monitors[i], &monitorX, &monitorY);
+            if (ofRectangle(monitorX, monitorY, mode->width, mode->height).inside(centre)) monitor = monitors[i];
+        }
+        if (!monitor) monitor = glfwGetPrimaryMonitor();
+    }
+
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    if (mode && mode->refreshRate > 0) return mode->refreshRate;
+#endif
+    return 0.f;
+}
+
+void FramePacer::waitUntil(unsigned long long micros)
+{
+    // the os can oversleep by a millisecond or so, so we sleep
+    // until we're nearly there and then keep checking the time
+    for (;;)
+    {
+        const unsigned long long now = ofGetElapsedTimeMicros();
+        if (now >= micros) return;
+        if (micros - now > 2000) this_thread::sleep_for(chrono::microseconds(micros - now - 1500));
+        else this_thread::yield();
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ofMain.h"
+
+// paces frames to the display's refresh rather than to a fixed frame rate
+//
+// ofSetFrameRate(60) sleeps to hit 60fps by the clock, which isn't quite
+// when the display refreshes, on a 50Hz or 120Hz projector that means
+// frames get shown for an uneven number of refreshes and it judders, so
+// instead we turn on vsync and let swapping the buffers wait for the
+// refresh, if the driver ignores vsync we fall back to sleeping until the
+// next refresh ourselves
+//
+// in low latency mode we also wait at the start of each frame until just
+// before the next refresh, leaving only as long as recent frames have taken
+// plus a safety margin, so the audio and mouse that the frame is drawn from
+// are as fresh as they can be by the time it's on the screen
+//
+// every refresh that goes by without a new frame is counted so that we can
+// tell when a frame has missed its deadline, and we measure how long it is
+// from the start of each frame, when the app reads its input, to the
+// refresh that it's shown at so the two modes can be compared
+class FramePacer
+{
+public:
+    // how many frames the statistics are worked out over
+    static const unsigned HISTORY_LENGTH = 120;
+
+    FramePacer();
+    ~FramePacer();
+
+    // call this in setup() instead of ofSetFrameRate(), fallbackRefreshRate
+    // is used if we can't find out the display's refresh rate
+    void setup(float fallbackRefreshRate = 60.f);
+
+    // add these to the gui to turn low latency mode on and off and
+    // change how much time is left spare before the refresh
+    ofParameterGroup parameters;
+    ofParameter<bool> lowLatency;
+    ofParameter<float> safetyMarginMillis;
+
+    // the display's refresh rate, measured from the frames once we've seen enough of them
+    float getRefreshRate() const { return 1000000.f / refreshMicros; }
+
+    // false if the buffer swaps aren't waiting for the refresh and we're sleeping instead
+    bool isVsyncWorking() const { return vsyncWorking; }
+
+    unsigned long getNumFrames() const { return numFrames; }
+
+    // frames that took more than one refresh to arrive
+    unsigned long getNumMissedDeadlines() const { return numMissedDeadlines; }
+
+    // refreshes that showed the same frame again because the next one wasn't ready
+    unsigned long getNumRepeatedRefreshes() const { return numRepeatedRefreshes; }
+
+    // the mean and standard deviation of the time between frames
+    float getIntervalMillis() const;
+    float getIntervalJitterMillis() const;
+
+    // how long the app takes from the start of update() to the end of draw()
+    // and how long we waited before it in low latency mode, last frame only
+    float getLastWorkMillis() const { return lastWorkMicros / 1000.f; }
+    float getLastWaitMillis() const { return lastWaitMicros / 1000.f; }
+
+    // the median time from the start of update() to the refresh the frame
+    // was shown at, it's only exact in low latency mode, otherwise the
+    // driver can queue frames up and they're shown later than we can see
+    float getLatencyMillis() const;
+
+    void resetCounters();
+
+    // everything above on a few lines for drawing or logging
+    string getStatus() const;
+
+private:
+    void onUpdate(ofEventArgs& args);
+    void onDraw(ofEventArgs& args);
+
+    // the refresh rate of the monitor the window is on, or 0 if we can't tell
+    static float detectRefreshRate();
+
+    // sleep for most of the time and spin for the last bit as sleeping isn't precise
+    static void waitUntil(unsigned long long micros);
+
+    bool enabled;
+    float fallbackRefreshRate;
+    float detectedRefreshRate;
+    float refreshMicros;
+    bool vsyncWorking;
+
+    // when the last frame started, which is just after the refresh it was shown
+    // at, and without vsync when the next frame should have been drawn by
+    unsigned long long lastFrameStart;
+    unsigned long long nextDeadline;
+    unsigned long long workStart;
+
+    // the last HISTORY_LENGTH intervals between frames and how long each frame's work took
+    vector<float> intervals;
+    vector<float> workTimes;
+    vector<float> latencies;
+    unsigned historyIndex;
+
+    unsigned long numFrames;
+    unsigned long numMissedDeadlines;
+    unsigned long numRepeatedRefreshes;
+    unsigned long long lastWorkMicros;
+    unsigned long long lastWaitMicros;
+};
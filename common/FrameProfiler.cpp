@@ -0,0 +1,311 @@
+#include "FrameProfiler.h"
+
+FrameProfiler::TimedPass::TimedPass(FrameProfiler& profiler, unsigned stage, itg::RenderPass::Ptr pass) :
+    itg::RenderPass(ofVec2f(ofGetWidth(), ofGetHeight()), false, pass->getName()),
+    profiler(profiler),
+    stage(stage),
+    pass(pass)
+{
+    setEnabled(pass->getEnabled());
+}
+
+void FrameProfiler::TimedPass::render(ofFbo& readFbo, ofFbo& writeFbo)
+{
+    Scope scope(profiler, stage);
+    pass->render(readFbo, writeFbo);
+}
+
+void FrameProfiler::TimedPass::render(ofFbo& readFbo, ofFbo& writeFbo, ofTexture& depth)
+{
+    Scope scope(profiler, stage);
+    pass->render(readFbo, writeFbo, depth);
+}
+
+FrameProfiler::FrameProfiler() :
+    currentFrame(NULL),
+    frameNum(0),
+    gpuTimers(false),
+    historyIndex(0),
+    historySize(0)
+{
+    // the whole frame is always the first stage
+    addStage("frame");
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    stopCsv();
+#ifndef TARGET_OPENGLES
+    for (unsigned i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i)
+    {
+        if (!frames[i].queries.empty()) glDeleteQueries(frames[i].queries.size(), &frames[i].queries[0]);
+    }
+#endif
+}
+
+unsigned FrameProfiler::addStage(const string& name)
+{
+    stageNames.push_back(name);
+    stageStarts.push_back(0);
+    cpuHistory.push_back(vector<float>(HISTORY_LENGTH, 0.f));
+    gpuHistory.push_back(vector<float>(HISTORY_LENGTH, -1.f));
+    return stageNames.size() - 1;
+}
+
+void FrameProfiler::timePasses(ofxPostProcessing& postProcessing, const string& prefix)
+{
+    vector<itg::RenderPass::Ptr>& passes = postProcessing.getPasses();
+    for (unsigned i = 0; i < passes.size(); ++i)
+    {
+        // don't wrap a pass twice
+        if (dynamic_pointer_cast<TimedPass>(passes[i])) continue;
+
+        const unsigned stage = addStage(prefix + passes[i]->getName());
+        passes[i] = itg::RenderPass::Ptr(new TimedPass(*this, stage, passes[i]));
+    }
+}
+
+void FrameProfiler::setPassEnabled(ofxPostProcessing& postProcessing, itg::RenderPass::Ptr pass, bool enabled)
+{
+    pass->setEnabled(enabled);
+
+    vector<itg::RenderPass::Ptr>& passes = postProcessing.getPasses();
+    for (unsigned i = 0; i < passes.size(); ++i)
+    {
+        shared_ptr<TimedPass> timedPass = dynamic_pointer_cast<TimedPass>(passes[i]);
+        if (timedPass && timedPass->getPass() == pass) timedPass->setEnabled(enabled);
+    }
+}
+
+void FrameProfiler::beginFrame()
+{
+    // gpu timestamps need GL 3.3 or ARB_timer_query, if we don't have
+    // them then we just record the cpu times
+    if (!frameNum)
+    {
+#ifndef TARGET_OPENGLES
+        gpuTimers = GLEW_ARB_timer_query;
+#endif
+        if (!gpuTimers) ofLogWarning("FrameProfiler") << "timer queries aren't supported, only cpu times will be recorded";
+    }
+
+    // the frame that used this slot NUM_FRAMES_IN_FLIGHT frames ago should
+    // be finished by now so we can collect its times and reuse its queries
+    Frame& frame = frames[frameNum % NUM_FRAMES_IN_FLIGHT];
+    if (frame.pending) resolve(frame);
+
+    const unsigned numStages = stageNames.size();
+#ifndef TARGET_OPENGLES
+    if (gpuTimers && frame.queries.size() < 2 * numStages)
+    {
+        const unsigned numExisting = frame.queries.size();
+        frame.queries.resize(2 * numStages);
+        glGenQueries(frame.queries.size() - numExisting, &frame.queries[numExisting]);
+    }
+#endif
+    frame.issued.assign(numStages, false);
+    frame.cpuMillis.assign(numStages, 0.f);
+    frame.frameNum = frameNum;
+    frame.pending = true;
+    currentFrame = &frame;
+
+    begin(0);
+}
+
+void FrameProfiler::endFrame()
+{
+    end(0);
+    currentFrame = NULL;
+    ++frameNum;
+}
+
+void FrameProfiler::begin(unsigned stage)
+{
+    if (!currentFrame || stage >= currentFrame->issued.size()) return;
+
+#ifndef TARGET_OPENGLES
+    if (gpuTimers) glQueryCounter(currentFrame->queries[2 * stage], GL_TIMESTAMP);
+#endif
+    stageStarts[stage] = ofGetElapsedTimeMicros();
+}
+
+void FrameProfiler::end(unsigned stage)
+{
+    if (!currentFrame || stage >= currentFrame->issued.size()) return;
+
+    currentFrame->cpuMillis[stage] = (ofGetElapsedTimeMicros() - stageStarts[stage]) / 1000.f;
+#ifndef TARGET_OPENGLES
+    if (gpuTimers) glQueryCounter(currentFrame->queries[2 * stage + 1], GL_TIMESTAMP);
+#endif
+    currentFrame->issued[stage] = true;
+}
+
+void FrameProfiler::resolve(Frame& frame)
+{
+    frame.pending = false;
+
+    const bool writeCsv = csvFile.is_open();
+    if (writeCsv) csvBuffer += ofToString(frame.frameNum);
+
+    for (unsigned i = 0; i < frame.issued.size(); ++i)
+    {
+        float gpuMillis = -1.f;
+#ifndef TARGET_OPENGLES
+        if (gpuTimers && frame.issued[i])
+        {
+            // if the gpu still hasn't got to the end of the stage we'd have
+            // to wait for it, so we skip this one rather than stall
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queries[2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint64 start, end;
+                glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+                gpuMillis = (end - start) / 1000000.f;
+            }
+        }
+#endif
+        cpuHistory[i][historyIndex] = frame.cpuMillis[i];
+        gpuHistory[i][historyIndex] = gpuMillis;
+
+        if (writeCsv)
+        {
+            csvBuffer += "," + ofToString(frame.cpuMillis[i], 3) + ",";
+            if (gpuMillis >= 0.f) csvBuffer += ofToString(gpuMillis, 3);
+        }
+    }
+
+    historyIndex = (historyIndex + 1) % HISTORY_LENGTH;
+    historySize = min(historySize + 1, HISTORY_LENGTH);
+
+    if (writeCsv)
+    {
+        csvBuffer += "\n";
+        if (csvBuffer.size() > 64 * 1024) flushCsv();
+    }
+}
+
+void FrameProfiler::draw(float x, float y)
+{
+    const float lineHeight = 14.f;
+    const float barX = x + 340.f;
+    const float barWidth = 200.f;
+    const float budgetMillis = 1000.f / 60.f;
+
+    ofPushStyle();
+    ofFill();
+
+    // a dark background so the text is readable whatever is behind it
+    ofSetColor(0, 200);
+    ofDrawRectangle(x - 5.f, y - lineHeight, barX - x + barWidth + 10.f, lineHeight * (stageNames.size() + 1) + 10.f);
+
+    ofSetColor(255);
+    ofDrawBitmapString("stage                cpu avg/max    gpu avg/max", x, y);
+
+    for (unsigned i = 0; i < stageNames.size(); ++i)
+    {
+        float cpuAverage = 0.f, cpuMax = 0.f, gpuAverage = 0.f, gpuMax = 0.f;
+        getStats(cpuHistory[i], cpuAverage, cpuMax);
+        const bool haveGpu = getStats(gpuHistory[i], gpuAverage, gpuMax);
+
+        string line = stageNames[i];
+        line.resize(20, ' ');
+        line += ofToString(cpuAverage, 2, 6, ' ') + "/" + ofToString(cpuMax, 2, 6, ' ');
+        if (haveGpu) line += "  " + ofToString(gpuAverage, 2, 6, ' ') + "/" + ofToString(gpuMax, 2, 6, ' ');
+        else line += "       n/a";
+
+        const float lineY = y + lineHeight * (i + 1);
+        ofSetColor(255);
+        ofDrawBitmapString(line, x, lineY);
+
+        // the bars show the cpu time in blue and the gpu time in orange
+        // as a proportion of the time we have for a frame at 60fps
+        ofSetColor(80, 160, 255);
+        ofDrawRectangle(barX, lineY - 10.f, barWidth * min(1.f, cpuAverage / budgetMillis), 4.f);
+        ofSetColor(255, 160, 40);
+        ofDrawRectangle(barX, lineY - 5.f, barWidth * min(1.f, gpuAverage / budgetMillis), 4.f);
+    }
+
+    if (isWritingCsv())
+    {
+        ofSetColor(255, 0, 0);
+        ofDrawBitmapString("writing " + csvPath, x, y + lineHeight * (stageNames.size() + 2));
+    }
+
+    ofPopStyle();
+}
+
+float FrameProfiler::getAverageMillis(unsigned stage) const
+{
+    if (stage >= stageNames.size()) return 0.f;
+
+    float average = 0.f, maximum = 0.f;
+    if (getStats(gpuHistory[stage], average, maximum)) return average;
+    getStats(cpuHistory[stage], average, maximum);
+    return average;
+}
+
+void FrameProfiler::clearHistory()
+{
+    for (unsigned i = 0; i < stageNames.size(); ++i)
+    {
+        cpuHistory[i].assign(HISTORY_LENGTH, 0.f);
+        gpuHistory[i].assign(HISTORY_LENGTH, -1.f);
+    }
+    historyIndex = 0;
+    historySize = 0;
+}
+
+bool FrameProfiler::getStats(const vector<float>& history, float& average, float& maximum) const
+{
+    float total = 0.f;
+    unsigned numTimes = 0;
+    maximum = 0.f;
+    for (unsigned i = 0; i < historySize; ++i)
+    {
+        if (history[i] < 0.f) continue;
+        total += history[i];
+        maximum = max(maximum, history[i]);
+        ++numTimes;
+    }
+    average = numTimes ? total / numTimes : 0.f;
+    return numTimes > 0;
+}
+
+bool FrameProfiler::startCsv(const string& path)
+{
+    stopCsv();
+
+    csvPath = path;
+    csvFile.open(ofToDataPath(path, true).c_str(), ios::trunc);
+    if (!csvFile)
+    {
+        ofLogError("FrameProfiler") << "couldn't open " << path;
+        return false;
+    }
+
+    csvBuffer = "frame";
+    for (unsigned i = 0; i < stageNames.size(); ++i)
+    {
+        const string name = ofTrim(stageNames[i]);
+        csvBuffer += "," + name + "_cpu_ms," + name + "_gpu_ms";
+    }
+    csvBuffer += "\n";
+    return true;
+}
+
+void FrameProfiler::stopCsv()
+{
+    if (!csvFile.is_open()) return;
+
+    flushCsv();
+    csvFile.close();
+    ofLogNotice("FrameProfiler") << "wrote " << csvPath;
+}
+
+void FrameProfiler::flushCsv()
+{
+    csvFile.write(csvBuffer.c_str(), csvBuffer.size());
+    csvBuffer.clear();
+}
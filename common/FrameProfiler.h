@@ -0,0 +1,144 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxPostProcessing.h"
+
+// times each stage of a frame, both how long the cpu spends on it and how
+// long the gpu spends on it, so that we can see where the frame time goes
+//
+// cpu times are simple, we just look at the clock, gpu times are trickier
+// because the gpu runs behind the cpu, we put timestamp queries into the
+// command stream around each stage and read them back a few frames later
+// when the gpu has got round to them so that we never wait for it
+//
+// a rolling average of the last few seconds can be drawn over the app and
+// every frame can be written out to a csv file to look at afterwards
+class FrameProfiler
+{
+public:
+    // how many frames we wait before reading back the gpu timestamps
+    static const unsigned NUM_FRAMES_IN_FLIGHT = 4;
+
+    // how many frames the overlay averages over
+    static const unsigned HISTORY_LENGTH = 120;
+
+    // times a stage from when it's created until it goes out of scope
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler& profiler, unsigned stage) : profiler(profiler), stage(stage) { profiler.begin(stage); }
+        ~Scope() { profiler.end(stage); }
+
+    private:
+        FrameProfiler& profiler;
+        unsigned stage;
+    };
+
+    // stands in for a post processing pass so that it's timed every time it renders
+    class TimedPass : public itg::RenderPass
+    {
+    public:
+        TimedPass(FrameProfiler& profiler, unsigned stage, itg::RenderPass::Ptr pass);
+
+        void render(ofFbo& readFbo, ofFbo& writeFbo);
+        void render(ofFbo& readFbo, ofFbo& writeFbo, ofTexture& depth);
+        bool hasArbShader() { return pass->hasArbShader(); }
+
+        itg::RenderPass::Ptr getPass() { return pass; }
+
+    private:
+        FrameProfiler& profiler;
+        unsigned stage;
+        itg::RenderPass::Ptr pass;
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    // add a stage to be timed, the number returned is what is passed to
+    // begin() and end(), add all of the stages before the first frame
+    unsigned addStage(const string& name);
+
+    // swap every pass in the chain for a TimedPass, each pass gets its
+    // own stage named after it with prefix in front, e.g. to indent them
+    // in the overlay, call this after all of the passes have been created
+    void timePasses(ofxPostProcessing& postProcessing, const string& prefix = "");
+
+    // once a pass is being timed ofxPostProcessing only sees its TimedPass,
+    // so turn passes on and off with this rather than on the pass itself
+    static void setPassEnabled(ofxPostProcessing& postProcessing, itg::RenderPass::Ptr pass, bool enabled);
+
+    // call these at the start and end of ofApp::draw(), the time in
+    // between them is recorded as the "frame" stage
+    void beginFrame();
+    void endFrame();
+
+    // each stage should only be timed once a frame
+    void begin(unsigned stage);
+    void end(unsigned stage);
+
+    // draw the average and worst times of each stage over the last
+    // HISTORY_LENGTH frames with a bar showing how much of a 60fps frame it takes
+    void draw(float x, float y);
+
+    // the average time of a stage over the last HISTORY_LENGTH frames,
+    // this is the gpu time if we have it and the cpu time if we don't
+    float getAverageMillis(unsigned stage) const;
+
+    // forget the times so far, e.g. after changing a setting so
+    // the averages only include frames drawn with the new setting
+    void clearHistory();
+
+    // write a row for every frame from now on to a csv file
+    bool startCsv(const string& path);
+    void stopCsv();
+    bool isWritingCsv() const { return csvFile.is_open(); }
+
+    bool hasGpuTimers() const { return gpuTimers; }
+
+private:
+    // everything we record about one frame until we can read
+    // its gpu timestamps back, there are NUM_FRAMES_IN_FLIGHT of these
+    struct Frame
+    {
+        Frame() : pending(false), frameNum(0) {}
+
+        bool pending;
+        unsigned long frameNum;
+
+        // two queries per stage, one at the start and one at the end
+        vector<GLuint> queries;
+        vector<bool> issued;
+        vector<float> cpuMillis;
+    };
+
+    // read back the gpu times for a frame and add it to the history
+    void resolve(Frame& frame);
+
+    // the average and maximum of the valid times in a history,
+    // returns false if there weren't any
+    bool getStats(const vector<float>& history, float& average, float& maximum) const;
+
+    void flushCsv();
+
+    vector<string> stageNames;
+    vector<unsigned long long> stageStarts;
+
+    Frame frames[NUM_FRAMES_IN_FLIGHT];
+    Frame* currentFrame;
+    unsigned long frameNum;
+    bool gpuTimers;
+
+    // the last HISTORY_LENGTH times for each stage, a gpu time
+    // of less than zero means we didn't get one for that frame
+    vector<vector<float> > cpuHistory;
+    vector<vector<float> > gpuHistory;
+    unsigned historyIndex;
+    unsigned historySize;
+
+    // rows are collected here and written out in big chunks
+    // rather than going to the disk every frame
+    ofstream csvFile;
+    string csvPath;
+    string csvBuffer;
+};
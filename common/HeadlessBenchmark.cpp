@@ -0,0 +1,217 @@
+#include "HeadlessBenchmark.h"
+
+#ifndef TARGET_OPENGLES
+    #include "ofAppGLFWWindow.h"
+#endif
+#ifndef TARGET_WIN32
+    #include <time.h>
+#endif
+
+HeadlessBenchmark* HeadlessBenchmark::current = NULL;
+
+HeadlessBenchmark::Settings::Settings() :
+    numFrames(600),
+    numWarmupFrames(30),
+    width(1920),
+    height(1080),
+    fps(60.f),
+    outputPath("benchmark.json")
+{
+}
+
+bool HeadlessBenchmark::Settings::parse(int argc, char* argv[])
+{
+    bool benchmark = false;
+    if (argc > 0) appName = ofFilePath::getBaseName(argv[0]);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--benchmark") benchmark = true;
+        else if (argument == "--frames" && hasValue) numFrames = ofToInt(argv[++i]);
+        else if (argument == "--warmup" && hasValue) numWarmupFrames = ofToInt(argv[++i]);
+        else if (argument == "--width" && hasValue) width = ofToInt(argv[++i]);
+        else if (argument == "--height" && hasValue) height = ofToInt(argv[++i]);
+        else if (argument == "--fps" && hasValue) fps = ofToFloat(argv[++i]);
+        else if (argument == "--output" && hasValue) outputPath = argv[++i];
+    }
+
+    numFrames = max(1u, numFrames);
+    fps = max(1.f, fps);
+    return benchmark;
+}
+
+int HeadlessBenchmark::run(ofBaseApp* app, const Settings& settings)
+{
+    // a hidden window gives us a gl context to draw into without anything
+    // appearing on screen, the size of the window is the resolution we render at
+#ifndef TARGET_OPENGLES
+    ofGLFWWindowSettings windowSettings;
+    windowSettings.visible = false;
+#else
+    ofGLESWindowSettings windowSettings;
+#endif
+    windowSettings.width = settings.width;
+    windowSettings.height = settings.height;
+    windowSettings.windowMode = OF_WINDOW;
+    ofCreateWindow(windowSettings);
+
+    HeadlessBenchmark benchmark(settings);
+    current = &benchmark;
+    const int result = ofRunApp(app);
+    current = NULL;
+    return result;
+}
+
+HeadlessBenchmark::HeadlessBenchmark(const Settings& settings) :
+    settings(settings),
+    frameNum(0),
+    frameStart(0),
+    phaseStart(0),
+    phaseCpuStart(0)
+{
+    // listen before and after the app so that we can time what it does
+    ofAddListener(ofEvents().setup, this, &HeadlessBenchmark::onSetup, OF_EVENT_ORDER_AFTER_APP);
+    ofAddListener(ofEvents().update, this, &HeadlessBenchmark::onUpdateBegin, OF_EVENT_ORDER_BEFORE_APP);
+    ofAddListener(ofEvents().update, this, &HeadlessBenchmark::onUpdateEnd, OF_EVENT_ORDER_AFTER_APP);
+    ofAddListener(ofEvents().draw, this, &HeadlessBenchmark::onDrawBegin, OF_EVENT_ORDER_BEFORE_APP);
+    ofAddListener(ofEvents().draw, this, &HeadlessBenchmark::onDrawEnd, OF_EVENT_ORDER_AFTER_APP);
+
+    const unsigned numFrames = settings.numFrames + settings.numWarmupFrames;
+    frameMillis.reserve(numFrames);
+    updateMillis.reserve(numFrames);
+    updateCpuMillis.reserve(numFrames);
+    drawMillis.reserve(numFrames);
+    drawCpuMillis.reserve(numFrames);
+}
+
+HeadlessBenchmark::~HeadlessBenchmark()
+{
+    ofRemoveListener(ofEvents().setup, this, &HeadlessBenchmark::onSetup, OF_EVENT_ORDER_AFTER_APP);
+    ofRemoveListener(ofEvents().update, this, &HeadlessBenchmark::onUpdateBegin, OF_EVENT_ORDER_BEFORE_APP);
+    ofRemoveListener(ofEvents().update, this, &HeadlessBenchmark::onUpdateEnd, OF_EVENT_ORDER_AFTER_APP);
+    ofRemoveListener(ofEvents().draw, this, &HeadlessBenchmark::onDrawBegin, OF_EVENT_ORDER_BEFORE_APP);
+    ofRemoveListener(ofEvents().draw, this, &HeadlessBenchmark::onDrawEnd, OF_EVENT_ORDER_AFTER_APP);
+}
+
+float HeadlessBenchmark::getElapsedTimef()
+{
+    if (current) return current->frameNum / current->settings.fps;
+    return ofGetElapsedTimef();
+}
+
+unsigned HeadlessBenchmark::getFrameNum()
+{
+    if (current) return current->frameNum;
+    return ofGetFrameNum();
+}
+
+void HeadlessBenchmark::setLastFrameListener(function<void()> listener)
+{
+    if (current) current->lastFrameListener = listener;
+}
+
+void HeadlessBenchmark::onSetup(ofEventArgs& args)
+{
+    // the apps ask for 60fps in setup(), we want to go as fast as we can
+    ofSetFrameRate(0);
+    ofSetVerticalSync(false);
+}
+
+void HeadlessBenchmark::onUpdateBegin(ofEventArgs& args)
+{
+    // a frame runs from the start of one update to the start of the next,
+    // so this includes swapping the buffers and everything else oF does
+    const unsigned long long now = ofGetElapsedTimeMicros();
+    if (frameStart) frameMillis.push_back((now - frameStart) / 1000.f);
+    frameStart = now;
+
+    if (frameMillis.size() == settings.numFrames + settings.numWarmupFrames)
+    {
+        writeResults();
+        ofExit(0);
+    }
+
+    phaseStart = now;
+    phaseCpuStart = getCpuMicros();
+}
+
+void HeadlessBenchmark::onUpdateEnd(ofEventArgs& args)
+{
+    updateMillis.push_back((ofGetElapsedTimeMicros() - phaseStart) / 1000.f);
+    updateCpuMillis.push_back((getCpuMicros() - phaseCpuStart) / 1000.f);
+}
+
+void HeadlessBenchmark::onDrawBegin(ofEventArgs& args)
+{
+    phaseStart = ofGetElapsedTimeMicros();
+    phaseCpuStart = getCpuMicros();
+}
+
+void HeadlessBenchmark::onDrawEnd(ofEventArgs& args)
+{
+    // wait for the gpu to finish so that the draw time includes the
+    // rendering and not just the time taken to send the commands
+    glFinish();
+    drawMillis.push_back((ofGetElapsedTimeMicros() - phaseStart) / 1000.f);
+    drawCpuMillis.push_back((getCpuMicros() - phaseCpuStart) / 1000.f);
+
+    // this is after the timing so whatever the app does doesn't count
+    if (lastFrameListener && frameNum + 1 == settings.numFrames + settings.numWarmupFrames) lastFrameListener();
+    ++frameNum;
+}
+
+unsigned long long HeadlessBenchmark::getCpuMicros()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec * 1000000ull + time.tv_nsec / 1000;
+#else
+    return 1000000ull * clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// min, median, 99th percentile and mean of everything after the warm up frames
+static string summarise(vector<float> values, unsigned numWarmupFrames)
+{
+    values.erase(values.begin(), values.begin() + min<size_t>(numWarmupFrames, values.size()));
+    if (values.empty()) return "null";
+    sort(values.begin(), values.end());
+
+    float sum = 0.f;
+    for (unsigned i = 0; i < values.size(); ++i) sum += values[i];
+
+    stringstream json;
+    json << "{ \"min\": " << values.front()
+         << ", \"median\": " << values[values.size() / 2]
+         << ", \"p99\": " << values[min<size_t>(values.size() - 1, floor(.99 * values.size()))]
+         << ", \"max\": " << values.back()
+         << ", \"mean\": " << sum / values.size() << " }";
+    return json.str();
+}
+
+void HeadlessBenchmark::writeResults()
+{
+    stringstream json;
+    json << "{" << endl
+         << "    \"app\": \"" << settings.appName << "\"," << endl
+         << "    \"width\": " << ofGetWidth() << "," << endl
+         << "    \"height\": " << ofGetHeight() << "," << endl
+         << "    \"frames\": " << settings.numFrames << "," << endl
+         << "    \"warmupFrames\": " << settings.numWarmupFrames << "," << endl
+         << "    \"renderer\": \"" << (const char*)glGetString(GL_RENDERER) << "\"," << endl
+         << "    \"frameMillis\": " << summarise(frameMillis, settings.numWarmupFrames) << "," << endl
+         << "    \"updateMillis\": " << summarise(updateMillis, settings.numWarmupFrames) << "," << endl
+         << "    \"updateCpuMillis\": " << summarise(updateCpuMillis, settings.numWarmupFrames) << "," << endl
+         << "    \"drawMillis\": " << summarise(drawMillis, settings.numWarmupFrames) << "," << endl
+         << "    \"drawCpuMillis\": " << summarise(drawCpuMillis, settings.numWarmupFrames) << endl
+         << "}" << endl;
+
+    ofBuffer buffer;
+    buffer.set(json.str());
+    ofBufferToFile(settings.outputPath, buffer);
+    ofLogNotice("HeadlessBenchmark") << "wrote " << settings.outputPath << endl << json.str();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"
+
+// runs an app for a fixed number of frames in a hidden window and writes
+// out how long the frames took, so that we can profile the apps on
+// machines without a screen, e.g. a build server using mesa's software
+// renderer (LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./app --benchmark)
+//
+// the app is run as fast as it will go and time is faked so that every
+// frame is 1 / fps seconds after the last one, this makes animations come
+// out the same from run to run however long each frame takes
+class HeadlessBenchmark
+{
+public:
+    struct Settings
+    {
+        Settings();
+
+        // reads --benchmark, --frames, --warmup, --width, --height, --fps
+        // and --output from the command line, returns true if --benchmark
+        // was one of the arguments
+        bool parse(int argc, char* argv[]);
+
+        string appName;
+        unsigned numFrames;
+        unsigned numWarmupFrames;
+        unsigned width;
+        unsigned height;
+        float fps;
+        string outputPath;
+    };
+
+    // opens a hidden window, runs the app and writes the results, this
+    // doesn't return until the benchmark has finished
+    static int run(ofBaseApp* app, const Settings& settings);
+
+    // use this instead of ofGetElapsedTimef() for anything that animates,
+    // when benchmarking it's the fake time, otherwise it's the real time
+    static float getElapsedTimef();
+
+    // the frame number in benchmark mode, ofGetFrameNum() otherwise
+    static unsigned getFrameNum();
+
+    static bool isRunning() { return current != NULL; }
+
+    // called once the last frame has been drawn and timed while it's still
+    // in the window, e.g. to save what it looks like, call this from setup()
+    static void setLastFrameListener(function<void()> listener);
+
+private:
+    HeadlessBenchmark(const Settings& settings);
+    ~HeadlessBenchmark();
+
+    void onSetup(ofEventArgs& args);
+    void onUpdateBegin(ofEventArgs& args);
+    void onUpdateEnd(ofEventArgs& args);
+    void onDrawBegin(ofEventArgs& args);
+    void onDrawEnd(ofEventArgs& args);
+
+    void writeResults();
+
+    // wall clock and render thread cpu time in microseconds
+    static unsigned long long getCpuMicros();
+
+    static HeadlessBenchmark* current;
+
+    Settings settings;
+    unsigned frameNum;
+
+    unsigned long long frameStart;
+    unsigned long long phaseStart;
+    unsigned long long phaseCpuStart;
+
+    function<void()> lastFrameListener;
+
+    vector<float> frameMillis;
+    vector<float> updateMillis;
+    vector<float> updateCpuMillis;
+    vector<float> drawMillis;
+    vector<float> drawCpuMillis;
+};
@@ -0,0 +1,314 @@
+#include "HotReloader.h"
+
+#include <sys/stat.h>
+#ifdef TARGET_LINUX
+    #include <sys/inotify.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    // how often we look for changes when we can't be told about them
+    const unsigned POLL_MILLIS = 500;
+
+    // swapping the arrays is all it takes to swap two meshes, getting them
+    // through the non const accessors marks them as changed so a vbo mesh
+    // uploads the new ones the next time it's drawn
+    void swapMeshes(ofMesh& a, ofMesh& b)
+    {
+        a.getVertices().swap(b.getVertices());
+        a.getNormals().swap(b.getNormals());
+        a.getColors().swap(b.getColors());
+        a.getTexCoords().swap(b.getTexCoords());
+        a.getIndices().swap(b.getIndices());
+
+        const ofPrimitiveMode mode = a.getMode();
+        a.setMode(b.getMode());
+        b.setMode(mode);
+    }
+}
+
+HotReloader::File::File() :
+    parameters(NULL),
+    mesh(NULL),
+    lastHash(0),
+    lastModified(0),
+    pending(false),
+    pendingHash(0),
+    savedHash(0)
+{
+}
+
+HotReloader::HotReloader() :
+    listening(false),
+    numReloads(0),
+    numFailures(0)
+{
+}
+
+HotReloader::~HotReloader()
+{
+    close();
+}
+
+void HotReloader::addSettings(ofAbstractParameter& parameters, const string& path)
+{
+    File file;
+    file.path = path;
+    file.parameters = &parameters;
+    files.push_back(file);
+}
+
+void HotReloader::addMesh(ofMesh& mesh, const string& path)
+{
+    File file;
+    file.path = path;
+    file.mesh = &mesh;
+    files.push_back(file);
+}
+
+void HotReloader::setup()
+{
+    for (File& file : files)
+    {
+        file.absolutePath = ofToDataPath(file.path, true);
+        file.lastHash = hashFile(file.absolutePath);
+        file.lastModified = getModifiedTime(file.absolutePath);
+    }
+
+    if (!listening)
+    {
+        ofAddListener(ofEvents().update, this, &HotReloader::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+        listening = true;
+    }
+    startThread();
+}
+
+void HotReloader::close()
+{
+    if (isThreadRunning()) waitForThread(true);
+    if (listening)
+    {
+        ofRemoveListener(ofEvents().update, this, &HotReloader::onUpdate, OF_EVENT_ORDER_BEFORE_APP);
+        listening = false;
+    }
+}
+
+void HotReloader::fileSaved(const string& path)
+{
+    const uint64_t hash = hashFile(ofToDataPath(path, true));
+    lock_guard<std::mutex> lock(pendingMutex);
+    for (File& file : files)
+    {
+        if (file.path != path) continue;
+        file.savedHash = hash;
+
+        // the thread might have beaten us to it and already loaded what we
+        // saved, it can't have been swapped in yet as that's on this thread
+        if (file.pending && file.pendingHash == hash)
+        {
+            file.pending = false;
+            file.pendingSettings.reset();
+        }
+    }
+}
+
+void HotReloader::threadedFunction()
+{
+    if (watchWithInotify()) return;
+    watchByPolling();
+}
+
+bool HotReloader::watchWithInotify()
+{
+#ifdef TARGET_LINUX
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        ofLogWarning("HotReloader") << "couldn't start inotify, looking for changes every " << POLL_MILLIS << "ms instead";
+        return false;
+    }
+
+    // we watch the directories rather than the files because most editors
+    // save by writing a new file and moving it over the old one, which would
+    // leave a watch on the old file watching nothing, we're told when a
+    // file that was open for writing is closed or one is moved in
+    map<int, string> directories;
+    for (const File& file : files)
+    {
+        const string directory = ofFilePath::addTrailingSlash(ofFilePath::getEnclosingDirectory(file.absolutePath, false));
+        const int watch = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0)
+        {
+            ofLogWarning("HotReloader") << "couldn't watch " << directory << ", looking for changes every " << POLL_MILLIS << "ms instead";
+            ::close(fd);
+            return false;
+        }
+        directories[watch] = directory;
+    }
+
+    // the events are variable length so they're read into a buffer that's
+    // lined up for the first one and walked through one at a time
+    alignas(inotify_event) char buffer[4096];
+    while (isThreadRunning())
+    {
+        // wake up every so often to see if we've been stopped
+        pollfd poller = { fd, POLLIN, 0 };
+        if (poll(&poller, 1, 100) <= 0) continue;
+
+        vector<bool> changed(files.size(), false);
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* event = buffer; event < buffer + length; event += sizeof(inotify_event) + ((inotify_event*)event)->len)
+            {
+                const inotify_event* info = (const inotify_event*)event;
+                if (!info->len) continue;
+                const string path = directories[info->wd] + info->name;
+                for (unsigned i = 0; i < files.size(); ++i)
+                {
+                    if (files[i].absolutePath == path) changed[i] = true;
+                }
+            }
+        }
+
+        // an editor can write the same file several times in one go so we
+        // only load each of them once for everything we've been told about
+        for (unsigned i = 0; i < files.size(); ++i)
+        {
+            if (changed[i]) load(files[i]);
+        }
+    }
+
+    ::close(fd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HotReloader::watchByPolling()
+{
+    while (isThreadRunning())
+    {
+        for (File& file : files)
+        {
+            const long long modified = getModifiedTime(file.absolutePath);
+            if (modified == file.lastModified) continue;
+            file.lastModified = modified;
+            load(file);
+        }
+        sleep(POLL_MILLIS);
+    }
+}
+
+void HotReloader::load(File& file)
+{
+    // nothing to do if it's been saved without being changed
+    const uint64_t hash = hashFile(file.absolutePath);
+    if (!hash || hash == file.lastHash) return;
+
+    // or if it's what the app has just saved itself, which it already has
+    {
+        lock_guard<std::mutex> lock(pendingMutex);
+        if (hash == file.savedHash)
+        {
+            file.lastHash = hash;
+            return;
+        }
+    }
+
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    shared_ptr<ofXml> settings;
+    ofMesh mesh;
+    if (file.parameters)
+    {
+        settings = make_shared<ofXml>();
+        if (!settings->load(file.absolutePath))
+        {
+            ofLogWarning("HotReloader") << "couldn't parse " << file.path << ", keeping the settings we have";
+            ++numFailures;
+            return;
+        }
+    }
+    else
+    {
+        mesh.load(file.absolutePath);
+        if (!mesh.getNumVertices())
+        {
+            ofLogWarning("HotReloader") << "couldn't load " << file.path << ", keeping the mesh we have";
+            ++numFailures;
+            return;
+        }
+    }
+    file.lastHash = hash;
+    ofLogNotice("HotReloader") << "loaded " << file.path << " in " << (ofGetElapsedTimeMicros() - start) / 1000.f << "ms";
+
+    // hand it over, if there was something already waiting that hadn't
+    // been swapped in yet then it's replaced, either way whatever was in
+    // the second copy ends up here and is freed on this thread, unless the
+    // app has saved the same thing itself while we were loading it
+    lock_guard<std::mutex> lock(pendingMutex);
+    if (hash == file.savedHash) return;
+    file.pendingHash = hash;
+    settings.swap(file.pendingSettings);
+    swapMeshes(mesh, file.pendingMesh);
+    file.pending = true;
+}
+
+void HotReloader::onUpdate(ofEventArgs& args)
+{
+    // never wait for the thread, if it's busy handing
+    // something over then it can wait until next frame
+    unique_lock<std::mutex> lock(pendingMutex, try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    // take everything that's waiting in one go so it all changes in the same frame
+    vector<pair<unsigned, shared_ptr<ofXml> > > swapped;
+    for (unsigned i = 0; i < files.size(); ++i)
+    {
+        File& file = files[i];
+        if (!file.pending) continue;
+        file.pending = false;
+
+        swapped.push_back(make_pair(i, shared_ptr<ofXml>()));
+        if (file.parameters) swapped.back().second.swap(file.pendingSettings);
+        else swapMeshes(*file.mesh, file.pendingMesh);
+    }
+    lock.unlock();
+
+    // setting the parameters calls their listeners so
+    // it's done once we've let go of the thread
+    for (unsigned i = 0; i < swapped.size(); ++i)
+    {
+        const File& file = files[swapped[i].first];
+        if (swapped[i].second) swapped[i].second->deserialize(*file.parameters);
+        ++numReloads;
+        if (listener) listener(file.path);
+    }
+}
+
+uint64_t HotReloader::hashFile(const string& absolutePath)
+{
+    // 64 bit fnv-1a, 0 means the file isn't there or is empty
+    ofBuffer buffer = ofBufferFromFile(absolutePath, true);
+    if (!buffer.size()) return 0;
+
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* data = (const unsigned char*)buffer.getData();
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+long long HotReloader::getModifiedTime(const string& absolutePath)
+{
+    // the size changing counts too as the time is often only to the second
+    struct stat info;
+    if (stat(absolutePath.c_str(), &info)) return 0;
+    return (long long)info.st_mtime * 1000000000ll + info.st_size;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ofMain.h"
+
+// picks up changes to the settings and the meshes while the app is running
+//
+// restarting to load a changed settings.xml or ply file means seconds of
+// black screen, which is no good in the middle of a show, so instead this
+// object's own thread watches the files, with inotify on linux and by
+// looking at when they were last modified everywhere else, and loads and
+// parses them as soon as they've been written
+//
+// what it loads is held in a second copy and swapped in all at once at the
+// start of the next frame, before update(), the swap is only of pointers and
+// arrays so the render thread never waits for the disk or the parsing, and
+// if the thread is busy handing something over we just pick it up next frame
+class HotReloader : public ofThread
+{
+public:
+    // called on the render thread just after a file has been swapped in,
+    // with the path it was added with, so the app can catch up with it
+    typedef function<void(const string& path)> Listener;
+
+    HotReloader();
+    ~HotReloader();
+
+    // load parameters from an xml file like the ones the gui saves,
+    // e.g. gui.getParameter() and "settings.xml"
+    void addSettings(ofAbstractParameter& parameters, const string& path);
+
+    // load a mesh from a ply file
+    void addMesh(ofMesh& mesh, const string& path);
+
+    void setListener(Listener listener) { this->listener = listener; }
+
+    // add the files before calling this, they're taken to be as they are
+    // on disk now so only changes from here on are loaded
+    void setup();
+
+    // stop watching and wait for the thread to finish, call this before the
+    // app saves any of the files itself on exit so we don't load them back in
+    void close();
+
+    // call this on the render thread straight after the app has written one
+    // of the files itself while we're watching, e.g. from the gui's save
+    // button, so that we don't load it back in and set everything again
+    void fileSaved(const string& path);
+
+    unsigned getNumReloads() const { return numReloads; }
+    unsigned getNumFailures() const { return numFailures; }
+
+private:
+    struct File
+    {
+        File();
+
+        string path;
+        string absolutePath;
+        ofAbstractParameter* parameters;
+        ofMesh* mesh;
+
+        // a hash of what was last loaded so that saving the same thing
+        // again, e.g. from the gui, doesn't reload it, and for polling when
+        // the file was last modified, these are only touched by the thread
+        uint64_t lastHash;
+        long long lastModified;
+
+        // loaded and waiting to be swapped in, and the hash of what the
+        // app last saved itself, guarded by pendingMutex
+        bool pending;
+        uint64_t pendingHash;
+        shared_ptr<ofXml> pendingSettings;
+        ofMesh pendingMesh;
+        uint64_t savedHash;
+    };
+
+    void threadedFunction();
+
+    // wait for changes with inotify, returns false if it isn't available
+    bool watchWithInotify();
+    void watchByPolling();
+
+    // load a file that has changed and hand it over to the render thread
+    void load(File& file);
+
+    // swap in anything that has been loaded
+    void onUpdate(ofEventArgs& args);
+
+    static uint64_t hashFile(const string& absolutePath);
+    static long long getModifiedTime(const string& absolutePath);
+
+    vector<File> files;
+    Listener listener;
+    bool listening;
+
+    std::mutex pendingMutex;
+
+    unsigned numReloads;
+    atomic<unsigned> numFailures;
+};
@@ -0,0 +1,296 @@
+#include "MipBloomPass.h"
+
+namespace
+{
+    // the image coming into the pass is a rectangle texture when the post
+    // processing was set up with arb, it's read with source() which takes
+    // coordinates from 0 to 1 either way, our own levels are always 2d
+    const string SOURCE_HEADER = R"(
+        #ifdef ARB
+            #extension GL_ARB_texture_rectangle : enable
+            uniform sampler2DRect tex;
+            uniform vec2 texSize;
+            vec4 source(vec2 uv) { return texture2DRect(tex, uv * texSize); }
+        #else
+            uniform sampler2D tex;
+            vec4 source(vec2 uv) { return texture2D(tex, uv); }
+        #endif
+    )";
+
+    // averages a 4x4 block of the source using four bilinear lookups, each
+    // of which averages 2x2 pixels, and optionally removes anything darker
+    // than the threshold, texelSize is the size of a pixel in the source
+    const string DOWNSAMPLE_SOURCE = R"(
+        uniform vec2 texelSize;
+        uniform float threshold;
+
+        void main()
+        {
+            vec2 uv = gl_TexCoord[0].st;
+            vec3 colour = .25 * (source(uv + texelSize * vec2(-1.0, -1.0)).rgb +
+                                 source(uv + texelSize * vec2(1.0, -1.0)).rgb +
+                                 source(uv + texelSize * vec2(-1.0, 1.0)).rgb +
+                                 source(uv + texelSize * vec2(1.0, 1.0)).rgb);
+            float brightness = max(colour.r, max(colour.g, colour.b));
+            colour *= max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+            gl_FragColor = vec4(colour, 1.0);
+        }
+    )";
+
+    // a 3x3 tent filter over the smaller level to smoothly scale it back up,
+    // this is drawn with additive blending onto the level above
+    const string UPSAMPLE_SOURCE = R"(
+        uniform sampler2D tex;
+        uniform vec2 texelSize;
+
+        void main()
+        {
+            vec2 uv = gl_TexCoord[0].st;
+            vec3 colour = 4.0 * texture2D(tex, uv).rgb;
+            colour += 2.0 * (texture2D(tex, uv + texelSize * vec2(-1.0, 0.0)).rgb +
+                             texture2D(tex, uv + texelSize * vec2(1.0, 0.0)).rgb +
+                             texture2D(tex, uv + texelSize * vec2(0.0, -1.0)).rgb +
+                             texture2D(tex, uv + texelSize * vec2(0.0, 1.0)).rgb);
+            colour += texture2D(tex, uv + texelSize * vec2(-1.0, -1.0)).rgb +
+                      texture2D(tex, uv + texelSize * vec2(1.0, -1.0)).rgb +
+                      texture2D(tex, uv + texelSize * vec2(-1.0, 1.0)).rgb +
+                      texture2D(tex, uv + texelSize * vec2(1.0, 1.0)).rgb;
+            gl_FragColor = vec4(colour / 16.0, 1.0);
+        }
+    )";
+
+    // adds the top level of the glow onto the original image
+    const string COMPOSITE_SOURCE = R"(
+        uniform sampler2D bloom;
+        uniform vec2 bloomTexelSize;
+        uniform float intensity;
+
+        void main()
+        {
+            vec2 uv = gl_TexCoord[0].st;
+            vec3 glow = .25 * (texture2D(bloom, uv + bloomTexelSize * vec2(-.5, -.5)).rgb +
+                               texture2D(bloom, uv + bloomTexelSize * vec2(.5, -.5)).rgb +
+                               texture2D(bloom, uv + bloomTexelSize * vec2(-.5, .5)).rgb +
+                               texture2D(bloom, uv + bloomTexelSize * vec2(.5, .5)).rgb);
+            vec4 colour = source(uv);
+            gl_FragColor = vec4(colour.rgb + intensity * glow, colour.a);
+        }
+    )";
+
+    // every level is half the size of the one before so
+    // there's no point going on when they get this small
+    const unsigned MIN_LEVEL_SIZE = 4;
+
+    void setupShader(ofShader& shader, const string& source, bool arb)
+    {
+        shader.setupShaderFromSource(GL_FRAGMENT_SHADER, (arb ? "#define ARB\n" : "") + SOURCE_HEADER + source);
+        shader.linkProgram();
+    }
+}
+
+MipBloomPass::MipBloomPass(const ofVec2f& aspect, bool arb, Quality quality) :
+    RenderPass(aspect, arb, "mip bloom"),
+    quality(quality),
+    intensity(1.f),
+    threshold(0.f),
+    allocatedWidth(0),
+    allocatedHeight(0),
+    levelsAllocated(false),
+    scissored(false)
+{
+    // the first downsample and the composite read the incoming image,
+    // everything else only reads our levels
+    setupShader(sourceDownsampleShader, DOWNSAMPLE_SOURCE, arb);
+    setupShader(downsampleShader, DOWNSAMPLE_SOURCE, false);
+    upsampleShader.setupShaderFromSource(GL_FRAGMENT_SHADER, UPSAMPLE_SOURCE);
+    upsampleShader.linkProgram();
+    setupShader(compositeShader, COMPOSITE_SOURCE, arb);
+}
+
+void MipBloomPass::setQuality(Quality quality)
+{
+    if (quality == this->quality) return;
+    this->quality = quality;
+
+    // the levels will be reallocated the next time we render
+    levelsAllocated = false;
+}
+
+void MipBloomPass::allocateLevels(unsigned width, unsigned height)
+{
+    unsigned divisor = quality == LOW ? 4 : 2;
+    unsigned numLevels = quality == LOW ? 3 : quality == MEDIUM ? 4 : 6;
+
+    levels.clear();
+    for (unsigned i = 0; i < numLevels && width / divisor >= MIN_LEVEL_SIZE && height / divisor >= MIN_LEVEL_SIZE; ++i)
+    {
+        ofFbo::Settings settings;
+        settings.width = width / divisor;
+        settings.height = height / divisor;
+        settings.textureTarget = GL_TEXTURE_2D;
+        settings.minFilter = GL_LINEAR;
+        settings.maxFilter = GL_LINEAR;
+        settings.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+        settings.wrapModeVertical = GL_CLAMP_TO_EDGE;
+
+        // the levels get added together on the way back up so we
+        // use floating point to stop them from saturating
+#ifdef TARGET_OPENGLES
+        settings.internalformat = GL_RGBA;
+#else
+        settings.internalformat = GL_RGBA16F;
+#endif
+        levels.push_back(ofFbo());
+        levels.back().allocate(settings);
+        divisor *= 2;
+    }
+
+    allocatedWidth = width;
+    allocatedHeight = height;
+    levelsAllocated = true;
+}
+
+void MipBloomPass::drawLevel(ofShader& shader, ofTexture& texture, ofFbo& fbo, bool clear, float threshold)
+{
+    fbo.begin();
+    if (scissored)
+    {
+        // anything outside of the scissor box could be left over from an
+        // earlier frame so we clear the whole level before shrinking into it
+        if (clear)
+        {
+            glDisable(GL_SCISSOR_TEST);
+            ofClear(0, 255);
+            glEnable(GL_SCISSOR_TEST);
+        }
+        scissorTo(fbo);
+    }
+    shader.begin();
+    shader.setUniformTexture("tex", texture, 0);
+    shader.setUniform2f("texSize", texture.getWidth(), texture.getHeight());
+    shader.setUniform2f("texelSize", 1.f / texture.getWidth(), 1.f / texture.getHeight());
+    shader.setUniform1f("threshold", threshold);
+    texturedQuad(0, 0, fbo.getWidth(), fbo.getHeight());
+    shader.end();
+    fbo.end();
+}
+
+void MipBloomPass::scissorTo(const ofFbo& fbo)
+{
+    // scale the scissor box down to the size of the fbo and pad it by a couple
+    // of pixels so that the filters only read from what has been drawn
+    const float scale = fbo.getWidth() / allocatedWidth;
+    const int x = max(0, (int)floor(scissorBox[0] * scale) - 2);
+    const int y = max(0, (int)floor(scissorBox[1] * scale) - 2);
+    const int right = min((int)fbo.getWidth(), (int)ceil((scissorBox[0] + scissorBox[2]) * scale) + 2);
+    const int top = min((int)fbo.getHeight(), (int)ceil((scissorBox[1] + scissorBox[3]) * scale) + 2);
+    glScissor(x, y, max(0, right - x), max(0, top - y));
+}
+
+void MipBloomPass::render(ofFbo& readFbo, ofFbo& writeFbo)
+{
+    if (!levelsAllocated || allocatedWidth != readFbo.getWidth() || allocatedHeight != readFbo.getHeight())
+    {
+        allocateLevels(readFbo.getWidth(), readFbo.getHeight());
+    }
+
+    // if there's a scissor box then only that part of the image needs
+    // to be processed so we do the same in every level
+    scissored = glIsEnabled(GL_SCISSOR_TEST);
+    if (scissored) glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+
+    ofPushStyle();
+    ofDisableBlendMode();
+
+    if (!levels.empty())
+    {
+        // shrink the image down, the first step removes anything that's too dark
+        drawLevel(sourceDownsampleShader, readFbo.getTexture(), levels[0], true, threshold);
+        for (unsigned i = 1; i < levels.size(); ++i)
+        {
+            drawLevel(downsampleShader, levels[i - 1].getTexture(), levels[i], true);
+        }
+
+        // then work our way back up adding each level onto the one above it
+        ofEnableBlendMode(OF_BLENDMODE_ADD);
+        for (unsigned i = levels.size() - 1; i > 0; --i)
+        {
+            drawLevel(upsampleShader, levels[i].getTexture(), levels[i - 1], false);
+        }
+        ofDisableBlendMode();
+    }
+
+    // finally add the glow onto the original image, every level has been
+    // added into the top one so we divide by how many there are to keep
+    // the brightness the same whatever the quality
+    if (scissored) glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    writeFbo.begin();
+    compositeShader.begin();
+    compositeShader.setUniformTexture("tex", readFbo.getTexture(), 0);
+    compositeShader.setUniform2f("texSize", readFbo.getWidth(), readFbo.getHeight());
+    if (!levels.empty())
+    {
+        ofTexture& bloom = levels[0].getTexture();
+        compositeShader.setUniformTexture("bloom", bloom, 1);
+        compositeShader.setUniform2f("bloomTexelSize", 1.f / bloom.getWidth(), 1.f / bloom.getHeight());
+        compositeShader.setUniform1f("intensity", intensity / levels.size());
+    }
+    else compositeShader.setUniform1f("intensity", 0.f);
+    texturedQuad(0, 0, writeFbo.getWidth(), writeFbo.getHeight());
+    compositeShader.end();
+    writeFbo.end();
+
+    ofPopStyle();
+}
+
+string MipBloomPass::benchmark(unsigned width, unsigned height, unsigned numFrames)
+{
+    // something to glow, thin lines across the image like the outline
+    ofFbo::Settings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.textureTarget = GL_TEXTURE_2D;
+    ofFbo readFbo;
+    ofFbo writeFbo;
+    readFbo.allocate(settings);
+    writeFbo.allocate(settings);
+    readFbo.begin();
+    ofClear(0, 255);
+    ofPushStyle();
+    ofSetColor(0, 255, 0);
+    ofSetLineWidth(2.f);
+    for (unsigned i = 1; i < 16; ++i)
+    {
+        ofDrawLine(i * width / 16.f, 0.f, width - i * width / 16.f, height);
+        ofDrawLine(0.f, i * height / 16.f, width, height - i * height / 16.f);
+    }
+    ofPopStyle();
+    readFbo.end();
+
+    // glFinish() waits for the gpu so the times are for the
+    // rendering rather than for queueing up the commands
+    auto time = [&](itg::RenderPass& pass)
+    {
+        for (unsigned i = 0; i < 5; ++i) pass.render(readFbo, writeFbo);
+        glFinish();
+        const unsigned long long start = ofGetElapsedTimeMicros();
+        for (unsigned i = 0; i < numFrames; ++i) pass.render(readFbo, writeFbo);
+        glFinish();
+        return (ofGetElapsedTimeMicros() - start) / 1000.f / numFrames;
+    };
+
+    // the same aspect the post processing gives its passes
+    const ofVec2f aspect(1.f, width / (float)height);
+    itg::BloomPass bloom(aspect, false);
+    MipBloomPass mipBloom(aspect, false);
+    const char* qualityNames[] = { "low", "medium", "high" };
+
+    stringstream report;
+    report << width << "x" << height << ": original " << time(bloom) << "ms";
+    for (unsigned quality = LOW; quality <= HIGH; ++quality)
+    {
+        mipBloom.setQuality((Quality)quality);
+        report << ", " << qualityNames[quality] << " " << time(mipBloom) << "ms";
+    }
+    return report.str();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxPostProcessing.h"
+
+// a bloom (glow) pass that does its blurring at a fraction of the size of
+// the screen, because the glow is smooth it doesn't need lots of pixels
+//
+// the image is shrunk to half or a quarter of the size and then halved again
+// a few times, each of these levels is a little bit more blurred than the one
+// before, we then work our way back up adding each level onto the one above
+// it and finally add the result onto the original image, this gives a wide
+// soft glow for a fraction of the cost of blurring at full resolution
+//
+// if the scissor test is on when the pass renders then only the part of the
+// image inside the scissor box is processed
+//
+// it can be created in exactly the same way as the other passes, e.g.
+// postProcessing.createPass<MipBloomPass>()->setQuality(MipBloomPass::MEDIUM);
+class MipBloomPass : public itg::RenderPass
+{
+public:
+    typedef shared_ptr<MipBloomPass> Ptr;
+
+    enum Quality
+    {
+        // starts at a quarter of the size with three levels
+        LOW,
+        // starts at half of the size with four levels
+        MEDIUM,
+        // starts at half of the size with six levels, the widest glow
+        HIGH
+    };
+
+    // arb is whether the post processing's fbos are rectangle textures
+    MipBloomPass(const ofVec2f& aspect, bool arb, Quality quality = MEDIUM);
+
+    void render(ofFbo& readFbo, ofFbo& writeFbo);
+
+    void setQuality(Quality quality);
+    Quality getQuality() const { return quality; }
+
+    // how much of the glow is added on to the image
+    void setIntensity(float intensity) { this->intensity = intensity; }
+    float getIntensity() const { return intensity; }
+
+    // only the parts of the image brighter than this glow, zero makes everything glow
+    void setThreshold(float threshold) { this->threshold = threshold; }
+    float getThreshold() const { return threshold; }
+
+    unsigned getNumLevels() const { return levels.size(); }
+
+    // times the original bloom and each quality of this one on a width by
+    // height image and returns how many milliseconds each takes a frame
+    static string benchmark(unsigned width, unsigned height, unsigned numFrames = 100);
+
+private:
+    // (re)allocate the levels if the quality or the size of the input has changed
+    void allocateLevels(unsigned width, unsigned height);
+
+    // draw texture into fbo with the given shader, clear is only needed when
+    // scissoring and only the downsample shader takes any notice of threshold
+    void drawLevel(ofShader& shader, ofTexture& texture, ofFbo& fbo, bool clear, float threshold = 0.f);
+
+    // set the scissor box to the part of fbo that matches scissorBox
+    void scissorTo(const ofFbo& fbo);
+
+    Quality quality;
+    float intensity;
+    float threshold;
+
+    // each level is half the size of the one before it
+    vector<ofFbo> levels;
+    unsigned allocatedWidth;
+    unsigned allocatedHeight;
+    bool levelsAllocated;
+
+    // the scissor box when we started rendering, in pixels of the full size image
+    bool scissored;
+    GLint scissorBox[4];
+
+    ofShader sourceDownsampleShader;
+    ofShader downsampleShader;
+    ofShader upsampleShader;
+    ofShader compositeShader;
+};
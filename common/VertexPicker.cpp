@@ -0,0 +1,314 @@
+#include "VertexPicker.h"
+
+VertexPicker::VertexPicker() :
+    mesh(NULL),
+    camera(NULL),
+    builtNumVertices(0),
+    dirty(true),
+    cellSize(1.f),
+    numCellsX(0),
+    numCellsY(0),
+    numRebuilds(0),
+    lastRebuildMillis(0.f)
+{
+}
+
+void VertexPicker::setup(const ofMesh& mesh, const ofCamera& camera)
+{
+    this->mesh = &mesh;
+    this->camera = &camera;
+    dirty = true;
+}
+
+void VertexPicker::setTransform(const ofMatrix4x4& transform)
+{
+    this->transform = transform;
+    dirty = true;
+}
+
+void VertexPicker::vertexMoved(unsigned index)
+{
+    // if the grid is going to be rebuilt anyway there's nothing to do
+    if (dirty || !mesh) return;
+    if (mesh->getNumVertices() != builtNumVertices)
+    {
+        dirty = true;
+        return;
+    }
+
+    // take the vertex out of the grid and look at it on its own from now on
+    ofVec2f& screen = screenPositions[index];
+    visible[index] = project(mesh->getVertices()[index], screen) && builtViewport.inside(screen.x, screen.y);
+    if (!moved[index])
+    {
+        moved[index] = true;
+        movedIndices.push_back(index);
+
+        // looking at the moved vertices one by one gets slow if there are lots of them
+        if (movedIndices.size() > MAX_MOVED_VERTICES) dirty = true;
+    }
+}
+
+int VertexPicker::getNearest(const ofVec2f& screen, float maxDistance, const ofRectangle& viewport)
+{
+    if (!mesh || !camera) return -1;
+    update(viewport);
+
+    int nearest = -1;
+    float nearestDistanceSquared = maxDistance * maxDistance;
+
+    // only look in the cells that are within maxDistance of the point
+    if (numCellsX && numCellsY &&
+        screen.x + maxDistance >= bounds.getLeft() && screen.x - maxDistance <= bounds.getRight() &&
+        screen.y + maxDistance >= bounds.getTop() && screen.y - maxDistance <= bounds.getBottom())
+    {
+        const int minX = getCellX(screen.x - maxDistance);
+        const int maxX = getCellX(screen.x + maxDistance);
+        const int minY = getCellY(screen.y - maxDistance);
+        const int maxY = getCellY(screen.y + maxDistance);
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                const unsigned cell = x + y * numCellsX;
+                for (unsigned i = cellStarts[cell]; i < cellStarts[cell + 1]; ++i)
+                {
+                    const unsigned index = cellIndices[i];
+                    if (moved[index]) continue;
+                    const float distanceSquared = screen.squareDistance(screenPositions[index]);
+                    if (distanceSquared < nearestDistanceSquared)
+                    {
+                        nearest = index;
+                        nearestDistanceSquared = distanceSquared;
+                    }
+                }
+            }
+        }
+    }
+
+    // then at the vertices that have moved since the grid was built
+    for (unsigned i = 0; i < movedIndices.size(); ++i)
+    {
+        const unsigned index = movedIndices[i];
+        if (!visible[index]) continue;
+        const float distanceSquared = screen.squareDistance(screenPositions[index]);
+        if (distanceSquared < nearestDistanceSquared)
+        {
+            nearest = index;
+            nearestDistanceSquared = distanceSquared;
+        }
+    }
+
+    return nearest;
+}
+
+void VertexPicker::update(const ofRectangle& viewport)
+{
+    // this is cheap compared to projecting every vertex so we
+    // check it every time rather than relying on being told
+    modelViewProjection = transform * camera->getModelViewProjectionMatrix(viewport);
+    if (!dirty &&
+        !memcmp(modelViewProjection.getPtr(), builtModelViewProjection.getPtr(), 16 * sizeof(float)) &&
+        viewport == builtViewport &&
+        mesh->getNumVertices() == builtNumVertices)
+    {
+        return;
+    }
+
+    builtModelViewProjection = modelViewProjection;
+    builtViewport = viewport;
+    builtNumVertices = mesh->getNumVertices();
+    rebuild();
+    dirty = false;
+}
+
+void VertexPicker::rebuild()
+{
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    const vector<ofVec3f>& vertices = mesh->getVertices();
+
+    // project everything and find the part of the screen that the visible vertices cover
+    screenPositions.resize(vertices.size());
+    visible.assign(vertices.size(), false);
+    moved.assign(vertices.size(), false);
+    movedIndices.clear();
+
+    unsigned numVisible = 0;
+    ofVec2f minimum(numeric_limits<float>::max(), numeric_limits<float>::max());
+    ofVec2f maximum(-numeric_limits<float>::max(), -numeric_limits<float>::max());
+    for (unsigned i = 0; i < vertices.size(); ++i)
+    {
+        ofVec2f& screen = screenPositions[i];
+        if (project(vertices[i], screen) && builtViewport.inside(screen.x, screen.y))
+        {
+            visible[i] = true;
+            minimum.set(min(minimum.x, screen.x), min(minimum.y, screen.y));
+            maximum.set(max(maximum.x, screen.x), max(maximum.y, screen.y));
+            ++numVisible;
+        }
+    }
+
+    if (numVisible)
+    {
+        // make the cells a size that puts about VERTICES_PER_CELL vertices in each,
+        // they never need to be smaller than a pixel
+        bounds.set(minimum.x, minimum.y, maximum.x - minimum.x, maximum.y - minimum.y);
+        const float numCells = max(1.f, (float)numVisible / VERTICES_PER_CELL);
+        cellSize = max(1.f, sqrtf(max(bounds.getArea(), 1.f) / numCells));
+        numCellsX = floor(bounds.getWidth() / cellSize) + 1;
+        numCellsY = floor(bounds.getHeight() / cellSize) + 1;
+
+        // sort the vertices into their cells, first count how many are in each cell,
+        // then work out where each cell starts and finally put them in their places
+        vector<unsigned> cells(vertices.size());
+        cellStarts.assign(numCellsX * numCellsY + 1, 0);
+        for (unsigned i = 0; i < vertices.size(); ++i)
+        {
+            if (!visible[i]) continue;
+            cells[i] = getCellX(screenPositions[i].x) + getCellY(screenPositions[i].y) * numCellsX;
+            ++cellStarts[cells[i] + 1];
+        }
+        for (unsigned i = 1; i < cellStarts.size(); ++i) cellStarts[i] += cellStarts[i - 1];
+
+        vector<unsigned> next(cellStarts.begin(), cellStarts.end() - 1);
+        cellIndices.resize(numVisible);
+        for (unsigned i = 0; i < vertices.size(); ++i)
+        {
+            if (visible[i]) cellIndices[next[cells[i]]++] = i;
+        }
+    }
+    else
+    {
+        numCellsX = numCellsY = 0;
+        cellStarts.assign(1, 0);
+        cellIndices.clear();
+    }
+
+    ++numRebuilds;
+    lastRebuildMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+}
+
+bool VertexPicker::project(const ofVec3f& vertex, ofVec2f& screen) const
+{
+    // the same as ofCamera::worldToScreen() except that we can tell
+    // when the vertex is behind the camera from w
+    const float* m = modelViewProjection.getPtr();
+    const float w = vertex.x * m[3] + vertex.y * m[7] + vertex.z * m[11] + m[15];
+    if (w <= 0.f) return false;
+    const float x = (vertex.x * m[0] + vertex.y * m[4] + vertex.z * m[8] + m[12]) / w;
+    const float y = (vertex.x * m[1] + vertex.y * m[5] + vertex.z * m[9] + m[13]) / w;
+    screen.set(builtViewport.x + (x + 1.f) * .5f * builtViewport.width,
+               builtViewport.y + (1.f - y) * .5f * builtViewport.height);
+    return true;
+}
+
+ofVec3f VertexPicker::unproject(unsigned index, const ofVec2f& screen) const
+{
+    // keep the vertex's depth and give it the screen position's x and y,
+    // the inverse then takes care of the perspective divide for us
+    const ofVec3f& vertex = mesh->getVertices()[index];
+    const float* m = modelViewProjection.getPtr();
+    const float w = vertex.x * m[3] + vertex.y * m[7] + vertex.z * m[11] + m[15];
+    const float z = (vertex.x * m[2] + vertex.y * m[6] + vertex.z * m[10] + m[14]) / w;
+    const ofVec3f device(2.f * (screen.x - builtViewport.x) / builtViewport.width - 1.f,
+                         1.f - 2.f * (screen.y - builtViewport.y) / builtViewport.height, z);
+    return device * modelViewProjection.getInverse();
+}
+
+int VertexPicker::getCellX(float x) const
+{
+    return ofClamp(floor((x - bounds.x) / cellSize), 0, numCellsX - 1);
+}
+
+int VertexPicker::getCellY(float y) const
+{
+    return ofClamp(floor((y - bounds.y) / cellSize), 0, numCellsY - 1);
+}
+
+string VertexPicker::benchmark(unsigned numVertices)
+{
+    // a cloud of points about the size of the box, like a scanned mesh would be
+    ofMesh mesh;
+    ofSeedRandom(0);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        mesh.addVertex(ofVec3f(ofRandom(-15.f, 15.f), ofRandom(-15.f, 15.f), ofRandom(-15.f, 15.f)));
+    }
+
+    // the same camera as the apps start with
+    ofCamera camera;
+    camera.setPosition(0.f, 0.f, -200.f);
+    camera.setFov(16.84f);
+    camera.lookAt(ofVec3f(0.f, 0.f, 0.f));
+    const ofRectangle viewport(0.f, 0.f, 1920.f, 1080.f);
+    const float maxDistance = 20.f;
+
+    VertexPicker picker;
+    picker.setup(mesh, camera);
+
+    // the first pick builds the grid
+    picker.getNearest(ofVec2f(), maxDistance, viewport);
+    const float rebuildMillis = picker.getLastRebuildMillis();
+
+    // lots of picks around where the mesh is, like the mouse moving over it
+    const unsigned numPicks = 10000;
+    const ofVec2f centre(viewport.getCenter().x, viewport.getCenter().y);
+    vector<ofVec2f> points(numPicks);
+    for (unsigned i = 0; i < numPicks; ++i)
+    {
+        points[i].set(centre.x + ofRandom(-300.f, 300.f), centre.y + ofRandom(-300.f, 300.f));
+    }
+    vector<int> picked(numPicks);
+    unsigned long long start = ofGetElapsedTimeMicros();
+    for (unsigned i = 0; i < numPicks; ++i) picked[i] = picker.getNearest(points[i], maxDistance, viewport);
+    const float pickMicros = (float)(ofGetElapsedTimeMicros() - start) / numPicks;
+
+    // the same picks looking at every vertex, there are fewer of them because
+    // they're so slow, we also check that they find vertices just as close
+    const unsigned numLinearPicks = 20;
+    unsigned numMismatches = 0;
+    start = ofGetElapsedTimeMicros();
+    for (unsigned i = 0; i < numLinearPicks; ++i)
+    {
+        int nearest = -1;
+        float nearestDistanceSquared = maxDistance * maxDistance;
+        for (unsigned j = 0; j < numVertices; ++j)
+        {
+            ofVec2f screen;
+            if (!picker.project(mesh.getVertices()[j], screen)) continue;
+            const float distanceSquared = points[i].squareDistance(screen);
+            if (distanceSquared < nearestDistanceSquared)
+            {
+                nearest = j;
+                nearestDistanceSquared = distanceSquared;
+            }
+        }
+        if ((nearest == -1) != (picked[i] == -1) ||
+            (nearest != -1 && points[i].squareDistance(picker.getScreenPosition(picked[i])) > nearestDistanceSquared))
+        {
+            ++numMismatches;
+        }
+    }
+    const float linearMicros = (float)(ofGetElapsedTimeMicros() - start) / numLinearPicks;
+
+    // dragging moves the same vertex along with the mouse and picks every frame
+    const int dragged = picker.getNearest(centre, viewport.width, viewport);
+    start = ofGetElapsedTimeMicros();
+    for (unsigned i = 0; dragged >= 0 && i < numPicks; ++i)
+    {
+        mesh.getVertices()[dragged] = picker.unproject(dragged, picker.getScreenPosition(dragged) + ofVec2f(.1f, 0.f));
+        picker.vertexMoved(dragged);
+        picker.getNearest(picker.getScreenPosition(dragged), maxDistance, viewport);
+    }
+    const float dragMicros = (float)(ofGetElapsedTimeMicros() - start) / numPicks;
+
+    stringstream report;
+    report << numVertices << " vertices: "
+           << "grid build " << rebuildMillis << "ms (" << picker.numCellsX << "x" << picker.numCellsY << " cells), "
+           << "pick " << pickMicros << "us, "
+           << "drag " << dragMicros << "us (" << picker.getNumRebuilds() - 1 << " rebuilds), "
+           << "looking at every vertex " << linearMicros << "us, "
+           << linearMicros / max(pickMicros, .001f) << " times faster, "
+           << numMismatches << " mismatches";
+    return report.str();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ofMain.h"
+
+// finds the vertex of a mesh that is nearest to a point on the screen
+//
+// looking at every vertex is fine for a box with eight corners but once a
+// mesh has hundreds of thousands of vertices it takes too long to do every
+// time the mouse moves, so we project all of the vertices onto the screen
+// once and sort them into a grid of cells, to find the nearest vertex we
+// then only have to look in the cells around the mouse
+//
+// the grid is only rebuilt when it's needed, i.e. when the camera, the
+// viewport, the mesh's transform or the number of vertices changes, when
+// just a few vertices move they are taken out of the grid and kept in a
+// short list of their own instead, which is rebuilt into the grid once it
+// gets too long
+class VertexPicker
+{
+public:
+    // the grid is sized so that there are roughly this many vertices in each cell
+    static const unsigned VERTICES_PER_CELL = 8;
+
+    // once this many vertices have moved we rebuild the grid
+    static const unsigned MAX_MOVED_VERTICES = 1024;
+
+    VertexPicker();
+
+    // the mesh and camera must stay around for as long as the picker
+    void setup(const ofMesh& mesh, const ofCamera& camera);
+
+    // the transform that is applied to the mesh when it is drawn, e.g. to rotate it
+    void setTransform(const ofMatrix4x4& transform);
+
+    // call this when one vertex has moved, it's much cheaper than a rebuild
+    void vertexMoved(unsigned index);
+
+    // call this when lots of the vertices have moved, the grid will be rebuilt the next time it's needed
+    void verticesChanged() { dirty = true; }
+
+    // the index of the nearest vertex to screen that is within maxDistance
+    // pixels of it or -1 if there isn't one, screen has (0, 0) at the top left
+    int getNearest(const ofVec2f& screen, float maxDistance, const ofRectangle& viewport = ofGetCurrentViewport());
+
+    // where a vertex was on the screen when we last looked at it
+    const ofVec2f& getScreenPosition(unsigned index) const { return screenPositions[index]; }
+
+    // where a vertex has to move to, in the mesh's own coordinates, to be at
+    // screen while staying the same depth from the camera, this is how a
+    // picked vertex is dragged, use vertexMoved() once it has been moved
+    ofVec3f unproject(unsigned index, const ofVec2f& screen) const;
+
+    unsigned getNumRebuilds() const { return numRebuilds; }
+    float getLastRebuildMillis() const { return lastRebuildMillis; }
+
+    // makes a mesh with numVertices vertices and returns a report of how long
+    // it takes to build the grid and to pick from it compared with looking at
+    // every vertex
+    static string benchmark(unsigned numVertices = 500000);
+
+private:
+    // rebuild the grid if the camera, viewport, transform or mesh have changed
+    void update(const ofRectangle& viewport);
+    void rebuild();
+
+    // project a vertex onto the screen, returns false if it's behind the camera
+    bool project(const ofVec3f& vertex, ofVec2f& screen) const;
+
+    // the cell a point on the screen is in, clamped to the grid
+    int getCellX(float x) const;
+    int getCellY(float y) const;
+
+    const ofMesh* mesh;
+    const ofCamera* camera;
+    ofMatrix4x4 transform;
+
+    // what the grid was built with, if any of them change we rebuild it
+    ofMatrix4x4 builtModelViewProjection;
+    ofRectangle builtViewport;
+    unsigned builtNumVertices;
+    bool dirty;
+
+    // the transform and the camera's projection multiplied together
+    ofMatrix4x4 modelViewProjection;
+
+    // every vertex on the screen, vertices that are behind the camera
+    // or off the screen aren't in the grid and can't be picked
+    vector<ofVec2f> screenPositions;
+    vector<bool> visible;
+
+    // the grid covers bounds and each cell is cellSize pixels square, the
+    // indices of the vertices in cell i are cellIndices[cellStarts[i]]
+    // up to cellIndices[cellStarts[i + 1]]
+    ofRectangle bounds;
+    float cellSize;
+    unsigned numCellsX;
+    unsigned numCellsY;
+    vector<unsigned> cellStarts;
+    vector<unsigned> cellIndices;
+
+    // vertices that have moved since the grid was built, they are skipped
+    // in the grid and looked at one by one instead
+    vector<bool> moved;
+    vector<unsigned> movedIndices;
+
+    unsigned numRebuilds;
+    float lastRebuildMillis;
+};
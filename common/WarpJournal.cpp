@@ -0,0 +1,265 @@
+#include "WarpJournal.h"
+
+#ifdef TARGET_WIN32
+    #include <io.h>
+    #define fsync(fd) _commit(fd)
+    #define fileno _fileno
+#else
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    const char MAGIC[4] = { 'P', 'M', 'W', 'J' };
+    const uint32_t VERSION = 1;
+}
+
+WarpJournal::WarpJournal() :
+    verticesChangedSinceUpdate(false),
+    compactionInterval(60.f),
+    lastCompactionTime(0.f),
+    numRecordsSinceCompaction(0),
+    numRecordsWritten(0),
+    closing(false),
+    file(NULL)
+{
+}
+
+WarpJournal::~WarpJournal()
+{
+    if (isThreadRunning() || file) close();
+}
+
+void WarpJournal::addMesh(ofMesh& mesh, const string& meshPath)
+{
+    meshes.push_back(&mesh);
+    meshPaths.push_back(meshPath);
+}
+
+void WarpJournal::setup(const string& journalPath, float compactionInterval)
+{
+    this->journalPath = ofToDataPath(journalPath, true);
+    this->compactionInterval = compactionInterval;
+
+    // replay anything that was journalled after the meshes were last saved
+    unsigned numReplayed = 0;
+    FILE* existing = fopen(this->journalPath.c_str(), "rb");
+    if (existing)
+    {
+        char magic[4];
+        uint32_t version;
+        if (fread(magic, sizeof(magic), 1, existing) == 1 && !memcmp(magic, MAGIC, sizeof(MAGIC)) &&
+            fread(&version, sizeof(version), 1, existing) == 1 && version == VERSION)
+        {
+            // if we crashed half way through writing a record then
+            // fread() won't be able to read all of it so it's ignored
+            Record record;
+            while (fread(&record, sizeof(record), 1, existing) == 1)
+            {
+                if (record.mesh < meshes.size() && record.vertex < meshes[record.mesh]->getNumVertices())
+                {
+                    meshes[record.mesh]->getVertices()[record.vertex].set(record.x, record.y, record.z);
+                    ++numReplayed;
+                }
+            }
+        }
+        fclose(existing);
+    }
+
+    // remember where everything is now so we can tell what moves
+    lastVertices.resize(meshes.size());
+    for (unsigned i = 0; i < meshes.size(); ++i)
+    {
+        const ofMesh& mesh = *meshes[i];
+        lastVertices[i] = mesh.getVertices();
+    }
+
+    // carry on adding to the end of the journal
+    file = fopen(this->journalPath.c_str(), "ab");
+    if (!file || ftell(file) == 0) resetFile();
+
+    lastCompactionTime = ofGetElapsedTimef();
+    closing = false;
+    startThread();
+
+    if (numReplayed)
+    {
+        ofLogNotice("WarpJournal") << "replayed " << numReplayed << " vertex moves from " << journalPath;
+
+        // fold the replayed moves into the mesh files straight away
+        compact();
+    }
+}
+
+void WarpJournal::update()
+{
+    if (verticesChangedSinceUpdate)
+    {
+        verticesChangedSinceUpdate = false;
+
+        // look for any vertices that have moved since last time
+        Job job;
+        for (unsigned i = 0; i < meshes.size(); ++i)
+        {
+            // we use a const reference so that looking at the vertices
+            // doesn't make a vbo mesh think it needs to upload them again
+            const ofMesh& mesh = *meshes[i];
+            const vector<ofVec3f>& vertices = mesh.getVertices();
+            vector<ofVec3f>& last = lastVertices[i];
+
+            // if the mesh has been replaced entirely then journal all of it
+            if (last.size() != vertices.size()) last.assign(vertices.size(), ofVec3f(numeric_limits<float>::max()));
+
+            for (unsigned j = 0; j < vertices.size(); ++j)
+            {
+                if (vertices[j] != last[j])
+                {
+                    Record record = { i, j, vertices[j].x, vertices[j].y, vertices[j].z };
+                    job.records.push_back(record);
+                    last[j] = vertices[j];
+                    if (listener) listener(i, j);
+                }
+            }
+        }
+
+        queueRecords(job.records);
+    }
+
+    // every so often save the meshes in full so the journal doesn't get too long
+    if (numRecordsSinceCompaction && ofGetElapsedTimef() - lastCompactionTime > compactionInterval) compact();
+}
+
+void WarpJournal::verticesMoved(unsigned mesh, const vector<unsigned>& vertices)
+{
+    if (mesh >= meshes.size()) return;
+
+    // a const reference again so a vbo mesh doesn't upload its vertices, if
+    // the mesh has been replaced entirely then all of it has to be looked at
+    const ofMesh& constMesh = *meshes[mesh];
+    const vector<ofVec3f>& meshVertices = constMesh.getVertices();
+    vector<ofVec3f>& last = lastVertices[mesh];
+    if (last.size() != meshVertices.size())
+    {
+        verticesChanged();
+        return;
+    }
+
+    vector<Record> records;
+    for (unsigned vertex : vertices)
+    {
+        if (vertex < meshVertices.size() && meshVertices[vertex] != last[vertex])
+        {
+            Record record = { mesh, vertex, meshVertices[vertex].x, meshVertices[vertex].y, meshVertices[vertex].z };
+            records.push_back(record);
+            last[vertex] = meshVertices[vertex];
+            if (listener) listener(mesh, vertex);
+        }
+    }
+    queueRecords(records);
+}
+
+void WarpJournal::queueRecords(vector<Record>& records)
+{
+    if (records.empty()) return;
+
+    numRecordsSinceCompaction += records.size();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        jobs.push_back(Job());
+        jobs.back().records.swap(records);
+    }
+    queueCondition.notify_one();
+}
+
+void WarpJournal::compact()
+{
+    // the copies are taken here on the render thread so that the meshes
+    // are saved exactly as they were after the records before this job
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        jobs.push_back(Job());
+        for (unsigned i = 0; i < meshes.size(); ++i) jobs.back().meshes.push_back(*meshes[i]);
+    }
+    queueCondition.notify_one();
+
+    numRecordsSinceCompaction = 0;
+    lastCompactionTime = ofGetElapsedTimef();
+}
+
+void WarpJournal::close(bool saveMeshes)
+{
+    // save the meshes in full one last time, then let the
+    // thread finish whatever is waiting and stop
+    if (saveMeshes && numRecordsSinceCompaction) compact();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        closing = true;
+    }
+    queueCondition.notify_one();
+    waitForThread(false);
+
+    if (file)
+    {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+void WarpJournal::threadedFunction()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (jobs.empty() && !closing) queueCondition.wait(lock);
+            if (jobs.empty()) break;
+            job.records.swap(jobs.front().records);
+            job.meshes.swap(jobs.front().meshes);
+            jobs.pop_front();
+        }
+
+        if (!job.records.empty()) writeRecords(job.records);
+
+        if (!job.meshes.empty())
+        {
+            // only empty the journal if all of the meshes saved
+            // otherwise the moves in it are all we've got
+            bool saved = true;
+            for (unsigned i = 0; i < job.meshes.size(); ++i)
+            {
+                saved = BinaryMesh::save(job.meshes[i], meshPaths[i]) && saved;
+            }
+            if (saved) resetFile();
+        }
+    }
+}
+
+bool WarpJournal::resetFile()
+{
+    if (file) fclose(file);
+    file = fopen(journalPath.c_str(), "wb");
+    if (!file)
+    {
+        ofLogError("WarpJournal") << "couldn't open " << journalPath;
+        return false;
+    }
+
+    fwrite(MAGIC, sizeof(MAGIC), 1, file);
+    fwrite(&VERSION, sizeof(VERSION), 1, file);
+    fflush(file);
+    fsync(fileno(file));
+    return true;
+}
+
+void WarpJournal::writeRecords(const vector<Record>& records)
+{
+    if (!file) return;
+
+    fwrite(&records[0], sizeof(Record), records.size(), file);
+
+    // make sure it's actually on the disk and not just sitting in a buffer
+    fflush(file);
+    fsync(fileno(file));
+    numRecordsWritten += records.size();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ofMain.h"
+#include "BinaryMesh.h"
+
+// keeps a journal of every vertex that gets warped so that if the app
+// crashes or the power goes we don't lose all of our alignment
+//
+// whenever a vertex moves a small record of its new position is appended to
+// the journal file, the writing happens on this object's own thread so the
+// render thread never waits for the disk, every so often the meshes are
+// saved in full and the journal is emptied, when the app starts up any moves
+// left in the journal are replayed on top of the saved meshes
+class WarpJournal : public ofThread
+{
+public:
+    typedef function<void(unsigned mesh, unsigned vertex)> Listener;
+
+    WarpJournal();
+    ~WarpJournal();
+
+    // add the meshes before calling setup(), meshPath is the binary
+    // mesh file that the mesh is compacted into
+    void addMesh(ofMesh& mesh, const string& meshPath);
+
+    // replays any moves left in the journal from last time onto the meshes,
+    // so call this after the meshes have been loaded, and starts the thread
+    void setup(const string& journalPath, float compactionInterval = 60.f);
+
+    // call this once a frame from the render thread, it looks for vertices
+    // that have moved since verticesChanged() was called and journals them
+    void update();
+
+    // call this when vertices have moved so that the next update() looks
+    // through every vertex of every mesh for the ones that have
+    void verticesChanged() { verticesChangedSinceUpdate = true; }
+
+    // journal the vertices of a mesh that have moved straight away without
+    // looking through the rest, for when whatever moved them knows which
+    // ones it was, vertices that haven't really moved are left out
+    void verticesMoved(unsigned mesh, const vector<unsigned>& vertices);
+
+    // save the meshes in full and empty the journal
+    void compact();
+
+    // saves the meshes in full if anything has moved, waits for everything
+    // to be written and stops the thread, call this when the app exits
+    // before saving the meshes any other way, with saveMeshes false the
+    // mesh files are left as they are
+    void close(bool saveMeshes = true);
+
+    unsigned long getNumRecordsWritten() const { return numRecordsWritten; }
+
+    // called by update() and verticesMoved() for each vertex that has moved, with the index of
+    // the mesh in the order they were added and the index of the vertex, so that
+    // anything else that keeps track of the vertices can catch up cheaply
+    void setListener(Listener listener) { this->listener = listener; }
+
+private:
+    // these are what gets written to the journal for each vertex that moves
+    struct Record
+    {
+        uint32_t mesh;
+        uint32_t vertex;
+        float x;
+        float y;
+        float z;
+    };
+
+    // work for the journal thread, either some records to append or, if
+    // meshes isn't empty, a copy of the meshes to save in full before
+    // emptying the journal, these are done strictly in order
+    struct Job
+    {
+        vector<Record> records;
+        vector<ofMesh> meshes;
+    };
+
+    void threadedFunction();
+
+    // (re)create the journal with just a header in it
+    bool resetFile();
+
+    // hand records to the thread to append to the journal
+    void queueRecords(vector<Record>& records);
+
+    void writeRecords(const vector<Record>& records);
+
+    string journalPath;
+    vector<ofMesh*> meshes;
+    vector<string> meshPaths;
+
+    // what the meshes looked like last time we checked, so we know what moved
+    vector<vector<ofVec3f> > lastVertices;
+
+    // looking through every vertex is only worth it when we've been told they've moved
+    bool verticesChangedSinceUpdate;
+
+    Listener listener;
+
+    float compactionInterval;
+    float lastCompactionTime;
+    unsigned long numRecordsSinceCompaction;
+    atomic<unsigned long> numRecordsWritten;
+
+    // work waiting for the thread, shared between the render thread and the journal thread
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    deque<Job> jobs;
+    bool closing;
+
+    FILE* file;
+};
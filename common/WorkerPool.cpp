@@ -0,0 +1,99 @@
+#include "WorkerPool.h"
+
+WorkerPool& WorkerPool::get()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool(unsigned numThreads) :
+    busy(false),
+    body(NULL),
+    numParts(0),
+    nextPart(0),
+    numPartsDone(0),
+    generation(0),
+    closing(false)
+{
+    if (!numThreads) numThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 1; i < numThreads; ++i) threads.push_back(thread(&WorkerPool::work, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    partsReady.notify_all();
+    for (unsigned i = 0; i < threads.size(); ++i) threads[i].join();
+}
+
+void WorkerPool::run(unsigned numParts, const function<void(unsigned)>& body)
+{
+    // with one part or when someone else has the threads we just get on with it
+    bool wasBusy = false;
+    if (numParts <= 1 || threads.empty() || !busy.compare_exchange_strong(wasBusy, true))
+    {
+        for (unsigned i = 0; i < numParts; ++i) body(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->body = &body;
+        this->numParts = numParts;
+        nextPart = 0;
+        numPartsDone = 0;
+        ++generation;
+    }
+    partsReady.notify_all();
+
+    // this thread takes parts as well rather than just waiting
+    doParts();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        partsDone.wait(lock, [&]() { return numPartsDone == this->numParts; });
+        this->body = NULL;
+    }
+    busy = false;
+}
+
+void WorkerPool::parallelFor(size_t size, unsigned numParts, const function<void(size_t, size_t)>& body)
+{
+    if (!size) return;
+    numParts = max(1u, (unsigned)min<size_t>(numParts, size));
+    run(numParts, [&](unsigned part)
+    {
+        body(size * part / numParts, size * (part + 1) / numParts);
+    });
+}
+
+void WorkerPool::doParts()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (body && nextPart < numParts)
+    {
+        const function<void(unsigned)>& partBody = *body;
+        const unsigned part = nextPart++;
+        lock.unlock();
+        partBody(part);
+        lock.lock();
+        if (++numPartsDone == numParts) partsDone.notify_all();
+    }
+}
+
+void WorkerPool::work()
+{
+    unsigned long lastGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        partsReady.wait(lock, [&]() { return closing || generation != lastGeneration; });
+        if (closing) return;
+        lastGeneration = generation;
+        lock.unlock();
+        doParts();
+        lock.lock();
+    }
+}
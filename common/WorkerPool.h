@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ofMain.h"
+
+// threads that are started once and then wait for parts of work to do
+//
+// starting threads on every call costs about as much as the work does when
+// it's only just big enough to split, e.g. a drag of the mesh deformer or a
+// frame of the laser's visibility, so everything shares one pool of threads
+// that are kept waiting instead
+//
+// the pool does one run() at a time, if it's busy when another thread, or
+// a part that's running, calls run() then that caller does all of its parts
+// itself rather than waiting, so nothing ever waits for anything but its own
+// parts and a run() inside a part can't deadlock
+class WorkerPool
+{
+public:
+    // the one pool everything shares, it's started the first time it's needed
+    static WorkerPool& get();
+
+    // numThreads of 0 means as many as there are cores, including the one
+    // that calls run()
+    WorkerPool(unsigned numThreads = 0);
+    ~WorkerPool();
+
+    // the threads are waiting on this object
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // the workers and the thread that calls run()
+    unsigned getNumThreads() const { return threads.size() + 1; }
+
+    // call body for every part in [0, numParts) and wait for them all,
+    // the calling thread takes parts as well
+    void run(unsigned numParts, const function<void(unsigned)>& body);
+
+    // split [0, size) into numParts nearly equal parts and call body with
+    // the beginning and end of each
+    void parallelFor(size_t size, unsigned numParts, const function<void(size_t, size_t)>& body);
+
+private:
+    // take parts until there are none left
+    void doParts();
+
+    void work();
+
+    vector<thread> threads;
+
+    // set while a run() is using the threads
+    atomic<bool> busy;
+
+    // the run() that's going, shared by all of the threads
+    std::mutex mutex;
+    std::condition_variable partsReady;
+    std::condition_variable partsDone;
+    const function<void(unsigned)>* body;
+    unsigned numParts;
+    unsigned nextPart;
+    unsigned numPartsDone;
+    unsigned long generation;
+    bool closing;
+};
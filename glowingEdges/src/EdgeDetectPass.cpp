@@ -0,0 +1,170 @@
+#include "EdgeDetectPass.h"
+
+namespace
+{
+    // passes the position in the camera's space through so that the
+    // fragment shader can work out the normal from how it changes
+    const string GBUFFER_VERTEX_SOURCE = R"(
+        varying vec3 viewPosition;
+
+        void main()
+        {
+            vec4 position = gl_ModelViewMatrix * gl_Vertex;
+            viewPosition = position.xyz;
+            gl_Position = gl_ProjectionMatrix * position;
+        }
+    )";
+
+    // the face's normal comes from how the position changes from one pixel
+    // to the next, the depth goes in alpha so that zero means nothing is there,
+    // the normals only get compared with each other so which way they point
+    // doesn't matter as long as it's the same everywhere
+    const string GBUFFER_FRAGMENT_SOURCE = R"(
+        varying vec3 viewPosition;
+
+        void main()
+        {
+            vec3 normal = normalize(cross(dFdx(viewPosition), dFdy(viewPosition)));
+            gl_FragColor = vec4(normal, -viewPosition.z);
+        }
+    )";
+
+    // the image coming into the pass is a rectangle texture when the post
+    // processing was set up with arb, it's read with source() which takes
+    // coordinates from 0 to 1 either way, the g-buffer is always 2d
+    const string SOURCE_HEADER = R"(
+        #ifdef ARB
+            #extension GL_ARB_texture_rectangle : enable
+            uniform sampler2DRect tex;
+            uniform vec2 texSize;
+            vec4 source(vec2 uv) { return texture2DRect(tex, uv * texSize); }
+        #else
+            uniform sampler2D tex;
+            vec4 source(vec2 uv) { return texture2D(tex, uv); }
+        #endif
+    )";
+
+    // looks at the neighbours half the line width away on each side, which
+    // makes the edge the line width wide as both sides of it see it
+    const string EDGE_SOURCE = R"(
+        uniform sampler2D gBuffer;
+        uniform vec2 offset;
+        uniform float minCos;
+        uniform float depthThreshold;
+        uniform vec4 colour;
+
+        float isEdge(vec4 centre, vec4 neighbour)
+        {
+            bool centreCovered = centre.a > 0.0;
+            bool neighbourCovered = neighbour.a > 0.0;
+            if (centreCovered != neighbourCovered) return 1.0;
+            if (!centreCovered) return 0.0;
+            if (dot(centre.xyz, neighbour.xyz) < minCos) return 1.0;
+            return abs(centre.a - neighbour.a) > depthThreshold * min(centre.a, neighbour.a) ? 1.0 : 0.0;
+        }
+
+        void main()
+        {
+            vec2 uv = gl_TexCoord[0].st;
+            vec4 centre = texture2D(gBuffer, uv);
+            float edge = max(max(isEdge(centre, texture2D(gBuffer, uv + vec2(offset.x, 0.0))),
+                                 isEdge(centre, texture2D(gBuffer, uv - vec2(offset.x, 0.0)))),
+                             max(isEdge(centre, texture2D(gBuffer, uv + vec2(0.0, offset.y))),
+                                 isEdge(centre, texture2D(gBuffer, uv - vec2(0.0, offset.y)))));
+            vec4 image = source(uv);
+            gl_FragColor = vec4(mix(image.rgb, colour.rgb, edge * colour.a), image.a);
+        }
+    )";
+}
+
+EdgeDetectPass::EdgeDetectPass(const ofVec2f& aspect, bool arb) :
+    RenderPass(aspect, arb, "edge detect"),
+    colour(0.f, 1.f, 0.f),
+    lineWidth(4.f),
+    creaseAngle(30.f),
+    depthThreshold(.05f),
+    previousFramebuffer(0)
+{
+    gBufferShader.setupShaderFromSource(GL_VERTEX_SHADER, GBUFFER_VERTEX_SOURCE);
+    gBufferShader.setupShaderFromSource(GL_FRAGMENT_SHADER, GBUFFER_FRAGMENT_SOURCE);
+    gBufferShader.linkProgram();
+    edgeShader.setupShaderFromSource(GL_FRAGMENT_SHADER, (arb ? "#define ARB\n" : "") + SOURCE_HEADER + EDGE_SOURCE);
+    edgeShader.linkProgram();
+}
+
+void EdgeDetectPass::beginGBuffer()
+{
+    // we're inside ofxPostProcessing's frame buffer so the viewport is its size
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (!gBuffer.isAllocated() || gBuffer.getWidth() != viewport[2] || gBuffer.getHeight() != viewport[3])
+    {
+        // the depth needs more precision than 8 bits and the normals go negative
+        ofFbo::Settings settings;
+        settings.width = viewport[2];
+        settings.height = viewport[3];
+        settings.textureTarget = GL_TEXTURE_2D;
+        settings.useDepth = true;
+        settings.minFilter = GL_NEAREST;
+        settings.maxFilter = GL_NEAREST;
+        settings.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+        settings.wrapModeVertical = GL_CLAMP_TO_EDGE;
+#ifdef TARGET_OPENGLES
+        settings.internalformat = GL_RGBA;
+#else
+        settings.internalformat = GL_RGBA32F;
+#endif
+        gBuffer.allocate(settings);
+    }
+
+    // bind the g-buffer directly rather than with begin() so that the camera,
+    // the transforms and the viewport stay as ofxPostProcessing set them up
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColour);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.getId());
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // the normals and depths have to be written as they are, blending
+    // them with what's behind them would give edges that aren't there
+    ofPushStyle();
+    ofDisableBlendMode();
+    gBufferShader.begin();
+}
+
+void EdgeDetectPass::endGBuffer()
+{
+    gBufferShader.end();
+    ofPopStyle();
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glClearColor(previousClearColour[0], previousClearColour[1], previousClearColour[2], previousClearColour[3]);
+}
+
+void EdgeDetectPass::render(ofFbo& readFbo, ofFbo& writeFbo)
+{
+    ofPushStyle();
+    ofDisableBlendMode();
+    writeFbo.begin();
+
+    // nothing has been drawn into the g-buffer yet so there aren't any edges
+    if (!gBuffer.isAllocated())
+    {
+        readFbo.draw(0, 0);
+        writeFbo.end();
+        ofPopStyle();
+        return;
+    }
+
+    edgeShader.begin();
+    edgeShader.setUniformTexture("tex", readFbo.getTexture(), 0);
+    edgeShader.setUniformTexture("gBuffer", gBuffer.getTexture(), 1);
+    edgeShader.setUniform2f("texSize", readFbo.getWidth(), readFbo.getHeight());
+    edgeShader.setUniform2f("offset", .5f * lineWidth / writeFbo.getWidth(), .5f * lineWidth / writeFbo.getHeight());
+    edgeShader.setUniform1f("minCos", cos(ofDegToRad(creaseAngle)));
+    edgeShader.setUniform1f("depthThreshold", depthThreshold);
+    edgeShader.setUniform4f("colour", colour.r, colour.g, colour.b, colour.a);
+    texturedQuad(0, 0, writeFbo.getWidth(), writeFbo.getHeight());
+    edgeShader.end();
+    writeFbo.end();
+    ofPopStyle();
+}
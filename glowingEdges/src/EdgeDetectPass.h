@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxPostProcessing.h"
+
+// finds the edges of whatever has been drawn into its g-buffer and draws
+// them over the image, as an alternative to drawing an outline mesh
+//
+// the outline mesh has to be made for each model and costs more the more
+// edges it has, this instead looks at the surface as the camera sees it:
+// while the scene is drawn the meshes are drawn again between beginGBuffer()
+// and endGBuffer(), which writes the flat normal and the distance from the
+// camera of every pixel, then when the pass renders each pixel compares
+// itself with its neighbours and is an edge if one of them is
+//
+// - a silhouette: one of them is covered and the other isn't
+// - a crease: their normals are more than creaseAngle degrees apart
+// - in front of another part: they're far apart in depth
+//
+// so it costs the same per pixel whatever the model, the normals are worked
+// out from the positions in the fragment shader so they're right however
+// the mesh has been warped and the mesh doesn't need any of its own
+//
+// the edges are drawn in the colour given, create this before the blooms
+// so that they glow in the same way as the outline mesh does, e.g.
+// postProcessing.createPass<EdgeDetectPass>()->setColour(ofColor::green);
+class EdgeDetectPass : public itg::RenderPass
+{
+public:
+    typedef shared_ptr<EdgeDetectPass> Ptr;
+
+    EdgeDetectPass(const ofVec2f& aspect, bool arb);
+
+    // call these around drawing the meshes inside ofxPostProcessing::begin()
+    // and end(), they're drawn with the same camera and transforms into the
+    // g-buffer, which is made the same size as what's being drawn into,
+    // blending is off in between and the style is put back afterwards
+    void beginGBuffer();
+    void endGBuffer();
+
+    void render(ofFbo& readFbo, ofFbo& writeFbo);
+
+    void setColour(const ofFloatColor& colour) { this->colour = colour; }
+    const ofFloatColor& getColour() const { return colour; }
+
+    // how wide the edges are in pixels
+    void setLineWidth(float lineWidth) { this->lineWidth = lineWidth; }
+    float getLineWidth() const { return lineWidth; }
+
+    // neighbours whose normals are further apart than this are a crease
+    void setCreaseAngle(float creaseAngle) { this->creaseAngle = creaseAngle; }
+    float getCreaseAngle() const { return creaseAngle; }
+
+    // neighbours whose depths are further apart than this fraction of
+    // their depth are on different parts of the surface
+    void setDepthThreshold(float depthThreshold) { this->depthThreshold = depthThreshold; }
+    float getDepthThreshold() const { return depthThreshold; }
+
+    ofFbo& getGBuffer() { return gBuffer; }
+
+private:
+    ofFloatColor colour;
+    float lineWidth;
+    float creaseAngle;
+    float depthThreshold;
+
+    ofFbo gBuffer;
+    ofShader gBufferShader;
+    ofShader edgeShader;
+
+    // what we change while drawing into the g-buffer so that it can be put back
+    GLint previousFramebuffer;
+    GLfloat previousClearColour[4];
+};
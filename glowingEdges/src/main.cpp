@@ -1,13 +1,33 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "HeadlessBenchmark.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	// --compare-edges path draws the glowing edges with the outline mesh and
+	// with the edge detection pass, times them, compares them and saves them
+	// as pathmesh.png and pathpass.png, e.g.
+	// xvfb-run ./glowingEdges --benchmark --frames 1 --compare-edges edges-
+	// --compare-blooms times the original bloom and each quality of the mip
+	// bloom at 1080p and 4K whatever the size of the window
+	ofApp* app = new ofApp();
+	for (int i = 1; i < argc; ++i)
+	{
+		const string argument = argv[i];
+		if (argument == "--compare-edges" && i + 1 < argc) app->setEdgeComparison(argv[++i]);
+		else if (argument == "--compare-blooms") app->setBloomComparison(true);
+	}
+
+	// run with --benchmark to render a fixed number of frames in a hidden
+	// window and write out how long they took rather than running normally
+	HeadlessBenchmark::Settings benchmark;
+	if (benchmark.parse(argc, argv)) return HeadlessBenchmark::run(app, benchmark);
+
 	ofSetupOpenGL(1024, 768, OF_FULLSCREEN);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofRunApp(app);
 
 }
@@ -25,20 +25,75 @@ const unsigned ofApp::OUTLINE_INDICES[] = {
     0,4, 1,5, 2,6, 3,7
 };
 
+namespace
+{
+    // the original bloom blurs in its own small fbos that the scissor box,
+    // which is in pixels of the screen, doesn't line up with, so it always
+    // does the whole image and the scissor is only used by the other passes
+    class UnscissoredBloomPass : public BloomPass
+    {
+    public:
+        UnscissoredBloomPass(const ofVec2f& aspect, bool arb) : BloomPass(aspect, arb) {}
+
+        void render(ofFbo& readFbo, ofFbo& writeFbo)
+        {
+            const bool scissored = glIsEnabled(GL_SCISSOR_TEST);
+            if (scissored) glDisable(GL_SCISSOR_TEST);
+            BloomPass::render(readFbo, writeFbo);
+            if (scissored) glEnable(GL_SCISSOR_TEST);
+        }
+    };
+}
+
+//--------------------------------------------------------------
+ofApp::ofApp() :
+    compareBlooms(false)
+{
+}
+
 //--------------------------------------------------------------
 void ofApp::setup()
 {
-    // set some openFrameworks settings
-    ofSetFrameRate(60);
+    // set some openFrameworks settings, the frames are
+    // paced to the display's refresh rather than 60fps
+    framePacer.setup();
     ofBackground(0);
     
-    // check whether we've previously saved meshes
-    if (ofFile("outline.ply").exists() && ofFile("box.ply").exists())
+    // check whether we've previously saved meshes, we save them as binary
+    // as well as ply because the binary versions are much quicker to load,
+    // unless a ply has been changed since, both are loaded before either
+    // is used so we never end up with one from each
+    const unsigned long long meshLoadStart = ofGetElapsedTimeMicros();
+    ofMesh binaryOutline;
+    ofMesh binaryBox;
+    if (BinaryMesh::isUpToDate("outline.mesh", "outline.ply") && BinaryMesh::isUpToDate("box.mesh", "box.ply") &&
+        BinaryMesh::load("outline.mesh", binaryOutline) && BinaryMesh::load("box.mesh", binaryBox))
+    {
+        outlineMesh = binaryOutline;
+        boxMesh = binaryBox;
+        ofLogNotice("ofApp") << "loaded binary meshes in " << (ofGetElapsedTimeMicros() - meshLoadStart) / 1000.f << "ms";
+    }
+    else if (ofFile("outline.ply").exists() && ofFile("box.ply").exists())
     {
         // we have saved meshes so load them up
         outlineMesh.load("outline.ply");
         outlineMesh.setMode(OF_PRIMITIVE_LINES);
         boxMesh.load("box.ply");
+        ofLogNotice("ofApp") << "loaded ply meshes in " << (ofGetElapsedTimeMicros() - meshLoadStart) / 1000.f << "ms";
+    }
+    else if (ofFile("model.ply").exists())
+    {
+        // any other model has its outline worked out from where its surface
+        // folds, like the box the model itself is drawn very slightly smaller
+        // than its outline so that the outline isn't hidden by it
+        ofMesh model;
+        model.load("model.ply");
+        FeatureEdgeExtractor::Stats stats;
+        outlineMesh = FeatureEdgeExtractor::extract(model, 30.f, .001f, 0, &stats);
+        FeatureEdgeExtractor::scaleAboutCentre(model, .999f);
+        boxMesh = model;
+        ofLogNotice("ofApp") << "extracted " << outlineMesh.getNumIndices() / 2 << " outline edges from "
+                             << stats.numTriangles << " triangles in " << stats.totalMillis << "ms";
     }
     else
     {
@@ -90,6 +145,9 @@ void ofApp::setup()
     projectorPosition.addListener(this, &ofApp::projectorPositionChanged);
     projectorTilt.addListener(this, &ofApp::projectorTiltChanged);
     boxAngle.addListener(this, &ofApp::boxAngleChanged);
+    bloomMode.addListener(this, &ofApp::bloomModeChanged);
+    scissorEffects.addListener(this, &ofApp::scissorEffectsChanged);
+    edgeMode.addListener(this, &ofApp::edgeModeChanged);
     
     // set up user interface so we can tweak the projection
     gui.setup();
@@ -100,15 +158,74 @@ void ofApp::setup()
                                   ofVec3f(-10.f, 20.f, -150.f),
                                   ofVec3f(10.f, 50.f, -100.f)));
     
+    // 0 is the original full resolution bloom, 1 to 3 are the low,
+    // medium and high quality versions of the mip bloom
+    gui.add(bloomMode.set("bloomMode", 0, 0, 3));
+    
+    // 0 draws the outline mesh, 1 finds the edges of the box mesh as
+    // the projector sees it, which works for any model
+    gui.add(edgeMode.set("edgeMode", MESH_EDGES, MESH_EDGES, PASS_EDGES));
+    
+    // only run the post processing over the part of the screen that the box
+    // covers plus some padding for the glow, this needs one of the mip blooms
+    // because the original bloom blurs into its own smaller frame buffers
+    gui.add(scissorEffects.set("scissorEffects", true));
+    gui.add(scissorPadding.set("scissorPadding", 100.f, 0.f, 400.f));
+    postProcessingMillis[0] = 0.f;
+    postProcessingMillis[1] = 0.f;
+    
+    gui.add(framePacer.parameters);
+    
     // load the settings from the previous time we ran the application
     gui.loadFromFile("settings.xml");
     
+    // load the settings and the ply meshes again if they're changed while
+    // we're running, the outline has to stay as lines
+    hotReloader.addSettings(gui.getParameter(), "settings.xml");
+    hotReloader.addMesh(boxMesh, "box.ply");
+    hotReloader.addMesh(outlineMesh, "outline.ply");
+    hotReloader.setListener([this](const string& path)
+    {
+        if (path == "outline.ply") outlineMesh.setMode(OF_PRIMITIVE_LINES);
+    });
+    hotReloader.setup();
+    
+    // the gui's save button writes settings.xml while we're watching it
+    ofAddListener(gui.savePressedE, this, &ofApp::savePressed);
+    
     // initialise the post processing
     outlineEffects.init();
     
-    // add a bloom (glow) pass to the post processing chain
-    outlineEffects.createPass<BloomPass>();
+    // add a bloom (glow) pass to the post processing chain, we add both
+    // kinds of bloom and bloomMode decides which one of them is used, the
+    // edges are found before the blooms so that they glow as well
+    edgeDetectPass = outlineEffects.createPass<EdgeDetectPass>();
+    bloomPass = outlineEffects.createPass<UnscissoredBloomPass>();
+    mipBloomPass = outlineEffects.createPass<MipBloomPass>();
     outlineEffects.createPass<FxaaPass>();
+    
+    // time the scene, the post processing as a whole and each pass
+    // inside it, and the gui so that we can see what is expensive
+    sceneStage = profiler.addStage("scene");
+    postProcessingStage = profiler.addStage("postProcessing");
+    profiler.timePasses(outlineEffects, "  ");
+    guiStage = profiler.addStage("gui");
+    drawProfiler = false;
+    
+    // the settings were loaded before the passes existed so pick the bloom
+    // and the edges now
+    int mode = bloomMode;
+    bloomModeChanged(mode);
+    mode = edgeMode;
+    edgeModeChanged(mode);
+    
+    if (!edgeComparisonPath.empty()) ofLogNotice("ofApp") << "edge comparison" << endl << compareEdges(edgeComparisonPath);
+    if (compareBlooms)
+    {
+        ofLogNotice("ofApp") << "bloom comparison" << endl
+                             << MipBloomPass::benchmark(1920, 1080) << endl
+                             << MipBloomPass::benchmark(3840, 2160);
+    }
 }
 
 //--------------------------------------------------------------
@@ -120,12 +237,65 @@ void ofApp::update()
 //--------------------------------------------------------------
 void ofApp::draw()
 {
+    profiler.beginFrame();
+    
     // look at the scene from the perspective of the projector
     // when using ofxPostProcessing with a camera object we do this
     // by passing the camera to the ofxPostProcessing::begin()
     // function as an argument
     outlineEffects.begin(projector);
+    profiler.begin(sceneStage);
+    drawScene();
+    profiler.end(sceneStage);
+    
+    // finish drawing the scene from the perspective of the projector
+    // this is where all of the post processing passes are run
+    profiler.begin(postProcessingStage);
+    
+    // the scissor test stops anything being drawn outside of the rectangle
+    // so the post processing passes only do any work for the pixels inside
+    // it, the rest of the screen is left as it was cleared at the start,
+    // the edges and fxaa are scissored whichever bloom we're using but the
+    // original bloom still does the whole screen, only the mip bloom doesn't
+    const bool scissor = scissorEffects;
+    if (scissor)
+    {
+        effectsRegion = getEffectsRegion();
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(effectsRegion.x, effectsRegion.y, effectsRegion.width, effectsRegion.height);
+    }
+    else effectsRegion.set(0.f, 0.f, ofGetWidth(), ofGetHeight());
+    
+    outlineEffects.end();
+    
+    if (scissor) glDisable(GL_SCISSOR_TEST);
+    profiler.end(postProcessingStage);
+    postProcessingMillis[scissor] = profiler.getAverageMillis(postProcessingStage);
+    
+    profiler.begin(guiStage);
+    gui.draw();
+    profiler.end(guiStage);
+    
+    if (drawProfiler)
+    {
+        profiler.draw(gui.getPosition().x, gui.getShape().getBottom() + 30.f);
+        
+        // show how much of the screen we're post processing and how long it
+        // takes with and without the scissor, toggle scissorEffects to fill in both
+        const float coverage = effectsRegion.getArea() / (ofGetWidth() * ofGetHeight());
+        ofDrawBitmapStringHighlight("post processing coverage: " + ofToString(100.f * coverage, 1) + "%" +
+                                    "\npost processing full frame (ms): " + ofToString(postProcessingMillis[0], 2) +
+                                    "\npost processing scissored (ms): " + ofToString(postProcessingMillis[1], 2) +
+                                    "\nsaved per frame (ms): " + ofToString(postProcessingMillis[0] - postProcessingMillis[1], 2) +
+                                    "\n" + framePacer.getStatus(),
+                                    gui.getPosition().x, ofGetHeight() - 100.f);
+    }
     
+    profiler.endFrame();
+}
+
+void ofApp::drawScene()
+{
     // rotate our box around the y axis
     // so it's not face on to the projector
     ofPushMatrix();
@@ -139,40 +309,140 @@ void ofApp::draw()
     ofSetColor(10);
     boxMesh.draw();
     
-    // we set the line width of the box to be drawn to 3
-    // I'm using this function for convenience, however please note
-    // that this function does not work if you are using the programmable
-    // renderer in openFrameworks as it is based on functionality no
-    // longer present in newer versions of OpenGL
-    ofSetLineWidth(4.f);
-    
-    // now draw a glowing green outline
-    // we want the outline to pulsate slightly, so we map sin(ofGetElapsedTimef())
+    // we want the outline to pulsate slightly, so we map sin() of the elapsed time
     // from its initial range (-1 to 1) to between 127 (half brightness)
     // and 255 (full brightness)
-    ofSetColor(0, ofMap(sin(ofGetElapsedTimef()), -1.f, 1.f, 127.f, 255.f), 0);
-    outlineMesh.draw();
+    const ofColor outlineColour(0, ofMap(sin(HeadlessBenchmark::getElapsedTimef()), -1.f, 1.f, 127.f, 255.f), 0);
+    
+    if (edgeMode == MESH_EDGES)
+    {
+        // we set the line width of the box to be drawn to 3
+        // I'm using this function for convenience, however please note
+        // that this function does not work if you are using the programmable
+        // renderer in openFrameworks as it is based on functionality no
+        // longer present in newer versions of OpenGL
+        ofSetLineWidth(4.f);
+        
+        // now draw a glowing green outline
+        ofSetColor(outlineColour);
+        outlineMesh.draw();
+    }
+    else
+    {
+        // draw the box again into the edge pass's g-buffer, the pass
+        // draws the edges it finds in it in the same colour and width
+        edgeDetectPass->setColour(outlineColour);
+        edgeDetectPass->setLineWidth(4.f);
+        edgeDetectPass->beginGBuffer();
+        boxMesh.draw();
+        edgeDetectPass->endGBuffer();
+    }
     
     // disable depth testing
     ofDisableDepthTest();
     
     // reset the transform to what it was before we rotated it
     ofPopMatrix();
+}
+
+string ofApp::compareEdges(const string& path)
+{
+    // enough frames that the time isn't just the first one
+    const unsigned numWarmupFrames = 10;
+    const unsigned numFrames = 100;
     
-    // finish drawing the scene from the perspective of the projector
-    outlineEffects.end();
+    // a pixel whose red, green or blue is further apart than this between
+    // the two is counted as different, and one greener than this is lit
+    const int differentThreshold = 32;
+    const int litThreshold = 64;
     
-    gui.draw();
+    const int previousEdgeMode = edgeMode;
+    ofFbo result;
+    result.allocate(ofGetWidth(), ofGetHeight(), GL_RGB);
+    ofPixels pixels[2];
+    float millis[2];
+    unsigned long long start = 0;
+    
+    // every frame is drawn with the post processing but not put on the
+    // screen, waiting for the gpu to finish before and after each lot of
+    // frames means the time is of the gpu's work and not just the cpu's
+    for (int mode = MESH_EDGES; mode <= PASS_EDGES; ++mode)
+    {
+        edgeMode = mode;
+        for (unsigned i = 0; i < numWarmupFrames + numFrames; ++i)
+        {
+            if (i == numWarmupFrames)
+            {
+                glFinish();
+                start = ofGetElapsedTimeMicros();
+            }
+            outlineEffects.begin(projector);
+            drawScene();
+            outlineEffects.end(false);
+        }
+        glFinish();
+        millis[mode] = (ofGetElapsedTimeMicros() - start) / 1000.f / numFrames;
+        
+        result.begin();
+        ofClear(0, 255);
+        ofSetColor(255);
+        outlineEffects.draw(0, 0, result.getWidth(), result.getHeight());
+        result.end();
+        result.readToPixels(pixels[mode]);
+        if (!path.empty()) ofSaveImage(pixels[mode], path + (mode == MESH_EDGES ? "mesh" : "pass") + ".png");
+    }
+    edgeMode = previousEdgeMode;
+    
+    // how far apart the two images are and how much of each of them is lit up by the edges
+    unsigned long totalDifference = 0;
+    unsigned numDifferent = 0;
+    unsigned numLit[2] = { 0, 0 };
+    const unsigned numPixels = pixels[0].getWidth() * pixels[0].getHeight();
+    for (unsigned i = 0; i < numPixels; ++i)
+    {
+        int difference = 0;
+        for (unsigned j = 0; j < 3; ++j) difference = max(difference, abs(pixels[0][3 * i + j] - pixels[1][3 * i + j]));
+        totalDifference += difference;
+        if (difference > differentThreshold) ++numDifferent;
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            if (pixels[j][3 * i + 1] > litThreshold) ++numLit[j];
+        }
+    }
+    
+    stringstream report;
+    report << fixed << setprecision(3)
+           << "mesh: " << millis[MESH_EDGES] << "ms a frame, " << numLit[MESH_EDGES] << " pixels lit" << endl
+           << "pass: " << millis[PASS_EDGES] << "ms a frame, " << numLit[PASS_EDGES] << " pixels lit" << endl
+           << "difference: " << (float)totalDifference / max(1u, numPixels) << " on average, "
+           << 100.f * numDifferent / max(1u, numPixels) << "% of pixels differ by more than " << differentThreshold;
+    return report.str();
 }
 
 void ofApp::exit()
 {
+    // say how well we kept up with the display
+    ofLogNotice("ofApp") << "frame pacing: " << framePacer.getStatus();
+    
+    // stop watching the files before we save them ourselves
+    hotReloader.close();
+    
+    // finish writing the frame times if we were
+    profiler.stopCsv();
+    
+    // a benchmark only renders frames, it mustn't save over the
+    // settings and meshes that the app loads next time it's run
+    if (HeadlessBenchmark::isRunning()) return;
+    
     // save the settings
     gui.saveToFile("settings.xml");
     
-    // save the meshes
+    // save the meshes, ply so they can be opened in other
+    // software and binary so they load quickly next time
     boxMesh.save("box.ply");
     outlineMesh.save("outline.ply");
+    BinaryMesh::save(boxMesh, "box.mesh");
+    BinaryMesh::save(outlineMesh, "outline.mesh");
 }
 
 void ofApp::projectorPositionChanged(ofVec3f& projectorPosition)
@@ -196,9 +466,101 @@ void ofApp::boxAngleChanged(float& boxAngle)
     outlineMesh.setTransform(rotation);
 }
 
+void ofApp::bloomModeChanged(int& bloomMode)
+{
+    // this gets called when the settings are loaded before there are any passes
+    if (!bloomPass || !mipBloomPass) return;
+    
+    FrameProfiler::setPassEnabled(outlineEffects, bloomPass, bloomMode == 0);
+    FrameProfiler::setPassEnabled(outlineEffects, mipBloomPass, bloomMode > 0);
+    if (bloomMode > 0) mipBloomPass->setQuality((MipBloomPass::Quality)(bloomMode - 1));
+    logUnscissoredBloom();
+}
+
+void ofApp::edgeModeChanged(int& edgeMode)
+{
+    // this gets called when the settings are loaded before there are any passes
+    if (!edgeDetectPass) return;
+    
+    FrameProfiler::setPassEnabled(outlineEffects, edgeDetectPass, edgeMode == PASS_EDGES);
+    profiler.clearHistory();
+}
+
+void ofApp::scissorEffectsChanged(bool& scissorEffects)
+{
+    // start the averages again so they only include frames with the new setting
+    profiler.clearHistory();
+    logUnscissoredBloom();
+}
+
+void ofApp::logUnscissoredBloom()
+{
+    // so the time saved isn't a surprise when the original bloom is picked
+    if (scissorEffects && bloomMode == 0)
+    {
+        ofLogNotice("ofApp") << "the original bloom does the whole screen with scissorEffects on, "
+                             << "only the edges and fxaa are scissored, bloomMode 1 to 3 scissor the bloom too";
+    }
+}
+
+ofRectangle ofApp::getEffectsRegion() const
+{
+    const float width = ofGetWidth();
+    const float height = ofGetHeight();
+    const ofRectangle screen(0.f, 0.f, width, height);
+    
+    // rotate the outline in the same way as when we draw it, and then
+    // project it in the same way as the projector camera does
+    const ofMatrix4x4 rotation = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
+    const ofMatrix4x4 modelViewProjection = rotation * projector.getModelViewProjectionMatrix(screen);
+    
+    ofRectangle region;
+    const ofMesh& mesh = outlineMesh;
+    for (unsigned i = 0; i < mesh.getNumVertices(); ++i)
+    {
+        // if any of the box is behind the projector then we can't
+        // project it properly so we play it safe and do everything
+        const ofVec3f world = mesh.getVertex(i) * rotation;
+        if ((world - projector.getGlobalPosition()).dot(projector.getLookAtDir()) < projector.getNearClip()) return screen;
+        
+        // normalised device coordinates go from -1 to 1 with y pointing up
+        const ofVec3f ndc = mesh.getVertex(i) * modelViewProjection;
+        const ofPoint pixel((.5f * ndc.x + .5f) * width, (.5f * ndc.y + .5f) * height);
+        if (i == 0) region.set(pixel, 0.f, 0.f);
+        else region.growToInclude(pixel);
+    }
+    
+    // leave room for the glow and round outwards to whole pixels
+    region.standardize();
+    region.x = floor(region.x - scissorPadding);
+    region.y = floor(region.y - scissorPadding);
+    region.width = ceil(region.width + 2.f * scissorPadding) + 1.f;
+    region.height = ceil(region.height + 2.f * scissorPadding) + 1.f;
+    return region.getIntersection(screen);
+}
+
+bool ofApp::savePressed()
+{
+    // save it ourselves rather than letting the gui do it so that we can tell
+    // the hot reloader it's us and it doesn't load the settings back in
+    gui.saveToFile("settings.xml");
+    hotReloader.fileSaved("settings.xml");
+    return true;
+}
+
 void ofApp::keyPressed(int key)
 {
     if (key == 'f') ofToggleFullscreen();
+    else if (key == 'l') ofLogNotice("ofApp") << "mesh load benchmark: " << BinaryMesh::benchmark();
+    else if (key == 'o') ofLogNotice("ofApp") << "outline extraction benchmark: " << FeatureEdgeExtractor::benchmark();
+    else if (key == 'e') ofLogNotice("ofApp") << "edge comparison" << endl << compareEdges("");
+    else if (key == 'p') drawProfiler = !drawProfiler;
+    else if (key == 'c')
+    {
+        // start or stop writing the time of every stage of every frame to a csv
+        if (profiler.isWritingCsv()) profiler.stopCsv();
+        else profiler.startCsv("profile-" + ofGetTimestampString() + ".csv");
+    }
 }
 
 //--------------------------------------------------------------
@@ -3,7 +3,15 @@
 #include "ofMain.h"
 #include "ofxPostProcessing.h"
 #include "ofxWarpableMesh.h"
+#include "BinaryMesh.h"
+#include "HeadlessBenchmark.h"
+#include "FrameProfiler.h"
+#include "MipBloomPass.h"
 #include "ofxGui.h"
+#include "FramePacer.h"
+#include "HotReloader.h"
+#include "FeatureEdgeExtractor.h"
+#include "EdgeDetectPass.h"
 
 class ofApp : public ofBaseApp
 {
@@ -14,6 +22,25 @@ public:
     static const unsigned NUM_OUTLINE_INDICES = 24;
     static const unsigned OUTLINE_INDICES[NUM_OUTLINE_INDICES];
     
+    // the two ways of drawing the glowing edges, edgeMode in the gui picks one
+    enum EdgeMode
+    {
+        // draw outlineMesh as lines
+        MESH_EDGES,
+        // find the edges of boxMesh in screen space with EdgeDetectPass
+        PASS_EDGES
+    };
+    
+    ofApp();
+    
+    // draw the edges both ways once we're set up, time them and save
+    // what each of them looks like with path in front of their names,
+    // call this before the app is run
+    void setEdgeComparison(const string& path) { edgeComparisonPath = path; }
+    
+    // time the blooms at 1080p and 4K once we're set up, call this before the app is run
+    void setBloomComparison(bool compareBlooms) { this->compareBlooms = compareBlooms; }
+    
     void setup();
     void update();
     void draw();
@@ -30,9 +57,32 @@ public:
     void gotMessage(ofMessage msg);
 
 private:
+    // saves the settings when the gui's save button is pressed
+    bool savePressed();
+    
     void projectorPositionChanged(ofVec3f& projectorPosition);
     void projectorTiltChanged(float& projectorTilt);
     void boxAngleChanged(float& boxAngle);
+    void bloomModeChanged(int& bloomMode);
+    void scissorEffectsChanged(bool& scissorEffects);
+    void edgeModeChanged(int& edgeMode);
+    
+    // says so when scissorEffects doesn't cover the bloom
+    void logUnscissoredBloom();
+    
+    // draws the box and its edges, this goes between
+    // outlineEffects.begin() and outlineEffects.end()
+    void drawScene();
+    
+    // draws the scene with each edge mode for a number of frames, returns how
+    // long each one took and how different they look, and saves what they
+    // look like if path isn't empty
+    string compareEdges(const string& path);
+    
+    // works out the part of the screen that the box and its glow cover
+    // by projecting the outline through the projector, the rectangle is in
+    // opengl's pixel coordinates so (0, 0) is the bottom left of the screen
+    ofRectangle getEffectsRegion() const;
     
     ofCamera projector;
     ofxWarpableMesh boxMesh;
@@ -41,9 +91,43 @@ private:
     // post processing effects
     ofxPostProcessing outlineEffects;
     
+    // the original full resolution bloom and the cheaper one that works on
+    // smaller copies of the image, only one of these is enabled at a time
+    shared_ptr<BloomPass> bloomPass;
+    MipBloomPass::Ptr mipBloomPass;
+    
+    // finds the edges in screen space when we're not drawing the outline mesh
+    EdgeDetectPass::Ptr edgeDetectPass;
+    string edgeComparisonPath;
+    bool compareBlooms;
+    
     // user interface
     ofxPanel gui;
     ofParameter<ofVec3f> projectorPosition;
     ofParameter<float> projectorTilt;
     ofParameter<float> boxAngle;
+    ofParameter<int> bloomMode;
+    ofParameter<int> edgeMode;
+    ofParameter<bool> scissorEffects;
+    ofParameter<float> scissorPadding;
+    
+    // the part of the screen that we ran the post processing over last frame
+    ofRectangle effectsRegion;
+    
+    // the average time the post processing takes with and without
+    // the scissor so we can see how much time we're saving
+    float postProcessingMillis[2];
+    
+    // times each part of the frame on the cpu and the gpu
+    FrameProfiler profiler;
+    unsigned sceneStage;
+    unsigned postProcessingStage;
+    unsigned guiStage;
+    bool drawProfiler;
+    
+    // waits for the display to refresh rather than a fixed frame rate
+    FramePacer framePacer;
+    
+    // loads the settings and meshes again when they change on disk
+    HotReloader hotReloader;
 };
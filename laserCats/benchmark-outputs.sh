@@ -0,0 +1,29 @@
+#!/bin/sh
+# times laserCats with 1 to 4 outputs side by side in the benchmark window,
+# every output the same size, to see how the cost of a frame grows with the
+# number of projectors, the eq, the remaps and the edge blend masks are
+# made once a frame whatever the number of outputs so each output after the
+# first should cost less than the first did
+#
+# ./benchmark-outputs.sh [output width] [output height] [other arguments]
+# e.g. LIBGL_ALWAYS_SOFTWARE=1 ./benchmark-outputs.sh 1280 720 --null-audio
+# writes outputs1.json to outputs4.json and prints a row for each of them
+set -e
+cd "$(dirname "$0")"
+outputWidth=${1:-1280}
+outputHeight=${2:-720}
+shift 2 2>/dev/null || shift $#
+
+run=""
+if [ -z "$DISPLAY" ]; then run="xvfb-run -a -s \"-screen 0 $((4 * outputWidth))x${outputHeight}x24\""; fi
+
+echo "outputs, window, draw ms (median), ms per output, times one output"
+for outputs in 1 2 3 4; do
+    eval $run ./bin/laserCats --benchmark --outputs $outputs \
+        --width $((outputs * outputWidth)) --height $outputHeight \
+        --output outputs$outputs.json "$@" > /dev/null 2>&1
+    median=$(sed -n 's/.*"drawMillis": { "min": [^,]*, "median": \([^,]*\),.*/\1/p' outputs$outputs.json)
+    if [ $outputs = 1 ]; then single=$median; fi
+    awk -v n=$outputs -v w=$((outputs * outputWidth)) -v h=$outputHeight -v m=$median -v s=$single \
+        'BEGIN { printf "%d, %dx%d, %.3f, %.3f, %.2f\n", n, w, h, m, m / n, m / s }'
+done
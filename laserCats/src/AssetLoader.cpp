@@ -0,0 +1,123 @@
+#include "AssetLoader.h"
+
+AssetLoader::AssetLoader() :
+    nextAsset(0),
+    numFinished(0),
+    startMicros(0),
+    doneMicros(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    close();
+}
+
+void AssetLoader::add(const string& name, Load load, Finish finish)
+{
+    unique_ptr<Asset> asset(new Asset());
+    asset->name = name;
+    asset->load = load;
+    asset->finish = finish;
+    asset->succeeded = false;
+    asset->loadMicros = 0;
+    asset->loaded = false;
+    asset->finished = false;
+    asset->finishMicros = 0;
+    asset->readyMicros = 0;
+    assets.push_back(move(asset));
+}
+
+void AssetLoader::start(unsigned numThreads)
+{
+    // there's no point having more threads than there are assets
+    if (!numThreads || numThreads > assets.size()) numThreads = assets.size();
+
+    startMicros = ofGetElapsedTimeMicros();
+    for (unsigned i = 0; i < numThreads; ++i) threads.push_back(thread(&AssetLoader::loadAssets, this));
+}
+
+void AssetLoader::loadAssets()
+{
+    for (unsigned i = nextAsset++; i < assets.size(); i = nextAsset++)
+    {
+        Asset& asset = *assets[i];
+        const unsigned long long start = ofGetElapsedTimeMicros();
+        asset.succeeded = asset.load();
+        asset.loadMicros = ofGetElapsedTimeMicros() - start;
+        asset.loaded.store(true, memory_order_release);
+    }
+}
+
+bool AssetLoader::finishAsset(Asset& asset)
+{
+    if (asset.finished || !asset.loaded.load(memory_order_acquire)) return false;
+
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    if (!asset.succeeded) ofLogWarning("AssetLoader") << "couldn't load " << asset.name;
+    if (asset.finish) asset.finish(asset.succeeded);
+    const unsigned long long now = ofGetElapsedTimeMicros();
+    asset.finishMicros = now - start;
+    asset.readyMicros = now - startMicros;
+    asset.finished = true;
+
+    // everything is done so the threads will be too
+    if (++numFinished == assets.size())
+    {
+        doneMicros = now - startMicros;
+        close();
+    }
+    return true;
+}
+
+bool AssetLoader::update()
+{
+    for (unique_ptr<Asset>& asset : assets) finishAsset(*asset);
+    return isDone();
+}
+
+void AssetLoader::finish()
+{
+    while (!update()) this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+void AssetLoader::close()
+{
+    for (thread& t : threads) t.join();
+    threads.clear();
+}
+
+float AssetLoader::getProgress() const
+{
+    if (assets.empty()) return 1.f;
+
+    // loading and finishing each count for half of an asset
+    unsigned numLoaded = 0;
+    for (const unique_ptr<Asset>& asset : assets)
+    {
+        if (asset->loaded.load(memory_order_relaxed)) ++numLoaded;
+    }
+    return (numLoaded + numFinished) / (2.f * assets.size());
+}
+
+string AssetLoader::getReport() const
+{
+    stringstream report;
+    report << fixed << setprecision(1);
+    if (isDone()) report << assets.size() << " assets ready after " << doneMicros / 1000.f << "ms";
+    else report << numFinished << " of " << assets.size() << " assets ready";
+
+    for (const unique_ptr<Asset>& asset : assets)
+    {
+        report << endl << "  " << asset->name << ": ";
+        if (!asset->finished)
+        {
+            report << "not ready";
+            continue;
+        }
+        report << asset->loadMicros / 1000.f << "ms loading, " << asset->finishMicros / 1000.f
+               << "ms finishing, ready after " << asset->readyMicros / 1000.f << "ms";
+        if (!asset->succeeded) report << " (failed)";
+    }
+    return report.str();
+}
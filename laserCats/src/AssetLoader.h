@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ofMain.h"
+
+// loads the app's files on a pool of threads while the render thread gets on
+// with setting everything else up
+//
+// each asset has a load function that does the slow part, reading and
+// decoding the file, on one of the threads, and an optional finish function
+// that does whatever has to be done on the render thread, e.g. uploading a
+// texture, once it's loaded, the finish functions are run from update() or
+// finish() on the render thread in the order that the assets finish loading
+//
+// the time that each asset took to load and to finish is kept so we can see
+// where the time before the first frame goes
+class AssetLoader
+{
+public:
+    // load returns false if the asset couldn't be loaded, finish
+    // is still called so it can fall back to something else
+    typedef function<bool()> Load;
+    typedef function<void(bool loaded)> Finish;
+
+    AssetLoader();
+    ~AssetLoader();
+
+    // add the assets before calling start()
+    void add(const string& name, Load load, Finish finish = nullptr);
+
+    // start loading on numThreads threads, 0 means one for each asset as
+    // most of them spend much of their time waiting for the disk
+    void start(unsigned numThreads = 0);
+
+    // run the finish functions of anything that has loaded since we last
+    // looked, returns true once every asset has loaded and finished
+    bool update();
+
+    // wait for everything to load, finishing each asset as it arrives
+    void finish();
+
+    // wait for the threads without finishing anything, e.g. if
+    // the app is closed before everything has loaded
+    void close();
+
+    bool isDone() const { return numFinished == assets.size(); }
+
+    // between 0 and 1, how much of the loading and finishing has been done
+    float getProgress() const;
+
+    // how long each asset took and how long it was before everything was ready
+    string getReport() const;
+
+private:
+    struct Asset
+    {
+        string name;
+        Load load;
+        Finish finish;
+
+        // written by the thread that loads it before loaded is set,
+        // the rest is only touched on the render thread
+        bool succeeded;
+        unsigned long long loadMicros;
+        atomic<bool> loaded;
+        bool finished;
+        unsigned long long finishMicros;
+        unsigned long long readyMicros;
+    };
+
+    // each thread takes the next asset nobody has started on until there are none left
+    void loadAssets();
+
+    // finish the asset if it's loaded, returns true if it was finished by this call
+    bool finishAsset(Asset& asset);
+
+    // the assets are never moved once they've been added as the threads point into them
+    vector<unique_ptr<Asset> > assets;
+    atomic<unsigned> nextAsset;
+    unsigned numFinished;
+
+    vector<thread> threads;
+    unsigned long long startMicros;
+    unsigned long long doneMicros;
+};
@@ -0,0 +1,62 @@
+#include "AudioAnalysisThread.h"
+
+AudioAnalysisThread::AudioAnalysisThread() : periodMillis(5), sequence(0)
+{
+}
+
+void AudioAnalysisThread::setup(unsigned numRawBins, unsigned numBands)
+{
+    analyser.setup(numRawBins, numBands);
+
+    // size all of the snapshots up front so the analysis
+    // thread never has to allocate any memory
+    SpectrumSnapshot empty;
+    empty.normalised.assign(numBands, 0.f);
+    empty.timeMicros = ofGetElapsedTimeMicros();
+    empty.sequence = 0;
+    snapshots.fill(empty);
+}
+
+void AudioAnalysisThread::startPolling(unsigned periodMillis)
+{
+    this->periodMillis = periodMillis;
+    startThread();
+}
+
+bool AudioAnalysisThread::update()
+{
+    return snapshots.update();
+}
+
+unsigned long long AudioAnalysisThread::getSnapshotAgeMicros() const
+{
+    return ofGetElapsedTimeMicros() - getSnapshot().timeMicros;
+}
+
+void AudioAnalysisThread::analyse(const float* spectrum, float elapsedSeconds)
+{
+    const unsigned long long timeMicros = ofGetElapsedTimeMicros();
+    analyser.update(spectrum, elapsedSeconds);
+
+    // fill in the back buffer and hand it over to the render thread
+    SpectrumSnapshot& snapshot = snapshots.getWriteBuffer();
+    copy(analyser.getNormalised(), analyser.getNormalised() + analyser.getNumBands(), snapshot.normalised.begin());
+    snapshot.timeMicros = timeMicros;
+    snapshot.sequence = ++sequence;
+    snapshots.publish();
+}
+
+void AudioAnalysisThread::threadedFunction()
+{
+    // we don't wake up exactly every periodMillis so the
+    // bands fall by however long it's really been
+    unsigned long long lastMicros = ofGetElapsedTimeMicros();
+    while (isThreadRunning())
+    {
+        // capture and analyse the spectrum
+        const unsigned long long nowMicros = ofGetElapsedTimeMicros();
+        analyse(ofSoundGetSpectrum(analyser.getNumRawBins()), (nowMicros - lastMicros) / 1000000.f);
+        lastMicros = nowMicros;
+        sleep(periodMillis);
+    }
+}
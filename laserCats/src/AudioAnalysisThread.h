@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"
+#include "SpectrumAnalyser.h"
+#include "TripleBuffer.h"
+
+// the bands from one run of the analysis
+struct SpectrumSnapshot
+{
+    // values between 0 and 1 for each band
+    vector<float> normalised;
+
+    // when the spectrum was captured, in microseconds since the app started
+    unsigned long long timeMicros;
+
+    // goes up by one every time the analysis runs
+    unsigned long long sequence;
+};
+
+// analyses the spectrum away from the render thread so that slow frames
+// don't hold up the analysis and the analysis doesn't take time away from
+// drawing, each result is handed to the render thread through a lock free
+// triple buffer
+//
+// the spectrum either comes from polling ofSoundGetSpectrum() on this
+// object's own thread or is pushed in with analyse() from somewhere else,
+// like the audio thread, but only one of these should be used at a time
+class AudioAnalysisThread : public ofThread
+{
+public:
+    AudioAnalysisThread();
+
+    // numRawBins and numBands are passed on to the SpectrumAnalyser
+    void setup(unsigned numRawBins, unsigned numBands);
+
+    // start a thread that captures the spectrum from ofSoundPlayer
+    // every periodMillis milliseconds
+    void startPolling(unsigned periodMillis = 5);
+
+    // analyse a spectrum of numRawBins values and publish the result,
+    // elapsedSeconds is how much audio there's been since the last one
+    void analyse(const float* spectrum, float elapsedSeconds);
+
+    // call this from the render thread once per frame to pick
+    // up the latest snapshot, returns true if there's a new one
+    bool update();
+
+    // the latest snapshot as of the last call to update()
+    const SpectrumSnapshot& getSnapshot() const { return snapshots.getReadBuffer(); }
+
+    // how old the latest snapshot is in microseconds
+    unsigned long long getSnapshotAgeMicros() const;
+
+private:
+    void threadedFunction();
+
+    SpectrumAnalyser analyser;
+    TripleBuffer<SpectrumSnapshot> snapshots;
+    unsigned periodMillis;
+    unsigned long long sequence;
+};
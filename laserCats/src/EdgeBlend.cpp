@@ -0,0 +1,682 @@
+#include "EdgeBlend.h"
+#include "WorkerPool.h"
+
+#include <sys/stat.h>
+#ifdef TARGET_WIN32
+    #include <sys/utime.h>
+#else
+    #include <utime.h>
+#endif
+
+namespace
+{
+    const char MAGIC[4] = { 'P', 'M', 'E', 'B' };
+    const uint32_t VERSION = 1;
+
+    // each thread gets at least this many rows of the masks
+    const unsigned MIN_ROWS_PER_THREAD = 8;
+
+    // while a calibration is being dragged the masks change every frame, we
+    // only save them once they've stayed the same for this long so that the
+    // cache doesn't fill up with every step along the way
+    const float SAVE_DELAY_MILLIS = 1000.f;
+
+    // about two triangles in each cell of the grids, but no more cells than this across
+    const unsigned MAX_GRID_SIZE = 64;
+
+    // how far, as a fraction of the image, past the corners of a triangle
+    // its cells go, so that rays that only just hit it still find it
+    const float GRID_PADDING = 1e-3f;
+
+    // multiplies the mask with the projector's image, the texture
+    // coordinates of both are the same as they're the same size
+    const string BLEND_SOURCE = R"(
+        uniform sampler2D content;
+        uniform sampler2D blend;
+        uniform float inverseGamma;
+
+        void main()
+        {
+            vec4 colour = texture2D(content, gl_TexCoord[0].st);
+            float weight = pow(texture2D(blend, gl_TexCoord[0].st).r, inverseGamma);
+            gl_FragColor = gl_Color * vec4(colour.rgb * weight, colour.a);
+        }
+    )";
+
+    // 64 bit FNV-1a
+    void hashBytes(uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    bool isSameProjector(const EdgeBlend::Projector& a, const EdgeBlend::Projector& b)
+    {
+        return a.width == b.width && a.height == b.height && a.position == b.position &&
+               !memcmp(a.modelViewProjection.getPtr(), b.modelViewProjection.getPtr(), 16 * sizeof(float));
+    }
+
+    unsigned getMaskSize(unsigned size, unsigned scale)
+    {
+        return max(1u, (size + scale - 1) / scale);
+    }
+
+    // goes from 0 at the edge of the image to 1 feather in from it, u and
+    // v are where we are in the image from 0 to 1, and smoothly so there's
+    // no visible line where the fade starts
+    float getEdgeWeight(float u, float v, float feather)
+    {
+        const float distance = min(min(u, 1.f - u), min(v, 1.f - v));
+        const float t = ofClamp(distance / feather, 0.f, 1.f);
+        return t * t * (3.f - 2.f * t);
+    }
+
+    // split [0, size) between up to maxThreads of the shared pool's threads and call body with each part
+    void parallelFor(unsigned size, unsigned maxThreads, const function<void(unsigned, unsigned)>& body)
+    {
+        const unsigned numThreads = ofClamp(size / MIN_ROWS_PER_THREAD, 1, max(1u, maxThreads));
+        WorkerPool::get().parallelFor(size, numThreads, [&](size_t begin, size_t end)
+        {
+            body(begin, end);
+        });
+    }
+}
+
+EdgeBlend::Projector::Projector() :
+    width(0),
+    height(0)
+{
+}
+
+EdgeBlend::Projector::Projector(const ofCamera& camera, unsigned width, unsigned height) :
+    modelViewProjection(camera.getModelViewProjectionMatrix(ofRectangle(0, 0, width, height))),
+    position(camera.getGlobalPosition()),
+    width(width),
+    height(height)
+{
+}
+
+EdgeBlend::EdgeBlend() :
+    maxCacheBytes(64ull << 20),
+    scale(4),
+    feather(.15f),
+    dirty(true),
+    meshDirty(false),
+    requestNumber(0),
+    masksRequest(0),
+    needsCompute(false),
+    active(false),
+    workerDone(false),
+    cacheKey(0),
+    pendingSave(false),
+    lastChangeMillis(0),
+    lastComputeMillis(0.f),
+    numComputes(0),
+    numCacheLoads(0)
+{
+}
+
+EdgeBlend::~EdgeBlend()
+{
+    if (worker.joinable()) worker.join();
+}
+
+void EdgeBlend::setup(const string& cacheDirectory, unsigned scale, unsigned maxCacheMegabytes)
+{
+    this->cacheDirectory = cacheDirectory;
+    maxCacheBytes = (uint64_t)maxCacheMegabytes << 20;
+    this->scale = max(1u, scale);
+    dirty = true;
+
+    shader.setupShaderFromSource(GL_FRAGMENT_SHADER, BLEND_SOURCE);
+    shader.linkProgram();
+}
+
+void EdgeBlend::setFeather(float feather)
+{
+    if (feather == this->feather) return;
+    this->feather = feather;
+    dirty = true;
+}
+
+bool EdgeBlend::update(const vector<Projector>& projectors, const ofMesh& mesh, const ofMatrix4x4& transform)
+{
+    // with only one projector it lights everything it can on its own
+    if (projectors.size() < 2)
+    {
+        masks.clear();
+        textures.clear();
+        lastProjectors.clear();
+        pendingSave = false;
+        needsCompute = false;
+
+        // anything the worker is still making is for projectors we don't have any more
+        masksRequest = ++requestNumber;
+        return false;
+    }
+
+    bool changed = dirty || meshDirty || projectors.size() != lastProjectors.size() ||
+                   memcmp(transform.getPtr(), lastTransform.getPtr(), 16 * sizeof(float));
+    for (unsigned i = 0; i < projectors.size() && !changed; ++i)
+    {
+        changed = !isSameProjector(projectors[i], lastProjectors[i]);
+    }
+
+    bool updated = false;
+    if (changed)
+    {
+        // masks we've made before are quick enough to load here, anything
+        // else is left to the worker and we keep the masks we have until then
+        ++requestNumber;
+        requestTriangles = getTriangles(mesh, transform);
+        cacheKey = getKey(projectors, requestTriangles);
+        pendingSave = false;
+        const string path = getCachePath(cacheKey);
+        if (ofFile(path).exists() && load(path, projectors))
+        {
+            ++numCacheLoads;
+            masksRequest = requestNumber;
+            needsCompute = false;
+            updateTextures();
+            updated = true;
+
+            // so it's the last to go when the cache is trimmed
+            utime(ofToDataPath(path, true).c_str(), NULL);
+        }
+        else
+        {
+            needsCompute = true;
+        }
+        lastChangeMillis = ofGetElapsedTimeMillis();
+
+        lastProjectors = projectors;
+        lastTransform = transform;
+        dirty = false;
+        meshDirty = false;
+    }
+
+    // masks the worker has finished are used even if something has changed
+    // since it started as they're closer than the ones we have, as long as
+    // we haven't loaded newer ones in the mean time
+    if (worker.joinable() && workerDone)
+    {
+        worker.join();
+        lastComputeMillis = job.millis;
+        ++numComputes;
+        if (job.request > masksRequest)
+        {
+            masks.swap(job.masks);
+            masksRequest = job.request;
+            updateTextures();
+            updated = true;
+
+            // they're only worth saving if they're for the latest change
+            if (job.request == requestNumber)
+            {
+                pendingSave = true;
+                lastChangeMillis = ofGetElapsedTimeMillis();
+            }
+        }
+        job.masks.clear();
+    }
+
+    if (needsCompute && !worker.joinable())
+    {
+        job.request = requestNumber;
+        job.projectors = projectors;
+        job.triangles = requestTriangles;
+        job.feather = feather;
+        job.scale = scale;
+        needsCompute = false;
+        workerDone = false;
+        worker = thread([this]()
+        {
+            const unsigned long long start = ofGetElapsedTimeMicros();
+            computeMasks(job.projectors, job.triangles, job.feather, job.scale, WorkerPool::get().getNumThreads(), true,
+                         job.masks);
+            job.millis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+            workerDone = true;
+        });
+    }
+    else if (pendingSave && ofGetElapsedTimeMillis() - lastChangeMillis > SAVE_DELAY_MILLIS)
+    {
+        if (save(getCachePath(cacheKey))) trimCache();
+        pendingSave = false;
+    }
+    return updated;
+}
+
+void EdgeBlend::updateTextures()
+{
+    // the masks are smooth so linear filtering scales them up nicely
+    textures.resize(masks.size());
+    for (unsigned i = 0; i < masks.size(); ++i)
+    {
+        if (!textures[i].isAllocated() || textures[i].getWidth() != masks[i].getWidth() ||
+            textures[i].getHeight() != masks[i].getHeight())
+        {
+            textures[i].allocate(masks[i]);
+            textures[i].setTextureWrap(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        }
+        textures[i].loadData(masks[i]);
+    }
+}
+
+void EdgeBlend::begin(unsigned projector, float gamma)
+{
+    if (projector >= textures.size()) return;
+
+    shader.begin();
+    shader.setUniform1i("content", 0);
+    shader.setUniformTexture("blend", textures[projector], 1);
+    shader.setUniform1f("inverseGamma", 1.f / max(gamma, .01f));
+    active = true;
+}
+
+void EdgeBlend::end()
+{
+    if (!active) return;
+    shader.end();
+    active = false;
+}
+
+vector<EdgeBlend::Triangle> EdgeBlend::getTriangles(const ofMesh& mesh, const ofMatrix4x4& transform)
+{
+    vector<Triangle> triangles;
+    if (mesh.getMode() != OF_PRIMITIVE_TRIANGLES)
+    {
+        ofLogWarning("EdgeBlend") << "only meshes made of separate triangles can be blended";
+        return triangles;
+    }
+
+    const vector<ofVec3f>& vertices = mesh.getVertices();
+    const unsigned numIndices = mesh.hasIndices() ? mesh.getNumIndices() : vertices.size();
+    triangles.reserve(numIndices / 3);
+    for (unsigned i = 0; i + 2 < numIndices; i += 3)
+    {
+        ofVec3f corners[3];
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            corners[j] = vertices[mesh.hasIndices() ? mesh.getIndex(i + j) : i + j] * transform;
+        }
+
+        Triangle triangle;
+        triangle.corner = corners[0];
+        triangle.edge1 = corners[1] - corners[0];
+        triangle.edge2 = corners[2] - corners[0];
+        triangles.push_back(triangle);
+    }
+    return triangles;
+}
+
+EdgeBlend::Grid EdgeBlend::makeGrid(const Projector& projector, const vector<Triangle>& triangles, unsigned maxSize)
+{
+    Grid grid;
+    grid.size = ofClamp(sqrt(triangles.size() / 2.f), 1, max(1u, maxSize));
+    grid.cells.resize(grid.size * grid.size);
+    auto getCell = [&grid](float value)
+    {
+        return (unsigned)ofClamp(value * grid.size, 0.f, grid.size - 1.f);
+    };
+
+    for (unsigned i = 0; i < triangles.size(); ++i)
+    {
+        // where the triangle is in the image, from 0 to 1 like the masks
+        const ofVec3f corners[3] =
+        {
+            triangles[i].corner, triangles[i].corner + triangles[i].edge1, triangles[i].corner + triangles[i].edge2
+        };
+        ofVec2f low(numeric_limits<float>::max());
+        ofVec2f high(-numeric_limits<float>::max());
+        bool behind = false;
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            const ofVec4f clip = ofVec4f(corners[j].x, corners[j].y, corners[j].z, 1.f) * projector.modelViewProjection;
+            if (clip.w <= 0.f)
+            {
+                behind = true;
+                break;
+            }
+            const ofVec2f point(.5f * (clip.x / clip.w + 1.f), .5f * (clip.y / clip.w + 1.f));
+            low.set(min(low.x, point.x), min(low.y, point.y));
+            high.set(max(high.x, point.x), max(high.y, point.y));
+        }
+        if (behind)
+        {
+            grid.everywhere.push_back(i);
+            continue;
+        }
+
+        // rays only go through the image so anything outside it can't be hit
+        low -= ofVec2f(GRID_PADDING, GRID_PADDING);
+        high += ofVec2f(GRID_PADDING, GRID_PADDING);
+        if (high.x < 0.f || high.y < 0.f || low.x > 1.f || low.y > 1.f) continue;
+        for (unsigned y = getCell(low.y); y <= getCell(high.y); ++y)
+        {
+            for (unsigned x = getCell(low.x); x <= getCell(high.x); ++x) grid.cells[y * grid.size + x].push_back(i);
+        }
+    }
+    return grid;
+}
+
+float EdgeBlend::intersect(const vector<Triangle>& triangles, const vector<unsigned>& candidates, const ofVec3f& origin,
+                           const ofVec3f& direction, float minDistance, float maxDistance, bool findNearest)
+{
+    // möller-trumbore, both sides of the triangles count as we're
+    // also looking for the back of the box getting in the way
+    float nearest = -1.f;
+    for (unsigned i : candidates)
+    {
+        const Triangle& triangle = triangles[i];
+        const ofVec3f p = direction.getCrossed(triangle.edge2);
+        const float determinant = triangle.edge1.dot(p);
+        if (determinant == 0.f) continue;
+        const float inverseDeterminant = 1.f / determinant;
+
+        const ofVec3f t = origin - triangle.corner;
+        const float u = t.dot(p) * inverseDeterminant;
+        if (u < 0.f || u > 1.f) continue;
+
+        const ofVec3f q = t.getCrossed(triangle.edge1);
+        const float v = direction.dot(q) * inverseDeterminant;
+        if (v < 0.f || u + v > 1.f) continue;
+
+        const float distance = triangle.edge2.dot(q) * inverseDeterminant;
+        if (distance < minDistance || distance > maxDistance) continue;
+        if (!findNearest) return distance;
+        if (nearest < 0.f || distance < nearest) nearest = distance;
+    }
+    return nearest;
+}
+
+float EdgeBlend::intersect(const vector<Triangle>& triangles, const Grid& grid, float u, float v, const ofVec3f& origin,
+                           const ofVec3f& direction, float minDistance, float maxDistance, bool findNearest)
+{
+    float nearest = intersect(triangles, grid.everywhere, origin, direction, minDistance, maxDistance, findNearest);
+    if (nearest >= 0.f && !findNearest) return nearest;
+
+    const unsigned x = ofClamp(u * grid.size, 0.f, grid.size - 1.f);
+    const unsigned y = ofClamp(v * grid.size, 0.f, grid.size - 1.f);
+    const float inCell = intersect(triangles, grid.cells[y * grid.size + x], origin, direction,
+                                   minDistance, maxDistance, findNearest);
+    if (inCell >= 0.f && (nearest < 0.f || inCell < nearest)) nearest = inCell;
+    return nearest;
+}
+
+void EdgeBlend::computeMasks(const vector<Projector>& projectors, const vector<Triangle>& triangles, float feather,
+                             unsigned scale, unsigned maxThreads, bool useGrids, vector<ofFloatPixels>& masks)
+{
+    // all of the rows of all of the masks are shared out between the
+    // threads together so that they all finish at about the same time
+    masks.resize(projectors.size());
+    vector<ofMatrix4x4> inverses(projectors.size());
+    vector<Grid> grids(projectors.size());
+    vector<unsigned> firstRows(projectors.size() + 1, 0);
+    for (unsigned i = 0; i < projectors.size(); ++i)
+    {
+        masks[i].allocate(getMaskSize(projectors[i].width, scale), getMaskSize(projectors[i].height, scale), 1);
+        inverses[i] = projectors[i].modelViewProjection.getInverse();
+        grids[i] = makeGrid(projectors[i], triangles, useGrids ? MAX_GRID_SIZE : 1);
+        firstRows[i + 1] = firstRows[i] + masks[i].getHeight();
+    }
+
+    parallelFor(firstRows.back(), maxThreads, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned row = begin; row < end; ++row)
+        {
+            const unsigned i = upper_bound(firstRows.begin(), firstRows.end(), row) - firstRows.begin() - 1;
+            ofFloatPixels& mask = masks[i];
+            const unsigned width = mask.getWidth();
+            const unsigned height = mask.getHeight();
+
+            // the first row is the bottom of the image like it is in
+            // the frame buffer that the mask is going to be applied to
+            const unsigned y = row - firstRows[i];
+            const float v = (y + .5f) / height;
+            float* pixels = mask.getData() + y * width;
+
+            for (unsigned x = 0; x < width; ++x)
+            {
+                // fire a ray from the projector through the middle of the pixel,
+                // anything that doesn't land on the box is left as it is
+                const float u = (x + .5f) / width;
+                const ofVec3f near = ofVec3f(2.f * u - 1.f, 2.f * v - 1.f, -1.f) * inverses[i];
+                const ofVec3f far = ofVec3f(2.f * u - 1.f, 2.f * v - 1.f, 1.f) * inverses[i];
+                const ofVec3f direction = far - near;
+                const float distance = intersect(triangles, grids[i], u, v, near, direction, 0.f, 1.f, true);
+                if (distance < 0.f)
+                {
+                    pixels[x] = 1.f;
+                    continue;
+                }
+                const ofVec3f point = near + distance * direction;
+
+                // this projector's share is how far it is from the edge of its
+                // image compared to every other projector that can see the point
+                const float weight = getEdgeWeight(u, v, feather);
+                float totalWeight = weight;
+                for (unsigned j = 0; j < projectors.size(); ++j)
+                {
+                    if (j == i) continue;
+
+                    const ofVec4f clip = ofVec4f(point.x, point.y, point.z, 1.f) * projectors[j].modelViewProjection;
+                    if (clip.w <= 0.f) continue;
+                    const float otherU = .5f * (clip.x / clip.w + 1.f);
+                    const float otherV = .5f * (clip.y / clip.w + 1.f);
+                    if (otherU < 0.f || otherU > 1.f || otherV < 0.f || otherV > 1.f) continue;
+
+                    const float otherWeight = getEdgeWeight(otherU, otherV, feather);
+                    if (otherWeight <= 0.f) continue;
+
+                    // the other projector only helps if the box isn't in the way, the
+                    // ray to its eye goes through the point where it sees this one
+                    if (intersect(triangles, grids[j], otherU, otherV, point, projectors[j].position - point,
+                                  1e-3f, 1.f, false) >= 0.f)
+                    {
+                        continue;
+                    }
+                    totalWeight += otherWeight;
+                }
+                pixels[x] = totalWeight > 0.f ? weight / totalWeight : 1.f;
+            }
+        }
+    });
+}
+
+uint64_t EdgeBlend::getKey(const vector<Projector>& projectors, const vector<Triangle>& triangles) const
+{
+    uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, &VERSION, sizeof(VERSION));
+    hashBytes(hash, &scale, sizeof(scale));
+    hashBytes(hash, &feather, sizeof(feather));
+    for (unsigned i = 0; i < projectors.size(); ++i)
+    {
+        hashBytes(hash, projectors[i].modelViewProjection.getPtr(), 16 * sizeof(float));
+        hashBytes(hash, projectors[i].position.getPtr(), 3 * sizeof(float));
+        hashBytes(hash, &projectors[i].width, sizeof(projectors[i].width));
+        hashBytes(hash, &projectors[i].height, sizeof(projectors[i].height));
+    }
+    if (!triangles.empty()) hashBytes(hash, &triangles[0], triangles.size() * sizeof(Triangle));
+    return hash;
+}
+
+string EdgeBlend::getCachePath(uint64_t key) const
+{
+    stringstream name;
+    name << hex << setw(16) << setfill('0') << key << ".blend";
+    return ofFilePath::join(cacheDirectory, name.str());
+}
+
+bool EdgeBlend::load(const string& path, const vector<Projector>& projectors)
+{
+    ifstream file(ofToDataPath(path, true).c_str(), ios::binary);
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t numMasks = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&numMasks, sizeof(numMasks));
+    if (!file || memcmp(magic, MAGIC, sizeof(MAGIC)) || version != VERSION || numMasks != projectors.size())
+    {
+        ofLogError("EdgeBlend") << path << " isn't an edge blend for " << projectors.size() << " projectors";
+        return false;
+    }
+
+    vector<ofFloatPixels> loaded(numMasks);
+    for (unsigned i = 0; i < numMasks; ++i)
+    {
+        uint32_t size[2] = { 0, 0 };
+        file.read((char*)size, sizeof(size));
+        if (!file || size[0] != getMaskSize(projectors[i].width, scale) || size[1] != getMaskSize(projectors[i].height, scale))
+        {
+            ofLogError("EdgeBlend") << path << " has masks of the wrong size";
+            return false;
+        }
+        loaded[i].allocate(size[0], size[1], 1);
+        file.read((char*)loaded[i].getData(), size[0] * size[1] * sizeof(float));
+        if (!file)
+        {
+            ofLogError("EdgeBlend") << path << " is truncated";
+            return false;
+        }
+    }
+    masks.swap(loaded);
+    return true;
+}
+
+bool EdgeBlend::save(const string& path) const
+{
+    ofDirectory::createDirectory(cacheDirectory, true, true);
+
+    // write to a temporary file and then move it into place so
+    // that we never leave a half written file behind
+    const string absolutePath = ofToDataPath(path, true);
+    const string temporaryPath = absolutePath + ".tmp";
+    {
+        ofstream file(temporaryPath.c_str(), ios::binary | ios::trunc);
+        if (!file)
+        {
+            ofLogError("EdgeBlend") << "couldn't open " << temporaryPath << " for writing";
+            return false;
+        }
+
+        const uint32_t numMasks = masks.size();
+        file.write(MAGIC, sizeof(MAGIC));
+        file.write((const char*)&VERSION, sizeof(VERSION));
+        file.write((const char*)&numMasks, sizeof(numMasks));
+        for (unsigned i = 0; i < masks.size(); ++i)
+        {
+            const uint32_t size[2] = { (uint32_t)masks[i].getWidth(), (uint32_t)masks[i].getHeight() };
+            file.write((const char*)size, sizeof(size));
+            file.write((const char*)masks[i].getData(), size[0] * size[1] * sizeof(float));
+        }
+
+        if (!file)
+        {
+            ofLogError("EdgeBlend") << "couldn't write " << temporaryPath;
+            return false;
+        }
+    }
+    return ofFile::moveFromTo(temporaryPath, absolutePath, false, true);
+}
+
+void EdgeBlend::trimCache() const
+{
+    // a file's modified time is when it was last saved or loaded so
+    // the ones that go first are the ones we've used least recently
+    ofDirectory directory(cacheDirectory);
+    directory.allowExt("blend");
+    directory.listDir();
+    vector<pair<time_t, string> > files;
+    uint64_t totalBytes = 0;
+    for (unsigned i = 0; i < directory.size(); ++i)
+    {
+        const string path = directory.getFile(i).getAbsolutePath();
+        struct stat info;
+        if (stat(path.c_str(), &info)) continue;
+        files.push_back(make_pair(info.st_mtime, path));
+        totalBytes += info.st_size;
+    }
+    sort(files.begin(), files.end());
+
+    // the newest always stays, even if it's bigger than the limit on its own
+    for (unsigned i = 0; i + 1 < files.size() && totalBytes > maxCacheBytes; ++i)
+    {
+        struct stat info;
+        if (stat(files[i].second.c_str(), &info) || !ofFile::removeFile(files[i].second, false)) continue;
+        totalBytes -= info.st_size;
+        ofLogVerbose("EdgeBlend") << "removed " << files[i].second << " from the cache";
+    }
+}
+
+string EdgeBlend::benchmark(unsigned numProjectors)
+{
+    // the box from the app, and one with each side split into a lot of
+    // triangles like a scanned model would be, lit by projectors spread
+    // around in front of it, each with its own part of a 1920x1080 window
+    // like the app has
+    vector<Projector> projectors;
+    for (unsigned i = 0; i < numProjectors; ++i)
+    {
+        const float angle = numProjectors > 1 ? ofMap(i, 0, numProjectors - 1, -40.f, 40.f) : 0.f;
+        ofCamera camera;
+        camera.setFov(16.84f);
+        camera.setPosition(ofVec3f(0.f, 0.f, -200.f).getRotated(angle, ofVec3f(0.f, 1.f, 0.f)));
+        camera.lookAt(ofVec3f(0.f, 0.f, 0.f));
+        projectors.push_back(Projector(camera, 1920 / numProjectors, 1080));
+    }
+
+    stringstream report;
+    const unsigned resolutions[2] = { 1, 24 };
+    for (unsigned resolution : resolutions)
+    {
+        const ofMesh box = ofMesh::box(26.65f, 26.65f, 11.f, resolution, resolution, resolution);
+        const vector<Triangle> triangles = getTriangles(box, ofMatrix4x4());
+
+        vector<ofFloatPixels> singleThreaded;
+        unsigned long long start = ofGetElapsedTimeMicros();
+        computeMasks(projectors, triangles, .15f, 4, 1, true, singleThreaded);
+        const float singleMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+
+        vector<ofFloatPixels> multiThreaded;
+        start = ofGetElapsedTimeMicros();
+        computeMasks(projectors, triangles, .15f, 4, WorkerPool::get().getNumThreads(), true, multiThreaded);
+        const float multiMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+
+        vector<ofFloatPixels> withoutGrids;
+        start = ofGetElapsedTimeMicros();
+        computeMasks(projectors, triangles, .15f, 4, WorkerPool::get().getNumThreads(), false, withoutGrids);
+        const float withoutGridsMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+
+        // they should all come up with exactly the same masks, we also count
+        // how much of each image is being faded out because of the overlap
+        unsigned numMismatches = 0;
+        unsigned numPixels = 0;
+        unsigned numBlended = 0;
+        for (unsigned i = 0; i < numProjectors; ++i)
+        {
+            const size_t size = singleThreaded[i].getWidth() * singleThreaded[i].getHeight();
+            for (size_t j = 0; j < size; ++j)
+            {
+                if (singleThreaded[i][j] != multiThreaded[i][j] || singleThreaded[i][j] != withoutGrids[i][j]) ++numMismatches;
+                if (singleThreaded[i][j] < 1.f) ++numBlended;
+            }
+            numPixels += size;
+        }
+
+        if (resolution != resolutions[0]) report << endl;
+        report << numProjectors << " projectors, " << triangles.size() << " triangles, "
+               << numPixels << " mask pixels (" << 100.f * numBlended / max(1u, numPixels) << "% blended): "
+               << "1 thread " << singleMillis << "ms, "
+               << WorkerPool::get().getNumThreads() << " threads " << multiMillis << "ms, "
+               << singleMillis / max(multiMillis, .001f) << " times faster, "
+               << "without the grids " << withoutGridsMillis << "ms, "
+               << withoutGridsMillis / max(multiMillis, .001f) << " times slower, "
+               << numMismatches << " mismatches";
+    }
+    return report.str();
+}
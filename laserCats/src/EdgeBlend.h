@@ -0,0 +1,196 @@
+#pragma once
+
+#include "ofMain.h"
+
+// soft edges where the projectors overlap on the box
+//
+// where two projectors light the same part of the box it comes out twice as
+// bright, so each projector's image is multiplied by a mask that fades it
+// out towards the edge of its image wherever another projector can take
+// over, the weights of all the projectors at any point on the box add up to
+// one so the brightness stays even across the overlap
+//
+// the masks only depend on where the projectors are and the shape of the
+// box so rather than working them out for every pixel every frame we work
+// them out on the cpu, on a thread of their own spread over all of the
+// cores, only when they change and keep them as textures, the old masks
+// carry on being used until the new ones are ready so dragging a projector
+// around never holds up a frame
+//
+// each ray we fire goes through one of the projectors' eyes so it stays in
+// the same place in that projector's image the whole way, the triangles are
+// put in a grid across each projector's image and a ray only has to be
+// tested against the triangles in the cell it goes through
+//
+// the masks are also saved to disk named after a hash of everything they
+// depend on so that a calibration we've used before loads straight away,
+// the files that haven't been used for longest are deleted when there are
+// too many of them
+class EdgeBlend
+{
+public:
+    // everything about a projector that the masks depend on
+    struct Projector
+    {
+        Projector();
+
+        // width and height are the size of the projector's image
+        Projector(const ofCamera& camera, unsigned width, unsigned height);
+
+        ofMatrix4x4 modelViewProjection;
+        ofVec3f position;
+        unsigned width;
+        unsigned height;
+    };
+
+    EdgeBlend();
+    ~EdgeBlend();
+
+    // the worker thread works on our masks
+    EdgeBlend(const EdgeBlend&) = delete;
+    EdgeBlend& operator=(const EdgeBlend&) = delete;
+
+    // compile the shader, this needs to be done after the window has been
+    // created, the masks are saved in cacheDirectory and are scale times
+    // smaller than the projectors' images, they're smooth so that's plenty,
+    // the oldest are deleted when they take up more than maxCacheMegabytes
+    void setup(const string& cacheDirectory = "edgeBlend", unsigned scale = 4, unsigned maxCacheMegabytes = 64);
+
+    // how far in from the edge of each image the fade goes, as a fraction of
+    // the image's size, the masks are worked out again if this changes
+    void setFeather(float feather);
+
+    // call this when the mesh's vertices move
+    void meshChanged() { meshDirty = true; }
+
+    // make sure there's a mask for each projector to light mesh with
+    // transform applied, the masks are only loaded or worked out again if
+    // something has changed, masks that have to be worked out are made on
+    // another thread and picked up by a later update, returns true if there
+    // are new masks, with fewer than two projectors there's nothing to blend
+    // and there are no masks
+    bool update(const vector<Projector>& projectors, const ofMesh& mesh, const ofMatrix4x4& transform);
+
+    // whether the masks in use are out of date and new ones are on their way
+    bool isComputing() const { return worker.joinable(); }
+
+    // draw a projector's final image between these to apply its mask, the
+    // mask is corrected for the projector's gamma so that the light adds up
+    // rather than the pixel values, nothing happens if there's no mask
+    void begin(unsigned projector, float gamma);
+    void end();
+
+    unsigned getNumMasks() const { return textures.size(); }
+    float getLastComputeMillis() const { return lastComputeMillis; }
+    unsigned getNumComputes() const { return numComputes; }
+    unsigned getNumCacheLoads() const { return numCacheLoads; }
+
+    // work out the masks for numProjectors projectors side by side around
+    // the box and a finely divided one with one thread and with all of them,
+    // and without the grids, and compare how long it takes
+    static string benchmark(unsigned numProjectors = 3);
+
+private:
+    // a triangle ready to have rays fired at it
+    struct Triangle
+    {
+        ofVec3f corner;
+        ofVec3f edge1;
+        ofVec3f edge2;
+    };
+
+    // every triangle of mesh with transform applied, only
+    // OF_PRIMITIVE_TRIANGLES meshes are supported
+    static vector<Triangle> getTriangles(const ofMesh& mesh, const ofMatrix4x4& transform);
+
+    // the triangles in front of each part of a projector's image
+    struct Grid
+    {
+        unsigned size;
+        vector<vector<unsigned> > cells;
+
+        // triangles that are partly behind the eye could be anywhere in the image
+        vector<unsigned> everywhere;
+    };
+
+    // the grid of triangles for projector, at most maxSize cells across
+    static Grid makeGrid(const Projector& projector, const vector<Triangle>& triangles, unsigned maxSize);
+
+    // where along the ray from origin in direction the nearest of candidates
+    // is hit, or a negative number if none of them are, only hits between
+    // minDistance and maxDistance count, the distances are in multiples of
+    // direction, with findNearest false we stop at the first hit we find
+    static float intersect(const vector<Triangle>& triangles, const vector<unsigned>& candidates, const ofVec3f& origin,
+                           const ofVec3f& direction, float minDistance, float maxDistance, bool findNearest);
+
+    // the same for a ray through the eye of grid's projector, which goes
+    // through u, v in the projector's image
+    static float intersect(const vector<Triangle>& triangles, const Grid& grid, float u, float v, const ofVec3f& origin,
+                           const ofVec3f& direction, float minDistance, float maxDistance, bool findNearest);
+
+    // the mask for every projector, at most maxThreads threads are used,
+    // useGrids false puts every triangle in one cell, for the benchmark
+    static void computeMasks(const vector<Projector>& projectors, const vector<Triangle>& triangles, float feather,
+                             unsigned scale, unsigned maxThreads, bool useGrids, vector<ofFloatPixels>& masks);
+
+    // put the masks into the textures
+    void updateTextures();
+
+    // a hash of everything the masks depend on, it's what the cache file is called
+    uint64_t getKey(const vector<Projector>& projectors, const vector<Triangle>& triangles) const;
+    string getCachePath(uint64_t key) const;
+
+    bool load(const string& path, const vector<Projector>& projectors);
+    bool save(const string& path) const;
+
+    // delete the least recently used masks until they fit in maxCacheBytes
+    void trimCache() const;
+
+    ofShader shader;
+    string cacheDirectory;
+    uint64_t maxCacheBytes;
+    unsigned scale;
+    float feather;
+
+    // what the masks were made for so we can tell when they need making again
+    vector<Projector> lastProjectors;
+    ofMatrix4x4 lastTransform;
+    bool dirty;
+    bool meshDirty;
+
+    // every change is numbered so we know whether the masks we have, or
+    // the ones the worker is making, are for the latest one
+    unsigned long requestNumber;
+    unsigned long masksRequest;
+    vector<Triangle> requestTriangles;
+    bool needsCompute;
+
+    vector<ofFloatPixels> masks;
+    vector<ofTexture> textures;
+    bool active;
+
+    // what the worker is making masks for, it's only touched here
+    // while the worker isn't running or once it's said it's done
+    struct Job
+    {
+        unsigned long request;
+        vector<Projector> projectors;
+        vector<Triangle> triangles;
+        float feather;
+        unsigned scale;
+        vector<ofFloatPixels> masks;
+        float millis;
+    };
+    Job job;
+    thread worker;
+    atomic<bool> workerDone;
+
+    // the masks we worked out are saved once they've settled down
+    uint64_t cacheKey;
+    bool pendingSave;
+    unsigned long long lastChangeMillis;
+
+    float lastComputeMillis;
+    unsigned numComputes;
+    unsigned numCacheLoads;
+};
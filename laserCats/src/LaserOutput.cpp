@@ -0,0 +1,866 @@
+#include "LaserOutput.h"
+#include "FeatureEdgeExtractor.h"
+#include "WorkerPool.h"
+
+#ifndef TARGET_WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // each thread gets at least this many edges of the outline
+    const unsigned MIN_EDGES_PER_THREAD = 64;
+
+    // ILDA format 5 is 2d points with a true colour each, every frame has a
+    // 32 byte header and each point is 8 bytes, the numbers are big endian
+    const uint8_t ILDA_FORMAT = 5;
+    const size_t ILDA_TOTAL_FRAMES_OFFSET = 28;
+    const uint8_t ILDA_LAST_POINT = 0x80;
+    const uint8_t ILDA_BLANKED = 0x40;
+
+    // the frame numbers and the number of points in a frame are 16 bits
+    const unsigned MAX_ILDA_FRAMES = 65535;
+    const unsigned MAX_ILDA_POINTS = 65535;
+
+    // a frame sent over udp is split so that each datagram stays under 64k
+    const unsigned MAX_UDP_POINTS = 8000;
+    const uint16_t DEFAULT_UDP_PORT = 7255;
+
+    // about two triangles in each cell of the grid, but no more cells than this across
+    const unsigned MAX_GRID_SIZE = 64;
+
+    // maxThreads of 0 means all of the shared pool's threads
+    unsigned getNumThreads(size_t size, unsigned maxThreads)
+    {
+        if (!maxThreads) maxThreads = WorkerPool::get().getNumThreads();
+        return ofClamp(size / MIN_EDGES_PER_THREAD, 1, maxThreads);
+    }
+
+    ofVec4f getClip(const ofVec3f& point, const ofMatrix4x4& modelViewProjection)
+    {
+        return ofVec4f(point.x, point.y, point.z, 1.f) * modelViewProjection;
+    }
+
+    // the cell of the grid that value, from -1 to 1 across the image, is in
+    unsigned getCell(float value, unsigned gridSize)
+    {
+        return (unsigned)ofClamp((value + 1.f) * .5f * gridSize, 0.f, gridSize - 1.f);
+    }
+
+    bool isSameMatrix(const ofMatrix4x4& a, const ofMatrix4x4& b)
+    {
+        return !memcmp(a.getPtr(), b.getPtr(), 16 * sizeof(float));
+    }
+
+    // narrow [low, high] to where a + b * t > 0, returns false if nothing is left
+    bool clip(float a, float b, float& low, float& high)
+    {
+        if (b == 0.f) return a > 0.f;
+        const float t = -a / b;
+        if (b > 0.f) low = max(low, t);
+        else high = min(high, t);
+        return low < high;
+    }
+
+    // the blanked points it takes to jump distance
+    unsigned getNumBlankPoints(float distance, const LaserOutput::Settings& settings)
+    {
+        return max(settings.minBlankPoints, (unsigned)ceil(distance / max(settings.maxBlankStep, 1e-6f)));
+    }
+
+    void appendUint16(string& data, unsigned value)
+    {
+        data.push_back((char)((value >> 8) & 0xff));
+        data.push_back((char)(value & 0xff));
+    }
+
+    void appendName(string& data, const string& name)
+    {
+        for (unsigned i = 0; i < 8; ++i) data.push_back(i < name.size() ? name[i] : '\0');
+    }
+}
+
+LaserOutput::Settings::Settings() :
+    pointsPerSecond(30000),
+    frameRate(30.f),
+    cornerPoints(4),
+    blankDwellPoints(4),
+    minBlankPoints(6),
+    maxBlankStep(.05f),
+    maxLitStep(.02f),
+    joinDistance(.002f),
+    minSegmentLength(.002f),
+    occlusionTolerance(.001f),
+    maxTwoOptSegments(1000),
+    maxTwoOptPasses(8)
+{
+}
+
+LaserOutput::Stats::Stats() :
+    numEdges(0),
+    numVisibleSegments(0),
+    numPoints(0),
+    numBlankPoints(0),
+    litLength(0.f),
+    greedyBlankLength(0.f),
+    blankLength(0.f),
+    overBudget(false),
+    visibilityMillis(0.f),
+    shadowsMillis(0.f),
+    orderMillis(0.f),
+    pointsMillis(0.f),
+    totalMillis(0.f)
+{
+}
+
+LaserOutput::LaserOutput() :
+    occlusionDirty(true),
+    lastFrameWritten(0),
+    udpSocket(-1),
+    udpHost(0),
+    udpPort(0),
+    numFramesMade(0),
+    numFramesSent(0)
+{
+}
+
+LaserOutput::~LaserOutput()
+{
+    close();
+}
+
+bool LaserOutput::setup(const string& destination, const Settings& settings)
+{
+    close();
+    this->settings = settings;
+    occlusionDirty = true;
+    numFramesMade = 0;
+    numFramesSent = 0;
+    lastFrameWritten = 0;
+    headerOffsets.clear();
+
+    if (destination.compare(0, 4, "udp:") == 0)
+    {
+#ifdef TARGET_WIN32
+        ofLogError("LaserOutput") << "sending over udp isn't supported on windows, give a file instead";
+        return false;
+#else
+        // udp:port sends to this machine, udp:host:port to somewhere else
+        const vector<string> parts = ofSplitString(destination, ":");
+        const string host = parts.size() > 2 ? parts[1] : "127.0.0.1";
+        const int port = parts.size() > 1 ? ofToInt(parts.back()) : 0;
+        in_addr address;
+        if (inet_pton(AF_INET, host.c_str(), &address) != 1)
+        {
+            ofLogError("LaserOutput") << "couldn't understand the address " << host;
+            return false;
+        }
+        udpHost = address.s_addr;
+        udpPort = htons(port > 0 && port < 65536 ? port : DEFAULT_UDP_PORT);
+        udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (udpSocket < 0)
+        {
+            ofLogError("LaserOutput") << "couldn't make a udp socket";
+            return false;
+        }
+        ofLogNotice("LaserOutput") << "sending ILDA frames to " << host << ":" << ntohs(udpPort) << " over udp";
+#endif
+    }
+    else if (!file.open(destination, ofFile::WriteOnly, true))
+    {
+        ofLogError("LaserOutput") << "couldn't open " << destination;
+        return false;
+    }
+    else ofLogNotice("LaserOutput") << "writing ILDA frames to " << destination;
+
+    startThread();
+    return true;
+}
+
+void LaserOutput::close()
+{
+    if (isThreadRunning()) waitForThread(true);
+
+    // an ILDA file ends with a frame with no points, then we go back and
+    // fill in how many frames there are in every frame's header
+    if (file.is_open())
+    {
+        buffer.clear();
+        writeIldaFrame(vector<Point>(), 0, 0, headerOffsets.size(), headerOffsets.size(), buffer);
+        file.write(buffer.data(), buffer.size());
+
+        string total;
+        appendUint16(total, headerOffsets.size());
+        for (uint64_t offset : headerOffsets)
+        {
+            file.seekp(offset + ILDA_TOTAL_FRAMES_OFFSET);
+            file.write(total.data(), total.size());
+        }
+        file.close();
+        ofLogNotice("LaserOutput") << "wrote " << headerOffsets.size() << " ILDA frames";
+    }
+
+#ifndef TARGET_WIN32
+    if (udpSocket >= 0) ::close(udpSocket);
+#endif
+    udpSocket = -1;
+}
+
+void LaserOutput::update(const ofMesh& outline, const ofMesh& occluder, const ofMatrix4x4& transform,
+                         const ofCamera& camera, const ofRectangle& viewport, const ofColor& colour)
+{
+    if (!isOpen()) return;
+
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    Stats stats;
+    stats.numEdges = (outline.hasIndices() ? outline.getNumIndices() : outline.getNumVertices()) / 2;
+
+    // the shadows only change when the box or where we're looking from
+    // does, which most frames it doesn't, only the outline is animated
+    const ofMatrix4x4 modelViewProjection = camera.getModelViewProjectionMatrix(viewport);
+    const ofVec3f eye = camera.getGlobalPosition();
+    if (occlusionDirty || !isSameMatrix(transform, occlusionTransform) ||
+        !isSameMatrix(modelViewProjection, occlusionModelViewProjection) || eye != occlusionEye)
+    {
+        makeOcclusion(occluder, transform, modelViewProjection, eye, settings.occlusionTolerance, occlusion);
+        occlusionDirty = false;
+        occlusionTransform = transform;
+        occlusionModelViewProjection = modelViewProjection;
+        occlusionEye = eye;
+    }
+    const unsigned long long shadowsEnd = ofGetElapsedTimeMicros();
+
+    vector<Segment> segments = getVisibleSegments(outline, transform, modelViewProjection, occlusion,
+                                                  settings.minSegmentLength, 0);
+    const unsigned long long visibilityEnd = ofGetElapsedTimeMicros();
+
+    stats.blankLength = orderSegments(segments, settings, &stats.greedyBlankLength);
+    const unsigned long long orderEnd = ofGetElapsedTimeMicros();
+
+    // the output thread only ever reads the frame that's been published
+    Frame& frame = frames.getWriteBuffer();
+    makePoints(segments, colour, settings, frame.points, stats);
+    frame.number = ++numFramesMade;
+    frames.publish();
+
+    const unsigned long long end = ofGetElapsedTimeMicros();
+    stats.visibilityMillis = (visibilityEnd - start) / 1000.f;
+    stats.shadowsMillis = (shadowsEnd - start) / 1000.f;
+    stats.orderMillis = (orderEnd - visibilityEnd) / 1000.f;
+    stats.pointsMillis = (end - orderEnd) / 1000.f;
+    stats.totalMillis = (end - start) / 1000.f;
+    lastStats = stats;
+}
+
+string LaserOutput::getStatus() const
+{
+    stringstream status;
+    status << "laser: " << numFramesMade << " frames made, " << numFramesSent << " sent, "
+           << lastStats.numVisibleSegments << " of " << lastStats.numEdges << " edges, "
+           << lastStats.numPoints << " points (" << lastStats.numBlankPoints << " blanked)"
+           << (lastStats.overBudget ? " over budget" : "") << endl
+           << fixed << setprecision(2) << "laser jumps " << lastStats.blankLength << " (greedy "
+           << lastStats.greedyBlankLength << "), visibility " << lastStats.visibilityMillis << "ms (shadows "
+           << lastStats.shadowsMillis << "ms), order "
+           << lastStats.orderMillis << "ms, points " << lastStats.pointsMillis << "ms";
+    return status.str();
+}
+
+vector<LaserOutput::Segment> LaserOutput::getVisibleSegments(const ofMesh& outline, const ofMesh& occluder,
+                                                             const ofMatrix4x4& transform,
+                                                             const ofMatrix4x4& modelViewProjection, const ofVec3f& eye,
+                                                             float occlusionTolerance, float minSegmentLength,
+                                                             unsigned maxThreads)
+{
+    Occlusion occlusion;
+    makeOcclusion(occluder, transform, modelViewProjection, eye, occlusionTolerance, occlusion);
+    return getVisibleSegments(outline, transform, modelViewProjection, occlusion, minSegmentLength, maxThreads);
+}
+
+void LaserOutput::makeOcclusion(const ofMesh& occluder, const ofMatrix4x4& transform, const ofMatrix4x4& modelViewProjection,
+                                const ofVec3f& eye, float occlusionTolerance, Occlusion& occlusion)
+{
+    // the shadow of every triangle of the occluder, triangles seen edge on
+    // or with no area can't hide anything and are left out
+    vector<Shadow>& shadows = occlusion.shadows;
+    vector<unsigned>& everywhere = occlusion.everywhere;
+    vector<ofVec4f> bounds;
+    shadows.clear();
+    everywhere.clear();
+    if (occluder.getMode() == OF_PRIMITIVE_TRIANGLES)
+    {
+        const vector<ofVec3f>& vertices = occluder.getVertices();
+        const unsigned numIndices = occluder.hasIndices() ? occluder.getNumIndices() : vertices.size();
+        for (unsigned i = 0; i + 2 < numIndices; i += 3)
+        {
+            ofVec3f corners[3];
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                corners[j] = vertices[occluder.hasIndices() ? occluder.getIndex(i + j) : i + j] * transform;
+            }
+
+            Shadow shadow;
+            ofVec3f normal = (corners[1] - corners[0]).getCrossed(corners[2] - corners[0]);
+            const float length = normal.length();
+            if (length <= 0.f) continue;
+            normal /= length;
+            const float eyeSide = normal.dot(eye - corners[0]);
+            if (fabs(eyeSide) <= occlusionTolerance) continue;
+
+            // behind is the other side of the triangle from the eye
+            shadow.normals[0] = eyeSide > 0.f ? -normal : normal;
+            shadow.offsets[0] = -shadow.normals[0].dot(corners[0]) - occlusionTolerance;
+
+            // the sides face in towards the triangle's other corner
+            bool degenerate = false;
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                ofVec3f side = (corners[j] - eye).getCrossed(corners[(j + 1) % 3] - eye);
+                const float inside = side.dot(corners[(j + 2) % 3] - eye);
+                if (inside == 0.f) degenerate = true;
+                if (inside < 0.f) side = -side;
+                shadow.normals[j + 1] = side;
+                shadow.offsets[j + 1] = -side.dot(eye);
+            }
+            if (degenerate) continue;
+
+            // where the triangle is in the image so that each edge only looks
+            // at the triangles in front of it, if any of it is behind the
+            // eye then it could be anywhere
+            ofVec4f bound(1.f, 1.f, -1.f, -1.f);
+            bool behind = false;
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                const ofVec4f clip = getClip(corners[j], modelViewProjection);
+                if (clip.w <= 0.f)
+                {
+                    behind = true;
+                    break;
+                }
+                const ofVec2f point(clip.x / clip.w, clip.y / clip.w);
+                bound.set(min(bound.x, point.x), min(bound.y, point.y), max(bound.z, point.x), max(bound.w, point.y));
+            }
+            if (behind) everywhere.push_back(shadows.size());
+            else if (bound.x > 1.f || bound.y > 1.f || bound.z < -1.f || bound.w < -1.f) continue;
+            shadows.push_back(shadow);
+            bounds.push_back(bound);
+        }
+    }
+
+    // put the triangles into a grid across the image
+    const unsigned gridSize = ofClamp(sqrt(shadows.size() / 2.f), 1, MAX_GRID_SIZE);
+    occlusion.gridSize = gridSize;
+    occlusion.cells.assign(gridSize * gridSize, vector<unsigned>());
+    for (unsigned i = 0; i < shadows.size(); ++i)
+    {
+        if (!everywhere.empty() && binary_search(everywhere.begin(), everywhere.end(), i)) continue;
+        for (unsigned y = getCell(bounds[i].y, gridSize); y <= getCell(bounds[i].w, gridSize); ++y)
+        {
+            for (unsigned x = getCell(bounds[i].x, gridSize); x <= getCell(bounds[i].z, gridSize); ++x)
+            {
+                occlusion.cells[y * gridSize + x].push_back(i);
+            }
+        }
+    }
+}
+
+vector<LaserOutput::Segment> LaserOutput::getVisibleSegments(const ofMesh& outline, const ofMatrix4x4& transform,
+                                                             const ofMatrix4x4& modelViewProjection,
+                                                             const Occlusion& occlusion, float minSegmentLength,
+                                                             unsigned maxThreads)
+{
+    const vector<Shadow>& shadows = occlusion.shadows;
+    const unsigned gridSize = occlusion.gridSize;
+    const vector<ofVec3f>& vertices = outline.getVertices();
+    const unsigned numEdges = (outline.hasIndices() ? outline.getNumIndices() : vertices.size()) / 2;
+    const unsigned numThreads = getNumThreads(numEdges, maxThreads);
+    vector<vector<Segment> > visible(numThreads);
+    WorkerPool::get().run(numThreads, [&](unsigned part)
+    {
+        // when each triangle was last looked at so it's only clipped against once an edge
+        vector<unsigned> lastEdge(shadows.size(), ~0u);
+        vector<pair<float, float> > hidden;
+        for (unsigned edge = numEdges * part / numThreads; edge < numEdges * (part + 1) / numThreads; ++edge)
+        {
+            const unsigned first = outline.hasIndices() ? outline.getIndex(2 * edge) : 2 * edge;
+            const unsigned second = outline.hasIndices() ? outline.getIndex(2 * edge + 1) : 2 * edge + 1;
+            const ofVec3f from = vertices[first] * transform;
+            const ofVec3f direction = vertices[second] * transform - from;
+
+            // only the part in the laser's range, which is the projector's image
+            const ofVec4f fromClip = getClip(from, modelViewProjection);
+            const ofVec4f toClip = getClip(from + direction, modelViewProjection);
+            const ofVec4f clipDirection = toClip - fromClip;
+            float low = 0.f;
+            float high = 1.f;
+            if (!clip(fromClip.w - 1e-6f, clipDirection.w, low, high) ||
+                !clip(fromClip.w - fromClip.x, clipDirection.w - clipDirection.x, low, high) ||
+                !clip(fromClip.w + fromClip.x, clipDirection.w + clipDirection.x, low, high) ||
+                !clip(fromClip.w - fromClip.y, clipDirection.w - clipDirection.y, low, high) ||
+                !clip(fromClip.w + fromClip.y, clipDirection.w + clipDirection.y, low, high))
+            {
+                continue;
+            }
+            auto getPoint = [&](float t)
+            {
+                const ofVec4f point = fromClip + t * clipDirection;
+                return ofVec2f(point.x / point.w, point.y / point.w);
+            };
+            const ofVec2f start = getPoint(low);
+            const ofVec2f end = getPoint(high);
+
+            // every triangle whose shadow might fall on it hides the part of it that's in the shadow
+            hidden.clear();
+            auto addShadow = [&](unsigned i)
+            {
+                if (lastEdge[i] == edge) return;
+                lastEdge[i] = edge;
+                float shadowLow = low;
+                float shadowHigh = high;
+                for (unsigned j = 0; j < 4; ++j)
+                {
+                    const float a = shadows[i].normals[j].dot(from) + shadows[i].offsets[j];
+                    if (!clip(a, shadows[i].normals[j].dot(direction), shadowLow, shadowHigh)) return;
+                }
+                hidden.push_back(make_pair(shadowLow, shadowHigh));
+            };
+            for (unsigned i : occlusion.everywhere) addShadow(i);
+            for (unsigned y = getCell(min(start.y, end.y), gridSize); y <= getCell(max(start.y, end.y), gridSize); ++y)
+            {
+                for (unsigned x = getCell(min(start.x, end.x), gridSize); x <= getCell(max(start.x, end.x), gridSize); ++x)
+                {
+                    for (unsigned i : occlusion.cells[y * gridSize + x]) addShadow(i);
+                }
+            }
+
+            // what's left between the shadows can be seen
+            sort(hidden.begin(), hidden.end());
+            hidden.push_back(make_pair(high, high));
+            float visibleFrom = low;
+            for (const pair<float, float>& shadow : hidden)
+            {
+                if (shadow.first > visibleFrom)
+                {
+                    Segment segment;
+                    segment.from = getPoint(visibleFrom);
+                    segment.to = getPoint(shadow.first);
+                    if (segment.from.distance(segment.to) >= minSegmentLength) visible[part].push_back(segment);
+                }
+                visibleFrom = max(visibleFrom, shadow.second);
+            }
+        }
+    });
+
+    vector<Segment> segments;
+    for (const vector<Segment>& part : visible) segments.insert(segments.end(), part.begin(), part.end());
+    return segments;
+}
+
+float LaserOutput::orderSegments(vector<Segment>& segments, const Settings& settings, float* greedyBlankLength)
+{
+    const unsigned numSegments = segments.size();
+    if (greedyBlankLength) *greedyBlankLength = 0.f;
+    if (numSegments < 2) return numSegments ? segments[0].to.distance(segments[0].from) : 0.f;
+
+    // both ends of every segment go into a grid, end 2 * i + 0 is the start
+    // of segment i and 2 * i + 1 is its end, about one segment per cell
+    ofVec2f low = segments[0].from;
+    ofVec2f high = segments[0].from;
+    for (const Segment& segment : segments)
+    {
+        low.set(min(low.x, min(segment.from.x, segment.to.x)), min(low.y, min(segment.from.y, segment.to.y)));
+        high.set(max(high.x, max(segment.from.x, segment.to.x)), max(high.y, max(segment.from.y, segment.to.y)));
+    }
+    const int gridSize = ofClamp(ceil(sqrt(numSegments)), 1, 256);
+    const float cellSize = max(max(high.x - low.x, high.y - low.y) / gridSize, 1e-6f);
+    auto getEnd = [&](unsigned end) -> const ofVec2f&
+    {
+        return end & 1 ? segments[end / 2].to : segments[end / 2].from;
+    };
+    auto getCell = [&](float value, float low)
+    {
+        return min(gridSize - 1, max(0, (int)((value - low) / cellSize)));
+    };
+    vector<vector<unsigned> > cells(gridSize * gridSize);
+    for (unsigned end = 2; end < 2 * numSegments; ++end)
+    {
+        const ofVec2f& point = getEnd(end);
+        cells[getCell(point.y, low.y) * gridSize + getCell(point.x, low.x)].push_back(end);
+    }
+
+    // nearest neighbour: from the end of the first segment keep going to the
+    // nearest end of any segment we haven't drawn yet, looking in rings of
+    // cells further and further out until nothing further out could be nearer
+    vector<Segment> ordered;
+    ordered.reserve(numSegments);
+    ordered.push_back(segments[0]);
+    vector<bool> used(numSegments, false);
+    used[0] = true;
+    while (ordered.size() < numSegments)
+    {
+        const ofVec2f& position = ordered.back().to;
+        const int cellX = getCell(position.x, low.x);
+        const int cellY = getCell(position.y, low.y);
+        unsigned nearest = 0;
+        float nearestDistance = numeric_limits<float>::max();
+        for (int ring = 0; ring < gridSize; ++ring)
+        {
+            for (int y = max(0, cellY - ring); y <= min(gridSize - 1, cellY + ring); ++y)
+            {
+                for (int x = max(0, cellX - ring); x <= min(gridSize - 1, cellX + ring); ++x)
+                {
+                    if (abs(x - cellX) != ring && abs(y - cellY) != ring) continue;
+
+                    // the ends of segments that have been drawn are taken out as we come across them
+                    vector<unsigned>& cell = cells[y * gridSize + x];
+                    for (unsigned i = 0; i < cell.size();)
+                    {
+                        if (used[cell[i] / 2])
+                        {
+                            cell[i] = cell.back();
+                            cell.pop_back();
+                            continue;
+                        }
+                        const float distance = position.squareDistance(getEnd(cell[i]));
+                        if (distance < nearestDistance || (distance == nearestDistance && cell[i] < nearest))
+                        {
+                            nearest = cell[i];
+                            nearestDistance = distance;
+                        }
+                        ++i;
+                    }
+                }
+            }
+            if (nearestDistance <= ring * cellSize * ring * cellSize) break;
+        }
+
+        // if we got to the end of the segment it's drawn backwards
+        Segment segment = segments[nearest / 2];
+        if (nearest & 1) swap(segment.from, segment.to);
+        ordered.push_back(segment);
+        used[nearest / 2] = true;
+    }
+    segments.swap(ordered);
+
+    auto getJump = [&](unsigned i)
+    {
+        return segments[i].to.distance(segments[(i + 1) % numSegments].from);
+    };
+    float blankLength = 0.f;
+    for (unsigned i = 0; i < numSegments; ++i) blankLength += getJump(i);
+    if (greedyBlankLength) *greedyBlankLength = blankLength;
+    if (numSegments > settings.maxTwoOptSegments) return blankLength;
+
+    // 2-opt: drawing segments i + 1 to j backwards, in reverse order, swaps
+    // the jumps into and out of them for two new ones, keep doing that
+    // wherever it's shorter until it isn't anywhere
+    for (unsigned pass = 0; pass < settings.maxTwoOptPasses; ++pass)
+    {
+        bool improved = false;
+        for (unsigned i = 0; i + 1 < numSegments; ++i)
+        {
+            for (unsigned j = i + 1; j < numSegments; ++j)
+            {
+                const Segment& next = segments[(j + 1) % numSegments];
+                const float before = getJump(i) + getJump(j);
+                const float after = segments[i].to.distance(segments[j].to) + segments[i + 1].from.distance(next.from);
+                if (after >= before - 1e-6f) continue;
+
+                reverse(segments.begin() + i + 1, segments.begin() + j + 1);
+                for (unsigned k = i + 1; k <= j; ++k) swap(segments[k].from, segments[k].to);
+                blankLength -= before - after;
+                improved = true;
+            }
+        }
+        if (!improved) break;
+    }
+    return blankLength;
+}
+
+void LaserOutput::makePoints(const vector<Segment>& segments, const ofColor& colour, const Settings& settings,
+                             vector<Point>& points, Stats& stats)
+{
+    points.clear();
+    stats.numVisibleSegments = segments.size();
+    stats.numPoints = 0;
+    stats.numBlankPoints = 0;
+    stats.litLength = 0.f;
+    stats.overBudget = false;
+
+    auto addPoint = [&](const ofVec2f& position, bool blanked)
+    {
+        Point point;
+        point.x = ofClamp(position.x, -1.f, 1.f) * 32767.f;
+        point.y = ofClamp(position.y, -1.f, 1.f) * 32767.f;
+        point.blanked = blanked;
+        point.colour = blanked ? ofColor(0) : colour;
+        points.push_back(point);
+        if (blanked) ++stats.numBlankPoints;
+    };
+
+    // every frame has this many points so that at pointsPerSecond they
+    // all take the same time to draw, with nothing to draw the laser
+    // waits in the middle, blanked
+    const unsigned budget = ofClamp(settings.pointsPerSecond / max(settings.frameRate, 1.f), 1, MAX_ILDA_POINTS);
+    const unsigned numSegments = segments.size();
+    if (!numSegments)
+    {
+        points.reserve(budget);
+        while (points.size() < budget) addPoint(ofVec2f(0.f, 0.f), true);
+        stats.numPoints = points.size();
+        return;
+    }
+
+    // count the points that don't depend on how far apart the lit points
+    // are, the rest of the frame's points are shared out along the lines,
+    // a segment whose start joins onto the end of the one before it is
+    // drawn straight on from it with a corner in between
+    const unsigned cornerPoints = max(1u, settings.cornerPoints);
+    vector<bool> joined(numSegments);
+    unsigned numFixedPoints = 0;
+    for (unsigned i = 0; i < numSegments; ++i)
+    {
+        const Segment& previous = segments[(i + numSegments - 1) % numSegments];
+        const float jump = previous.to.distance(segments[i].from);
+        joined[i] = numSegments > 1 && jump <= settings.joinDistance;
+        numFixedPoints += cornerPoints;
+        if (!joined[i]) numFixedPoints += getNumBlankPoints(jump, settings) + settings.blankDwellPoints + cornerPoints;
+        stats.litLength += segments[i].from.distance(segments[i].to);
+    }
+    const int numLitPoints = (int)budget - (int)numFixedPoints - (int)numSegments;
+    const float step = stats.litLength / max(1, numLitPoints);
+    stats.overBudget = numLitPoints < (int)numSegments || step > settings.maxLitStep;
+
+    points.reserve(budget);
+    for (unsigned i = 0; i < numSegments; ++i)
+    {
+        const Segment& segment = segments[i];
+
+        // jump from the end of the last segment, ease off before turning
+        // off and let the mirrors settle before turning back on
+        if (!joined[i])
+        {
+            const ofVec2f& previous = segments[(i + numSegments - 1) % numSegments].to;
+            for (unsigned j = 0; j < cornerPoints; ++j) addPoint(previous, false);
+            const unsigned numBlankPoints = getNumBlankPoints(previous.distance(segment.from), settings);
+            for (unsigned j = 1; j <= numBlankPoints; ++j) addPoint(previous.getInterpolated(segment.from, j / (float)numBlankPoints), true);
+            for (unsigned j = 0; j < settings.blankDwellPoints; ++j) addPoint(segment.from, true);
+        }
+        for (unsigned j = 0; j < cornerPoints; ++j) addPoint(segment.from, false);
+
+        const unsigned numSteps = max(1u, (unsigned)ceil(segment.from.distance(segment.to) / max(step, 1e-6f)));
+        for (unsigned j = 1; j <= numSteps; ++j) addPoint(segment.from.getInterpolated(segment.to, j / (float)numSteps), false);
+    }
+    // the budget is never more than an ILDA frame can hold so this also
+    // catches frames that have to be split to be written
+    stats.overBudget = stats.overBudget || points.size() > budget;
+
+    // the lines are rounded up to whole points so there can be a few left
+    // over, the laser waits blanked where it stopped until the frame's time
+    // is up, the next frame starts by jumping from there
+    while (points.size() < budget) addPoint(segments.back().to, true);
+    stats.numPoints = points.size();
+}
+
+void LaserOutput::writeIldaFrame(const vector<Point>& points, size_t first, size_t count, unsigned frameNumber,
+                                 unsigned numFrames, string& data)
+{
+    data.append("ILDA", 4);
+    data.append(3, '\0');
+    data.push_back((char)ILDA_FORMAT);
+    appendName(data, "laserCat");
+    appendName(data, "ofx");
+    appendUint16(data, count);
+    appendUint16(data, frameNumber);
+    appendUint16(data, numFrames);
+
+    // projector number and a reserved byte
+    data.push_back('\0');
+    data.push_back('\0');
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const Point& point = points[i];
+        appendUint16(data, (uint16_t)point.x);
+        appendUint16(data, (uint16_t)point.y);
+        // only the frame's very last point is marked as the last, not the
+        // last of each part when a frame is split to send it over udp or write it
+        data.push_back((char)((i + 1 == points.size() ? ILDA_LAST_POINT : 0) | (point.blanked ? ILDA_BLANKED : 0)));
+        data.push_back((char)point.colour.b);
+        data.push_back((char)point.colour.g);
+        data.push_back((char)point.colour.r);
+    }
+}
+
+void LaserOutput::threadedFunction()
+{
+    // like the video, when each frame is due is worked out from the start so
+    // that we don't drift, every frame takes as long as it takes to draw its
+    // points and the newest frame is sent each time, or the last one again
+    unsigned long long start = 0;
+    unsigned long long numPointsSent = 0;
+    bool started = false;
+
+    while (isThreadRunning())
+    {
+        if (frames.update()) started = true;
+        if (!started)
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            start = ofGetElapsedTimeMicros();
+            continue;
+        }
+
+        const Frame& frame = frames.getReadBuffer();
+        send(frame);
+        numPointsSent += frame.points.size();
+
+        // if we've fallen well behind, e.g. the machine was busy, we carry on
+        // from now rather than rushing out the frames we missed
+        const unsigned long long due = start + (unsigned long long)(numPointsSent * 1000000. / max(1u, settings.pointsPerSecond));
+        const unsigned long long now = ofGetElapsedTimeMicros();
+        if (due > now) this_thread::sleep_for(chrono::microseconds(due - now));
+        else if (now - due > 100000)
+        {
+            start = now;
+            numPointsSent = 0;
+        }
+    }
+}
+
+void LaserOutput::send(const Frame& frame)
+{
+#ifndef TARGET_WIN32
+    if (udpSocket >= 0)
+    {
+        // each datagram is a whole ILDA frame on its own
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = udpHost;
+        address.sin_port = udpPort;
+        for (size_t first = 0; first < frame.points.size(); first += MAX_UDP_POINTS)
+        {
+            buffer.clear();
+            writeIldaFrame(frame.points, first, min<size_t>(MAX_UDP_POINTS, frame.points.size() - first),
+                           frame.number & 0xffff, 0, buffer);
+            sendto(udpSocket, buffer.data(), buffer.size(), 0, (const sockaddr*)&address, sizeof(address));
+        }
+        ++numFramesSent;
+        return;
+    }
+#endif
+
+    // a file only gets each frame once, and only as many as ILDA can number,
+    // a frame with more points than an ILDA frame can count is split into
+    // as many as it takes like it is for udp, makePoints has already said
+    // it's over budget
+    if (!file.is_open() || frame.number == lastFrameWritten) return;
+    lastFrameWritten = frame.number;
+    if (headerOffsets.size() >= MAX_ILDA_FRAMES) return;
+
+    for (size_t first = 0; first < frame.points.size() && headerOffsets.size() < MAX_ILDA_FRAMES; first += MAX_ILDA_POINTS)
+    {
+        headerOffsets.push_back(file.tellp());
+        buffer.clear();
+        writeIldaFrame(frame.points, first, min<size_t>(MAX_ILDA_POINTS, frame.points.size() - first),
+                       headerOffsets.size() - 1, 0, buffer);
+        file.write(buffer.data(), buffer.size());
+    }
+    ++numFramesSent;
+}
+
+string LaserOutput::benchmark(unsigned numFrames)
+{
+    // the box from the app with its outline and a sphere with every edge of
+    // it outlined, which has a lot more edges to hide and put in order, both
+    // very slightly smaller than their outlines like in the app, and the
+    // model the app is really showing if there's one here
+    struct Scene
+    {
+        string name;
+        ofMesh outline;
+        ofMesh occluder;
+    };
+    vector<Scene> scenes(2);
+    scenes[0].name = "box";
+    scenes[0].outline = FeatureEdgeExtractor::extract(ofMesh::box(26.65f, 26.65f, 11.f, 1, 1, 1));
+    scenes[0].occluder = ofMesh::box(.999f * 26.65f, .999f * 26.65f, .999f * 11.f, 1, 1, 1);
+    scenes[1].name = "sphere";
+    scenes[1].outline = FeatureEdgeExtractor::extract(ofMesh::sphere(13.f, 48), 1.f);
+    scenes[1].occluder = ofMesh::sphere(.999f * 13.f, 48);
+    if (ofFile("model.ply").exists())
+    {
+        Scene scene;
+        scene.name = "model.ply";
+        scene.occluder.load("model.ply");
+        scene.outline = FeatureEdgeExtractor::extract(scene.occluder);
+        FeatureEdgeExtractor::scaleAboutCentre(scene.occluder, .999f);
+        if (scene.occluder.getNumVertices()) scenes.push_back(scene);
+    }
+
+    stringstream report;
+    report << fixed << setprecision(3);
+    const Settings settings;
+    for (const Scene& scene : scenes)
+    {
+        // the projector swings round in front of the scene
+        Stats total;
+        unsigned numOverBudget = 0;
+        vector<Point> points;
+        for (unsigned i = 0; i < numFrames; ++i)
+        {
+            ofCamera camera;
+            camera.setFov(16.84f);
+            camera.setPosition(ofVec3f(0.f, 30.f, -200.f).getRotated(ofMap(i, 0, numFrames, -40.f, 40.f), ofVec3f(0.f, 1.f, 0.f)));
+            camera.lookAt(ofVec3f(0.f, 0.f, 0.f));
+            const ofRectangle viewport(0.f, 0.f, 1920.f, 1080.f);
+
+            // the camera moves every frame so the shadows are made every
+            // frame too, which is the most they'll take in the app
+            Stats stats;
+            Occlusion occlusion;
+            const ofMatrix4x4 modelViewProjection = camera.getModelViewProjectionMatrix(viewport);
+            const unsigned long long start = ofGetElapsedTimeMicros();
+            makeOcclusion(scene.occluder, ofMatrix4x4(), modelViewProjection, camera.getGlobalPosition(),
+                          settings.occlusionTolerance, occlusion);
+            const unsigned long long shadowsEnd = ofGetElapsedTimeMicros();
+            vector<Segment> segments = getVisibleSegments(scene.outline, ofMatrix4x4(), modelViewProjection, occlusion,
+                                                          settings.minSegmentLength, 0);
+            const unsigned long long visibilityEnd = ofGetElapsedTimeMicros();
+            stats.blankLength = orderSegments(segments, settings, &stats.greedyBlankLength);
+            const unsigned long long orderEnd = ofGetElapsedTimeMicros();
+            makePoints(segments, ofColor::green, settings, points, stats);
+            const unsigned long long end = ofGetElapsedTimeMicros();
+
+            total.numVisibleSegments += stats.numVisibleSegments;
+            total.numPoints += stats.numPoints;
+            total.numBlankPoints += stats.numBlankPoints;
+            total.greedyBlankLength += stats.greedyBlankLength;
+            total.blankLength += stats.blankLength;
+            if (stats.overBudget) ++numOverBudget;
+            total.visibilityMillis += (visibilityEnd - start) / 1000.f;
+            total.shadowsMillis += (shadowsEnd - start) / 1000.f;
+            total.orderMillis += (orderEnd - visibilityEnd) / 1000.f;
+            total.pointsMillis += (end - orderEnd) / 1000.f;
+        }
+
+        const unsigned numTriangles = (scene.occluder.hasIndices() ? scene.occluder.getNumIndices()
+                                                                   : scene.occluder.getNumVertices()) / 3;
+        report << scene.name << ": " << scene.outline.getNumIndices() / 2 << " edges, "
+               << numTriangles << " triangles, on average "
+               << total.numVisibleSegments / (float)numFrames << " visible segments, "
+               << total.numPoints / (float)numFrames << " points (" << total.numBlankPoints / (float)numFrames
+               << " blanked), jumps " << total.blankLength / numFrames << " after 2-opt, "
+               << total.greedyBlankLength / numFrames << " nearest neighbour, "
+               << numOverBudget << " of " << numFrames << " frames over budget" << endl
+               << "  a frame: visibility " << total.visibilityMillis / numFrames << "ms (shadows "
+               << total.shadowsMillis / numFrames << "ms), order "
+               << total.orderMillis / numFrames << "ms, points " << total.pointsMillis / numFrames << "ms, total "
+               << (total.visibilityMillis + total.orderMillis + total.pointsMillis) / numFrames << "ms" << endl;
+    }
+    return report.str();
+}
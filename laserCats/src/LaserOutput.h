@@ -0,0 +1,236 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TripleBuffer.h"
+
+// draws the outline with a laser as well as the projector
+//
+// a laser can only draw lines, one point at a time, so rather than an image
+// we work out which parts of the outline the laser can see from where the
+// projector is, with the box in the way, and trace just those
+//
+// - visibility: every edge of the outline is clipped against the shadow of
+//   every triangle of the box as seen from the projector, a point is hidden
+//   when it's inside the pyramid from the projector through a triangle and
+//   behind the triangle, both of which are straight lines across the edge
+//   so the hidden parts come out exactly rather than sampled
+// - ordering: the laser has to be blanked and moved between lines that
+//   don't join up, which costs points that don't draw anything, so the
+//   lines are put in order, and turned round, with a nearest neighbour tour
+//   that's then improved with 2-opt, like a travelling salesman
+// - points: the lines are split into points with a few extra at corners and
+//   around the jumps so the mirrors can keep up, spread out so that each
+//   frame takes up pointsPerSecond / frameRate points
+//
+// the frames are ILDA format 5 (2d, true colour) and go to a file or, in
+// place of a real laser DAC, to a UDP port, e.g. "udp:7255" on this machine
+// or "udp:192.168.1.20:7255", a thread sends them at pointsPerSecond
+// repeating the last one until there's a new one, like a DAC would
+class LaserOutput : public ofThread
+{
+public:
+    // a point in the ILDA frame, x and y are -32768 to 32767 across the
+    // projector's image, y goes up
+    struct Point
+    {
+        int16_t x;
+        int16_t y;
+        bool blanked;
+        ofColor colour;
+    };
+
+    // an edge of the outline as the laser sees it, x and y are -1 to 1
+    // across the projector's image like normalised device coordinates
+    struct Segment
+    {
+        ofVec2f from;
+        ofVec2f to;
+    };
+
+    struct Settings
+    {
+        Settings();
+
+        unsigned pointsPerSecond;
+        float frameRate;
+
+        // points held at each end of a lit line and at corners
+        // where lines join, so the corners come out sharp
+        unsigned cornerPoints;
+
+        // blanked points held before the laser comes back on after a jump
+        unsigned blankDwellPoints;
+
+        // blanked points moving between lines, at least minBlankPoints and
+        // however many more it takes to move at most maxBlankStep per point,
+        // both in the -1 to 1 range of the image
+        unsigned minBlankPoints;
+        float maxBlankStep;
+
+        // lit points further apart than this make the mirrors overshoot, if
+        // the frame doesn't fit in its points without going over this it's
+        // counted as over budget
+        float maxLitStep;
+
+        // lines that end closer than this are joined without blanking
+        float joinDistance;
+
+        // visible pieces shorter than this are left out
+        float minSegmentLength;
+
+        // how far behind a triangle, in the mesh's units, a point has to
+        // be before it's hidden, so the outline isn't hidden by the faces
+        // it runs along
+        float occlusionTolerance;
+
+        // 2-opt is O(n^2) a pass so it's only run on frames with up to this
+        // many segments and for up to this many passes
+        unsigned maxTwoOptSegments;
+        unsigned maxTwoOptPasses;
+    };
+
+    // what went into the last frame and how long it took to make
+    struct Stats
+    {
+        Stats();
+
+        unsigned numEdges;
+        unsigned numVisibleSegments;
+        unsigned numPoints;
+        unsigned numBlankPoints;
+        float litLength;
+        float greedyBlankLength;
+        float blankLength;
+        bool overBudget;
+
+        // the shadows are part of the visibility, they're 0 when
+        // nothing had moved and last frame's were used again
+        float visibilityMillis;
+        float shadowsMillis;
+        float orderMillis;
+        float pointsMillis;
+        float totalMillis;
+    };
+
+    LaserOutput();
+    ~LaserOutput();
+
+    // start sending frames to destination, a file path or udp:[host:]port
+    bool setup(const string& destination, const Settings& settings = Settings());
+    void close();
+    bool isOpen() const { return isThreadRunning(); }
+
+    // call this from the render thread once a frame, outline is the
+    // OF_PRIMITIVE_LINES mesh to draw, occluder the OF_PRIMITIVE_TRIANGLES
+    // mesh in the way, both with transform applied, as seen by camera
+    // with viewport the size of the projector's image
+    void update(const ofMesh& outline, const ofMesh& occluder, const ofMatrix4x4& transform,
+                const ofCamera& camera, const ofRectangle& viewport, const ofColor& colour);
+
+    // call this when the occluder's vertices move, the shadows are only
+    // worked out again when it, the transform or the camera change
+    void meshChanged() { occlusionDirty = true; }
+
+    const Stats& getLastStats() const { return lastStats; }
+    unsigned long getNumFramesMade() const { return numFramesMade; }
+    unsigned long getNumFramesSent() const { return numFramesSent; }
+    string getStatus() const;
+
+    // the parts of outline's edges that can be seen through modelViewProjection,
+    // from eye, past occluder, maxThreads of 0 means as many as there are cores
+    static vector<Segment> getVisibleSegments(const ofMesh& outline, const ofMesh& occluder, const ofMatrix4x4& transform,
+                                              const ofMatrix4x4& modelViewProjection, const ofVec3f& eye,
+                                              float occlusionTolerance, float minSegmentLength, unsigned maxThreads = 0);
+
+    // put segments in the order to draw them, turning them round as needed,
+    // and return the total length of the jumps between them, including
+    // from the last back to the first, greedyBlankLength is set to what
+    // the jumps were before 2-opt if it's given
+    static float orderSegments(vector<Segment>& segments, const Settings& settings, float* greedyBlankLength = NULL);
+
+    // the points to draw segments in that order, short frames are made up
+    // to pointsPerSecond / frameRate points with blanked points so that
+    // every frame takes as long to draw
+    static void makePoints(const vector<Segment>& segments, const ofColor& colour, const Settings& settings,
+                           vector<Point>& points, Stats& stats);
+
+    // append points to data as an ILDA format 5 frame
+    static void writeIldaFrame(const vector<Point>& points, size_t first, size_t count, unsigned frameNumber,
+                               unsigned numFrames, string& data);
+
+    // makes frames of a box, of a dense model and of model.ply if there is
+    // one from a projector moving around them and returns how long each
+    // step takes a frame
+    static string benchmark(unsigned numFrames = 100);
+
+private:
+    // a triangle's shadow as seen from the eye, a point is in it when it's
+    // on the positive side of all four planes, three through the eye and
+    // each edge of the triangle and one a little behind the triangle
+    struct Shadow
+    {
+        ofVec3f normals[4];
+        float offsets[4];
+    };
+
+    // the shadows of the occluder's triangles in a grid across the image
+    // so that each edge only looks at the triangles in front of it
+    struct Occlusion
+    {
+        vector<Shadow> shadows;
+
+        // shadows of triangles that are partly behind the eye could be anywhere
+        vector<unsigned> everywhere;
+
+        unsigned gridSize;
+        vector<vector<unsigned> > cells;
+    };
+
+    // the shadows of occluder with transform applied as seen from eye
+    // through modelViewProjection
+    static void makeOcclusion(const ofMesh& occluder, const ofMatrix4x4& transform, const ofMatrix4x4& modelViewProjection,
+                              const ofVec3f& eye, float occlusionTolerance, Occlusion& occlusion);
+
+    // the parts of outline's edges that are outside all of the shadows
+    static vector<Segment> getVisibleSegments(const ofMesh& outline, const ofMatrix4x4& transform,
+                                              const ofMatrix4x4& modelViewProjection, const Occlusion& occlusion,
+                                              float minSegmentLength, unsigned maxThreads);
+
+    struct Frame
+    {
+        vector<Point> points;
+        unsigned long number;
+    };
+
+    void threadedFunction();
+
+    // send or save one frame, on the output thread
+    void send(const Frame& frame);
+
+    Settings settings;
+    TripleBuffer<Frame> frames;
+
+    // the shadows from the last frame and what they were made for
+    Occlusion occlusion;
+    bool occlusionDirty;
+    ofMatrix4x4 occlusionTransform;
+    ofMatrix4x4 occlusionModelViewProjection;
+    ofVec3f occlusionEye;
+
+    // the file we're writing and where each frame's header is in it so
+    // the total number of frames can be filled in when it's closed
+    ofFile file;
+    vector<uint64_t> headerOffsets;
+    unsigned long lastFrameWritten;
+
+    // the socket when we're sending over udp, the address and
+    // port are in network byte order
+    int udpSocket;
+    uint32_t udpHost;
+    uint16_t udpPort;
+
+    string buffer;
+    Stats lastStats;
+    unsigned long numFramesMade;
+    atomic<unsigned long> numFramesSent;
+};
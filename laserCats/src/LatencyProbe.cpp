@@ -0,0 +1,267 @@
+#include "LatencyProbe.h"
+
+namespace
+{
+    // a burst has reached the analysis once any band gets this loud, and
+    // the eq has emptied out once every band is below the rearm level,
+    // which is less than half a cat so no column has any cats in it
+    const float THRESHOLD = .5f;
+    const float REARM_THRESHOLD = .05f;
+
+    // the bursts fade in and out over this long so they don't click
+    const float RAMP_MILLIS = 2.f;
+
+    // silence for at least this long before some sound is the start of a burst
+    const float MIN_SILENCE_MILLIS = 10.f;
+
+    // a pixel brighter than this, adding up red, green and blue, is part of a cat
+    const int LIT_THRESHOLD = 48;
+
+    // min, median, 99th percentile, max and mean
+    string summarise(vector<float> values)
+    {
+        if (values.empty()) return "null";
+        sort(values.begin(), values.end());
+
+        float sum = 0.f;
+        for (unsigned i = 0; i < values.size(); ++i) sum += values[i];
+
+        stringstream json;
+        json << "{ \"min\": " << values.front()
+             << ", \"median\": " << values[values.size() / 2]
+             << ", \"p99\": " << values[min<size_t>(values.size() - 1, floor(.99 * values.size()))]
+             << ", \"max\": " << values.back()
+             << ", \"mean\": " << sum / values.size() << " }";
+        return json.str();
+    }
+
+    float getMedian(vector<float> values)
+    {
+        if (values.empty()) return 0.f;
+        sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+}
+
+LatencyProbe::LatencyProbe() :
+    sampleRate(0),
+    numChannels(0),
+    numSilentFrames(0),
+    onsetMicros(0),
+    numOnsets(0),
+    state(WAITING_FOR_BURST),
+    numOnsetsSeen(0),
+    burstMicros(0),
+    analysedMicros(0),
+    pickedUpMicros(0),
+    pickedUpFrame(0),
+    armed(true),
+    numMissed(0)
+{
+}
+
+void LatencyProbe::setup(unsigned sampleRate, unsigned numChannels, float toneFrequency, float burstMillis, float periodMillis)
+{
+    this->sampleRate = sampleRate;
+    this->numChannels = numChannels;
+
+    // a sine wave at half volume for the length of the burst, faded in
+    // and out with half a cosine, and silence for the rest of the loop
+    const unsigned numFrames = periodMillis * sampleRate / 1000.f;
+    const unsigned numBurstFrames = min<unsigned>(numFrames, burstMillis * sampleRate / 1000.f);
+    const unsigned numRampFrames = max(1.f, RAMP_MILLIS * sampleRate / 1000.f);
+    samples.assign(numFrames * numChannels, 0.f);
+    for (unsigned i = 0; i < numBurstFrames; ++i)
+    {
+        const unsigned fromEdge = min(i, numBurstFrames - 1 - i);
+        const float fade = fromEdge < numRampFrames ? .5f - .5f * cos(PI * fromEdge / numRampFrames) : 1.f;
+        const float sample = .5f * fade * sin(TWO_PI * toneFrequency * i / sampleRate);
+        for (unsigned j = 0; j < numChannels; ++j) samples[i * numChannels + j] = sample;
+    }
+
+    // the start of the loop counts as coming after silence
+    numSilentFrames = MIN_SILENCE_MILLIS * sampleRate / 1000.f;
+}
+
+void LatencyProbe::audioPlayed(const float* samples, unsigned numFrames, unsigned numChannels)
+{
+    // the block has just been handed over and each sample in it
+    // will be played 1 / sampleRate seconds after the one before
+    const unsigned long long now = ofGetElapsedTimeMicros();
+    const unsigned minSilentFrames = MIN_SILENCE_MILLIS * sampleRate / 1000.f;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        bool silent = true;
+        for (unsigned j = 0; j < numChannels && silent; ++j) silent = fabs(samples[i * numChannels + j]) < 1e-6f;
+
+        if (silent)
+        {
+            if (numSilentFrames < minSilentFrames) ++numSilentFrames;
+            continue;
+        }
+
+        // the count is what the render thread looks at so it's
+        // released after the time has been written
+        if (numSilentFrames >= minSilentFrames)
+        {
+            onsetMicros.store(now + i * 1000000ull / sampleRate, memory_order_relaxed);
+            numOnsets.fetch_add(1, memory_order_release);
+        }
+        numSilentFrames = 0;
+    }
+}
+
+void LatencyProbe::spectrumUpdated(const SpectrumSnapshot& snapshot)
+{
+    // a new burst has started, if we were still following the last one
+    // then it never made it to the eq
+    const unsigned onsets = numOnsets.load(memory_order_acquire);
+    if (onsets != numOnsetsSeen)
+    {
+        if (state == WAITING_FOR_SPECTRUM) missed("analysed");
+        else if (state == WAITING_FOR_RENDER) missed("rendered");
+        numOnsetsSeen = onsets;
+        burstMicros = onsetMicros.load(memory_order_relaxed);
+        state = WAITING_FOR_SPECTRUM;
+    }
+
+    const float loudest = snapshot.normalised.empty() ? 0.f : *max_element(snapshot.normalised.begin(), snapshot.normalised.end());
+    if (loudest < REARM_THRESHOLD) armed = true;
+
+    if (state == WAITING_FOR_SPECTRUM && armed && loudest >= THRESHOLD)
+    {
+        analysedMicros = snapshot.timeMicros;
+        pickedUpMicros = ofGetElapsedTimeMicros();
+        pickedUpFrame = ofGetFrameNum();
+        armed = false;
+        state = WAITING_FOR_RENDER;
+    }
+}
+
+void LatencyProbe::eqDrawn(const ofFbo& eqFbo, const ofRectangle& region)
+{
+    if (state != WAITING_FOR_RENDER) return;
+
+    // row 0 of the frame buffer is y = 0 where it was drawn so we can read
+    // the region straight back, reading the pixels waits for the gpu to
+    // finish drawing them which is what we want to time
+    const ofRectangle clipped = region.getIntersection(ofRectangle(0, 0, eqFbo.getWidth(), eqFbo.getHeight()));
+    const int width = clipped.width;
+    const int height = clipped.height;
+    if (width <= 0 || height <= 0) return;
+    readback.resize(4 * width * height);
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, eqFbo.getId());
+    glReadPixels(clipped.x, clipped.y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &readback[0]);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    const unsigned long long now = ofGetElapsedTimeMicros();
+
+    for (unsigned i = 0; i < readback.size(); i += 4)
+    {
+        if (readback[i] + readback[i + 1] + readback[i + 2] > LIT_THRESHOLD)
+        {
+            rendered(now);
+            return;
+        }
+    }
+}
+
+void LatencyProbe::rendered(unsigned long long renderedMicros)
+{
+    state = WAITING_FOR_BURST;
+    if (numOnsetsSeen <= 1) return;
+
+    // the analysis can start on the block with the start of the burst in it
+    // before the samples that come after the start are due to be played
+    analysedMillis.push_back(max(0.f, ((long long)analysedMicros - (long long)burstMicros) / 1000.f));
+    pickedUpMillis.push_back((pickedUpMicros - burstMicros) / 1000.f);
+    renderedMillis.push_back((renderedMicros - burstMicros) / 1000.f);
+    renderFrames.push_back(ofGetFrameNum() - pickedUpFrame);
+}
+
+void LatencyProbe::missed(const string& stage)
+{
+    if (numOnsetsSeen <= 1) return;
+    ++numMissed;
+    ofLogWarning("LatencyProbe") << "burst " << numOnsetsSeen << " was never " << stage;
+}
+
+string LatencyProbe::getSummary() const
+{
+    if (renderedMillis.empty()) return "latency: waiting for bursts";
+
+    stringstream summary;
+    summary << fixed << setprecision(1)
+            << "latency: " << renderedMillis.back() << "ms (analysed " << analysedMillis.back()
+            << "ms, picked up " << pickedUpMillis.back() << "ms), median " << getMedian(renderedMillis)
+            << "ms over " << renderedMillis.size() << " bursts, " << numMissed << " missed";
+    return summary.str();
+}
+
+string LatencyProbe::getReport() const
+{
+    // count the bursts in each step, the last bin holds everything slower
+    vector<unsigned> histogram(NUM_HISTOGRAM_BINS, 0);
+    for (unsigned i = 0; i < renderedMillis.size(); ++i)
+    {
+        histogram[min<unsigned>(NUM_HISTOGRAM_BINS - 1, renderedMillis[i] / HISTOGRAM_STEP_MILLIS)]++;
+    }
+    unsigned lastBin = 0;
+    for (unsigned i = 0; i < NUM_HISTOGRAM_BINS; ++i)
+    {
+        if (histogram[i]) lastBin = i;
+    }
+
+    stringstream report;
+    report << "from a burst being played to the eq showing it, " << renderedMillis.size()
+           << " bursts, " << numMissed << " missed" << endl;
+    for (unsigned i = 0; i <= lastBin && !renderedMillis.empty(); ++i)
+    {
+        report << setw(4) << i * HISTOGRAM_STEP_MILLIS << "ms ";
+        if (i + 1 < NUM_HISTOGRAM_BINS) report << "- " << setw(4) << (i + 1) * HISTOGRAM_STEP_MILLIS << "ms";
+        else report << "and up ";
+        report << " | " << string(histogram[i], '#') << endl;
+    }
+    report << "analysed: " << summarise(analysedMillis) << endl
+           << "picked up: " << summarise(pickedUpMillis) << endl
+           << "rendered: " << summarise(renderedMillis) << endl
+           << "frames from picked up to rendered: " << summarise(renderFrames);
+    return report.str();
+}
+
+bool LatencyProbe::save(const string& path) const
+{
+    vector<unsigned> histogram(NUM_HISTOGRAM_BINS, 0);
+    for (unsigned i = 0; i < renderedMillis.size(); ++i)
+    {
+        histogram[min<unsigned>(NUM_HISTOGRAM_BINS - 1, renderedMillis[i] / HISTOGRAM_STEP_MILLIS)]++;
+    }
+
+    stringstream json;
+    json << "{" << endl
+         << "    \"sampleRate\": " << sampleRate << "," << endl
+         << "    \"bursts\": " << renderedMillis.size() << "," << endl
+         << "    \"missed\": " << numMissed << "," << endl
+         << "    \"analysedMillis\": " << summarise(analysedMillis) << "," << endl
+         << "    \"pickedUpMillis\": " << summarise(pickedUpMillis) << "," << endl
+         << "    \"renderedMillis\": " << summarise(renderedMillis) << "," << endl
+         << "    \"renderFrames\": " << summarise(renderFrames) << "," << endl
+         << "    \"histogramStepMillis\": " << HISTOGRAM_STEP_MILLIS << "," << endl
+         << "    \"histogram\": [";
+    for (unsigned i = 0; i < histogram.size(); ++i) json << (i ? ", " : " ") << histogram[i];
+    json << " ]" << endl
+         << "}" << endl;
+
+    ofBuffer buffer;
+    buffer.set(json.str());
+    if (!ofBufferToFile(path, buffer))
+    {
+        ofLogError("LatencyProbe") << "couldn't write " << path;
+        return false;
+    }
+    ofLogNotice("LatencyProbe") << "wrote " << path;
+    return true;
+}
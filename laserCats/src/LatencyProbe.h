@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ofMain.h"
+#include "AudioAnalysisThread.h"
+
+// measures how long it takes from a sound being played to the eq showing it
+//
+// instead of the music we play short tone bursts with silence in between
+// through the same player, fft and analysis as the music would go through,
+// and follow each burst along the way:
+//
+// - played: the block of samples with the start of the burst in it has
+//   been handed to the sound card, anything the sound card itself buffers
+//   after that isn't included
+// - analysed: the analysis thread has a spectrum where one of the bands
+//   has crossed the threshold
+// - picked up: the render thread has picked that spectrum up in update()
+// - rendered: the cats are in eqFbo, which we check by reading it back
+//
+// the times are kept for every burst and written out as a histogram and a
+// summary of each stage so that builds can be compared, the bursts are far
+// enough apart that the eq has emptied out before the next one starts, the
+// first burst is left out as it's what sets how loud the bands can get
+class LatencyProbe
+{
+public:
+    // the histogram goes up in steps of this many milliseconds
+    static const unsigned HISTOGRAM_STEP_MILLIS = 5;
+    static const unsigned NUM_HISTOGRAM_BINS = 40;
+
+    LatencyProbe();
+
+    // make a loop of numChannels channels at sampleRate with a burst of
+    // toneFrequency Hz lasting burstMillis every periodMillis
+    void setup(unsigned sampleRate, unsigned numChannels, float toneFrequency = 1000.f,
+               float burstMillis = 30.f, float periodMillis = 600.f);
+
+    // the loop to play instead of the music
+    const vector<float>& getSamples() const { return samples; }
+    unsigned getSampleRate() const { return sampleRate; }
+    unsigned getNumChannels() const { return numChannels; }
+
+    // call this from the audio thread with every block of samples just after
+    // it's been played and before it's analysed, it looks for the bursts starting
+    void audioPlayed(const float* samples, unsigned numFrames, unsigned numChannels);
+
+    // call this from the render thread whenever AudioAnalysisThread::update()
+    // picks up a new snapshot
+    void spectrumUpdated(const SpectrumSnapshot& snapshot);
+
+    // call this after the eq has been drawn, region is where the first row
+    // of cats is drawn in eqFbo, it's only read back while we're waiting for
+    // a burst to show up so it doesn't stall the gpu the rest of the time
+    void eqDrawn(const ofFbo& eqFbo, const ofRectangle& region);
+
+    unsigned getNumBursts() const { return renderedMillis.size(); }
+    unsigned getNumMissed() const { return numMissed; }
+
+    // the latest burst's latency on one line
+    string getSummary() const;
+
+    // a histogram of the total latency and a summary of each stage
+    string getReport() const;
+
+    // write the results out as json
+    bool save(const string& path) const;
+
+private:
+    enum State
+    {
+        WAITING_FOR_BURST,
+        WAITING_FOR_SPECTRUM,
+        WAITING_FOR_RENDER
+    };
+
+    // keep the times of the burst we've been following now it's been rendered
+    void rendered(unsigned long long renderedMicros);
+
+    // give up on a burst that hasn't shown up by the time the next one is played
+    void missed(const string& stage);
+
+    vector<float> samples;
+    unsigned sampleRate;
+    unsigned numChannels;
+
+    // the audio thread's side, how many bursts it has seen start and when the
+    // last one started, the count is written after the time so it can be used
+    // to tell the render thread that the time is ready
+    unsigned numSilentFrames;
+    atomic<unsigned long long> onsetMicros;
+    atomic<unsigned> numOnsets;
+
+    // the render thread's side, the burst we're following
+    State state;
+    unsigned numOnsetsSeen;
+    unsigned long long burstMicros;
+    unsigned long long analysedMicros;
+    unsigned long long pickedUpMicros;
+    unsigned pickedUpFrame;
+
+    // the eq has to empty out between bursts before we look for the next one
+    bool armed;
+    vector<unsigned char> readback;
+
+    // how long after being played each burst reached each stage
+    vector<float> analysedMillis;
+    vector<float> pickedUpMillis;
+    vector<float> renderedMillis;
+
+    // and how many frames it took from being picked up to being rendered
+    vector<float> renderFrames;
+    unsigned numMissed;
+};
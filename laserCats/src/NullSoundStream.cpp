@@ -0,0 +1,56 @@
+#include "NullSoundStream.h"
+
+NullSoundStream::NullSoundStream() :
+    output(NULL),
+    numChannels(0),
+    sampleRate(0),
+    bufferSize(0)
+{
+}
+
+NullSoundStream::~NullSoundStream()
+{
+    close();
+}
+
+bool NullSoundStream::setup(int nOutputChannels, int nInputChannels, int sampleRate, int bufferSize, int nBuffers)
+{
+    if (!output || nOutputChannels <= 0 || sampleRate <= 0 || bufferSize <= 0)
+    {
+        ofLogError("NullSoundStream") << "needs an output and at least one channel, a sample rate and a buffer size";
+        return false;
+    }
+
+    close();
+    numChannels = nOutputChannels;
+    this->sampleRate = sampleRate;
+    this->bufferSize = bufferSize;
+    buffer.assign(numChannels * bufferSize, 0.f);
+
+    ofLogNotice("NullSoundStream") << "playing " << numChannels << " channels at " << sampleRate << "Hz to nowhere";
+    startThread();
+    return true;
+}
+
+void NullSoundStream::close()
+{
+    if (isThreadRunning()) waitForThread(true);
+}
+
+void NullSoundStream::threadedFunction()
+{
+    // a block is due every bufferSize samples, we work out when each one is
+    // due from the start rather than adding up sleeps so that we don't drift
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    unsigned long long numBlocks = 0;
+
+    while (isThreadRunning())
+    {
+        output->audioOut(&buffer[0], bufferSize, numChannels);
+        ++numBlocks;
+
+        const unsigned long long due = start + numBlocks * bufferSize * 1000000ull / sampleRate;
+        const unsigned long long now = ofGetElapsedTimeMicros();
+        if (due > now) this_thread::sleep_for(chrono::microseconds(due - now));
+    }
+}
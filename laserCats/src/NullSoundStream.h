@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ofMain.h"
+
+// stands in for ofSoundStream when there's no sound card, e.g. on a build
+// server, the output is asked for blocks of samples on a thread of our own
+// at the same rate a sound card would ask for them and they're thrown away
+//
+// everything that listens to what's played, like the fft, sees the same
+// blocks at the same times as it would with a real device, apart from
+// the jitter of the sound card's own clock
+class NullSoundStream : public ofThread
+{
+public:
+    NullSoundStream();
+    ~NullSoundStream();
+
+    void setOutput(ofBaseSoundOutput& output) { this->output = &output; }
+
+    // the same arguments as ofSoundStream::setup(), there's nothing to
+    // record so the input channels and the number of buffers are ignored
+    bool setup(int nOutputChannels, int nInputChannels, int sampleRate, int bufferSize, int nBuffers);
+
+    // stop asking for samples and wait for the thread to finish
+    void close();
+
+private:
+    void threadedFunction();
+
+    ofBaseSoundOutput* output;
+    unsigned numChannels;
+    unsigned sampleRate;
+    unsigned bufferSize;
+    vector<float> buffer;
+};
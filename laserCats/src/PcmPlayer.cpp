@@ -0,0 +1,131 @@
+#include "PcmPlayer.h"
+
+// wav files are little endian
+static unsigned readLittleEndian(const unsigned char* bytes, unsigned numBytes)
+{
+    unsigned value = 0;
+    for (unsigned i = 0; i < numBytes; ++i) value |= (uint32_t)bytes[i] << (8 * i);
+    return value;
+}
+
+PcmPlayer::PcmPlayer() :
+    numChannels(0),
+    sampleRate(0),
+    numFrames(0),
+    position(0),
+    playing(false),
+    loop(false)
+{
+}
+
+bool PcmPlayer::load(const string& path)
+{
+    ofBuffer buffer = ofBufferFromFile(path, true);
+    const unsigned char* data = (const unsigned char*)buffer.getData();
+    const unsigned size = buffer.size();
+
+    if (size < 12 || memcmp(data, "RIFF", 4) || memcmp(data + 8, "WAVE", 4))
+    {
+        ofLogError("PcmPlayer") << path << " is not a wav file";
+        return false;
+    }
+
+    // walk through the chunks looking for the format and the samples
+    unsigned format = 0;
+    unsigned bitsPerSample = 0;
+    const unsigned char* sampleData = NULL;
+    unsigned sampleDataSize = 0;
+    for (unsigned offset = 12; offset + 8 <= size;)
+    {
+        const unsigned chunkSize = readLittleEndian(data + offset + 4, 4);
+        const unsigned char* chunk = data + offset + 8;
+        const unsigned available = min(chunkSize, size - offset - 8);
+
+        if (!memcmp(data + offset, "fmt ", 4) && available >= 16)
+        {
+            format = readLittleEndian(chunk, 2);
+            numChannels = readLittleEndian(chunk + 2, 2);
+            sampleRate = readLittleEndian(chunk + 4, 4);
+            bitsPerSample = readLittleEndian(chunk + 14, 2);
+
+            // extensible format keeps the real format in the sub format guid
+            if (format == 0xFFFE && available >= 26) format = readLittleEndian(chunk + 24, 2);
+        }
+        else if (!memcmp(data + offset, "data", 4))
+        {
+            sampleData = chunk;
+            sampleDataSize = available;
+        }
+
+        // a chunk that runs off the end is the last one, whatever its size
+        // says, a size that big would wrap offset round and we'd never stop,
+        // chunks are padded to an even number of bytes
+        if (chunkSize > size - offset - 8) break;
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    const bool isInt = format == 1 && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32);
+    const bool isFloat = format == 3 && bitsPerSample == 32;
+    if (!sampleData || !numChannels || !sampleRate || (!isInt && !isFloat))
+    {
+        ofLogError("PcmPlayer") << path << " isn't a wav format we can play (format " << format << ", " << bitsPerSample << " bits)";
+        samples.clear();
+        return false;
+    }
+
+    // convert everything to floats between -1 and 1
+    const unsigned bytesPerSample = bitsPerSample / 8;
+    numFrames = sampleDataSize / (bytesPerSample * numChannels);
+    samples.resize(numFrames * numChannels);
+    for (unsigned i = 0; i < samples.size(); ++i)
+    {
+        const unsigned char* bytes = sampleData + i * bytesPerSample;
+        if (isFloat)
+        {
+            unsigned bits = readLittleEndian(bytes, 4);
+            memcpy(&samples[i], &bits, 4);
+        }
+        else
+        {
+            // shift up so the sign bit is at the top and then back down
+            const int value = (int)(readLittleEndian(bytes, bytesPerSample) << (32 - bitsPerSample));
+            samples[i] = value / 2147483648.f;
+        }
+    }
+
+    position = 0;
+    ofLogNotice("PcmPlayer") << "loaded " << path << ", " << numChannels << " channels at " << sampleRate << "Hz, "
+                             << numFrames / (float)sampleRate << " seconds";
+    return true;
+}
+
+void PcmPlayer::setSamples(const vector<float>& samples, unsigned numChannels, unsigned sampleRate)
+{
+    this->samples = numChannels ? samples : vector<float>();
+    this->numChannels = numChannels;
+    this->sampleRate = sampleRate;
+    numFrames = numChannels ? samples.size() / numChannels : 0;
+    position = 0;
+}
+
+void PcmPlayer::audioOut(float* output, int bufferSize, int nChannels)
+{
+    for (int i = 0; i < bufferSize; ++i)
+    {
+        if (playing && position >= numFrames)
+        {
+            if (loop) position = 0;
+            else playing = false;
+        }
+
+        for (int j = 0; j < nChannels; ++j)
+        {
+            // if the file has fewer channels than the output then repeat them
+            output[i * nChannels + j] = playing ? samples[position * numChannels + j % numChannels] : 0.f;
+        }
+
+        if (playing) ++position;
+    }
+
+    if (listener) listener(output, bufferSize, nChannels);
+}
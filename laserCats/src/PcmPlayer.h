@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+
+// plays an uncompressed wav file through an ofSoundStream
+//
+// unlike ofSoundPlayer we fill the sound card's buffers ourselves so we
+// get to see the exact blocks of samples that are being played, these are
+// handed to a listener which is how we analyse exactly what you can hear
+class PcmPlayer : public ofBaseSoundOutput
+{
+public:
+    // called from the audio thread with each block of interleaved
+    // samples just after it has been written to the output
+    typedef function<void(const float* samples, unsigned numFrames, unsigned numChannels)> Listener;
+
+    PcmPlayer();
+
+    // loads 16, 24 or 32 bit integer or 32 bit float wav files
+    bool load(const string& path);
+
+    // play samples that we've made ourselves rather than a file, they're
+    // interleaved with numChannels channels and between -1 and 1
+    void setSamples(const vector<float>& samples, unsigned numChannels, unsigned sampleRate);
+
+    void setListener(Listener listener) { this->listener = listener; }
+
+    void play() { playing = isLoaded(); }
+    void stop() { playing = false; }
+    void setLoop(bool loop) { this->loop = loop; }
+
+    bool isLoaded() const { return !samples.empty(); }
+    unsigned getSampleRate() const { return sampleRate; }
+    unsigned getNumChannels() const { return numChannels; }
+
+    // from ofBaseSoundOutput, this is called on the audio thread
+    void audioOut(float* output, int bufferSize, int nChannels);
+
+private:
+    vector<float> samples;
+    unsigned numChannels;
+    unsigned sampleRate;
+    unsigned numFrames;
+
+    // the frame that will be played next, only touched on the audio thread
+    unsigned position;
+
+    atomic<bool> playing;
+    atomic<bool> loop;
+
+    Listener listener;
+};
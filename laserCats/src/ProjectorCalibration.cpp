@@ -0,0 +1,476 @@
+#include "ProjectorCalibration.h"
+
+namespace
+{
+    // a pinhole camera in the usual computer vision convention, x right, y down,
+    // looking along +z, a world point p lands on the screen at
+    // (cx + f * c.x / c.z, cy + f * c.y / c.z) where c = r * p + t
+    struct Camera
+    {
+        double r[3][3];
+        double t[3];
+        double f;
+        double cx;
+        double cy;
+    };
+
+    // the number of parameters that levenberg-marquardt adjusts,
+    // a small rotation, the translation, focal length and principal point
+    const unsigned NUM_PARAMETERS = 9;
+
+    // rotation matrix for a rotation of |w| radians around w
+    void rodrigues(const double w[3], double r[3][3])
+    {
+        const double angle = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+        if (angle < 1e-12)
+        {
+            for (unsigned i = 0; i < 3; ++i) for (unsigned j = 0; j < 3; ++j) r[i][j] = i == j;
+            return;
+        }
+        const double x = w[0] / angle, y = w[1] / angle, z = w[2] / angle;
+        const double c = cos(angle), s = sin(angle), k = 1. - c;
+        r[0][0] = c + x * x * k;     r[0][1] = x * y * k - z * s; r[0][2] = x * z * k + y * s;
+        r[1][0] = y * x * k + z * s; r[1][1] = c + y * y * k;     r[1][2] = y * z * k - x * s;
+        r[2][0] = z * x * k - y * s; r[2][1] = z * y * k + x * s; r[2][2] = c + z * z * k;
+    }
+
+    void multiply(const double a[3][3], const double b[3][3], double out[3][3])
+    {
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                out[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+            }
+        }
+    }
+
+    // nudge the camera by parameters in the order described above
+    Camera update(const Camera& camera, const double* delta)
+    {
+        Camera updated = camera;
+        double rotation[3][3];
+        rodrigues(delta, rotation);
+        multiply(rotation, camera.r, updated.r);
+        for (unsigned i = 0; i < 3; ++i) updated.t[i] += delta[3 + i];
+        updated.f += delta[6];
+        updated.cx += delta[7];
+        updated.cy += delta[8];
+        return updated;
+    }
+
+    // the differences between where the points project to and their targets
+    void residuals(const Camera& camera, const vector<ofVec3f>& points, const vector<ofVec2f>& targets, double* out)
+    {
+        for (unsigned i = 0; i < points.size(); ++i)
+        {
+            double c[3];
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                c[j] = camera.r[j][0] * points[i].x + camera.r[j][1] * points[i].y + camera.r[j][2] * points[i].z + camera.t[j];
+            }
+
+            // a point behind the projector can't be seen so make it cost a lot
+            const double depth = max(c[2], 1e-6);
+            out[2 * i] = camera.cx + camera.f * c[0] / depth - targets[i].x;
+            out[2 * i + 1] = camera.cy + camera.f * c[1] / depth - targets[i].y;
+        }
+    }
+
+    double sumOfSquares(const vector<double>& values)
+    {
+        double sum = 0.;
+        for (unsigned i = 0; i < values.size(); ++i) sum += values[i] * values[i];
+        return sum;
+    }
+
+    // solve a * x = b for a square n by n system with gaussian elimination,
+    // a and b are overwritten, returns false if a is singular
+    bool solveLinear(vector<double>& a, vector<double>& b, unsigned n, vector<double>& x)
+    {
+        for (unsigned col = 0; col < n; ++col)
+        {
+            unsigned pivot = col;
+            for (unsigned row = col + 1; row < n; ++row)
+            {
+                if (fabs(a[row * n + col]) > fabs(a[pivot * n + col])) pivot = row;
+            }
+            if (fabs(a[pivot * n + col]) < 1e-15) return false;
+            if (pivot != col)
+            {
+                for (unsigned k = 0; k < n; ++k) swap(a[col * n + k], a[pivot * n + k]);
+                swap(b[col], b[pivot]);
+            }
+            for (unsigned row = col + 1; row < n; ++row)
+            {
+                const double factor = a[row * n + col] / a[col * n + col];
+                for (unsigned k = col; k < n; ++k) a[row * n + k] -= factor * a[col * n + k];
+                b[row] -= factor * b[col];
+            }
+        }
+
+        x.resize(n);
+        for (int row = n - 1; row >= 0; --row)
+        {
+            double sum = b[row];
+            for (unsigned k = row + 1; k < n; ++k) sum -= a[row * n + k] * x[k];
+            x[row] = sum / a[row * n + row];
+        }
+        return true;
+    }
+
+    // eigenvector with the smallest eigenvalue of a symmetric n by n matrix
+    // using jacobi rotations, which is plenty quick enough for a 12x12
+    vector<double> smallestEigenvector(vector<double> a, unsigned n)
+    {
+        vector<double> v(n * n, 0.);
+        for (unsigned i = 0; i < n; ++i) v[i * n + i] = 1.;
+
+        for (unsigned sweep = 0; sweep < 50; ++sweep)
+        {
+            double offDiagonal = 0.;
+            for (unsigned p = 0; p < n; ++p) for (unsigned q = p + 1; q < n; ++q) offDiagonal += a[p * n + q] * a[p * n + q];
+            if (offDiagonal < 1e-22) break;
+
+            for (unsigned p = 0; p < n; ++p)
+            {
+                for (unsigned q = p + 1; q < n; ++q)
+                {
+                    const double apq = a[p * n + q];
+                    if (fabs(apq) < 1e-300) continue;
+
+                    // the rotation that zeroes a[p][q]
+                    const double theta = (a[q * n + q] - a[p * n + p]) / (2. * apq);
+                    const double t = (theta >= 0. ? 1. : -1.) / (fabs(theta) + sqrt(theta * theta + 1.));
+                    const double c = 1. / sqrt(t * t + 1.);
+                    const double s = t * c;
+
+                    for (unsigned k = 0; k < n; ++k)
+                    {
+                        const double akp = a[k * n + p], akq = a[k * n + q];
+                        a[k * n + p] = c * akp - s * akq;
+                        a[k * n + q] = s * akp + c * akq;
+                    }
+                    for (unsigned k = 0; k < n; ++k)
+                    {
+                        const double apk = a[p * n + k], aqk = a[q * n + k];
+                        a[p * n + k] = c * apk - s * aqk;
+                        a[q * n + k] = s * apk + c * aqk;
+                    }
+                    for (unsigned k = 0; k < n; ++k)
+                    {
+                        const double vkp = v[k * n + p], vkq = v[k * n + q];
+                        v[k * n + p] = c * vkp - s * vkq;
+                        v[k * n + q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        unsigned smallest = 0;
+        for (unsigned i = 1; i < n; ++i) if (a[i * n + i] < a[smallest * n + smallest]) smallest = i;
+
+        vector<double> eigenvector(n);
+        for (unsigned i = 0; i < n; ++i) eigenvector[i] = v[i * n + smallest];
+        return eigenvector;
+    }
+
+    // estimate the camera with the direct linear transform, this finds the 3x4
+    // projection matrix that best maps the points onto their targets and then
+    // splits it into the camera's intrinsics and its rotation and translation
+    bool dlt(const vector<ofVec3f>& points, const vector<ofVec2f>& targets, Camera& camera)
+    {
+        const unsigned n = points.size();
+
+        // move the points so that they're centred on the origin and scale them
+        // to about unit size so that the numbers in the matrix are well behaved
+        ofVec3f pointCentre;
+        ofVec2f targetCentre;
+        for (unsigned i = 0; i < n; ++i)
+        {
+            pointCentre += points[i] / n;
+            targetCentre += targets[i] / n;
+        }
+        double pointDistance = 0., targetDistance = 0.;
+        for (unsigned i = 0; i < n; ++i)
+        {
+            pointDistance += points[i].distance(pointCentre) / n;
+            targetDistance += targets[i].distance(targetCentre) / n;
+        }
+        if (pointDistance < 1e-9 || targetDistance < 1e-9) return false;
+        const double pointScale = sqrt(3.) / pointDistance;
+        const double targetScale = sqrt(2.) / targetDistance;
+
+        // build up a^T a for the 2n x 12 system a * p = 0 as we go
+        vector<double> ata(12 * 12, 0.);
+        for (unsigned i = 0; i < n; ++i)
+        {
+            const double x = pointScale * (points[i].x - pointCentre.x);
+            const double y = pointScale * (points[i].y - pointCentre.y);
+            const double z = pointScale * (points[i].z - pointCentre.z);
+            const double u = targetScale * (targets[i].x - targetCentre.x);
+            const double v = targetScale * (targets[i].y - targetCentre.y);
+            const double rows[2][12] = {
+                { x, y, z, 1., 0., 0., 0., 0., -u * x, -u * y, -u * z, -u },
+                { 0., 0., 0., 0., x, y, z, 1., -v * x, -v * y, -v * z, -v }
+            };
+            for (unsigned row = 0; row < 2; ++row)
+            {
+                for (unsigned j = 0; j < 12; ++j)
+                {
+                    for (unsigned k = 0; k < 12; ++k) ata[j * 12 + k] += rows[row][j] * rows[row][k];
+                }
+            }
+        }
+        const vector<double> normalised = smallestEigenvector(ata, 12);
+
+        // undo the normalisation, p = targetToPixels * normalised * pointsToNormalised
+        double p[3][4];
+        for (unsigned row = 0; row < 3; ++row)
+        {
+            const double* m = &normalised[row * 4];
+            p[row][0] = m[0] * pointScale;
+            p[row][1] = m[1] * pointScale;
+            p[row][2] = m[2] * pointScale;
+            p[row][3] = m[3] - pointScale * (m[0] * pointCentre.x + m[1] * pointCentre.y + m[2] * pointCentre.z);
+        }
+        for (unsigned col = 0; col < 4; ++col)
+        {
+            p[0][col] = p[0][col] / targetScale + targetCentre.x * p[2][col];
+            p[1][col] = p[1][col] / targetScale + targetCentre.y * p[2][col];
+        }
+
+        // p is only known up to a scale so we scale it so that the third row
+        // of the rotation has unit length and the points are in front of the camera
+        double scale = 1. / sqrt(p[2][0] * p[2][0] + p[2][1] * p[2][1] + p[2][2] * p[2][2]);
+        if (p[2][0] * pointCentre.x + p[2][1] * pointCentre.y + p[2][2] * pointCentre.z + p[2][3] < 0.) scale = -scale;
+        for (unsigned row = 0; row < 3; ++row) for (unsigned col = 0; col < 4; ++col) p[row][col] *= scale;
+
+        // split p into an upper triangular intrinsic matrix and a rotation by
+        // working up from the bottom row, see hartley & zisserman section 6.2.4
+        const ofVec3f m1(p[0][0], p[0][1], p[0][2]);
+        const ofVec3f m2(p[1][0], p[1][1], p[1][2]);
+        const ofVec3f r3(p[2][0], p[2][1], p[2][2]);
+        const double cy = m2.dot(r3);
+        const ofVec3f y2 = m2 - cy * r3;
+        const double fy = y2.length();
+        if (fy < 1e-9) return false;
+        const ofVec3f r2 = y2 / fy;
+        const double cx = m1.dot(r3);
+        const double skew = m1.dot(r2);
+        const ofVec3f x1 = m1 - skew * r2 - cx * r3;
+        const double fx = x1.length();
+        if (fx < 1e-9) return false;
+        const ofVec3f r1 = x1 / fx;
+
+        // if the rotation is a reflection then the points didn't fit a camera
+        if (r1.getCrossed(r2).dot(r3) < 0.) return false;
+
+        // we assume square pixels and no skew which the refinement sorts out
+        const ofVec3f rows[3] = { r1, r2, r3 };
+        for (unsigned row = 0; row < 3; ++row)
+        {
+            camera.r[row][0] = rows[row].x;
+            camera.r[row][1] = rows[row].y;
+            camera.r[row][2] = rows[row].z;
+        }
+        camera.f = .5 * (fx + fy);
+        camera.cx = cx;
+        camera.cy = cy;
+        camera.t[2] = p[2][3];
+        camera.t[1] = (p[1][3] - cy * camera.t[2]) / fy;
+        camera.t[0] = (p[0][3] - skew * camera.t[1] - cx * camera.t[2]) / fx;
+        return true;
+    }
+
+    // refine the camera by minimising the distances between
+    // the projected points and their targets
+    unsigned levenbergMarquardt(const vector<ofVec3f>& points, const vector<ofVec2f>& targets, bool solveLensOffset, Camera& camera)
+    {
+        const unsigned numResiduals = 2 * points.size();
+        const unsigned numParameters = solveLensOffset ? NUM_PARAMETERS : NUM_PARAMETERS - 2;
+
+        vector<double> current(numResiduals), nudged(numResiduals), jacobian(numResiduals * numParameters);
+        residuals(camera, points, targets, &current[0]);
+        double cost = sumOfSquares(current);
+        double lambda = 1e-3;
+
+        unsigned iteration = 0;
+        for (; iteration < 100 && cost > 1e-12; ++iteration)
+        {
+            // work out the jacobian with central differences, the steps are
+            // scaled to how big each parameter is likely to be
+            const double tScale = max(1., sqrt(camera.t[0] * camera.t[0] + camera.t[1] * camera.t[1] + camera.t[2] * camera.t[2]));
+            const double steps[NUM_PARAMETERS] = { 1e-6, 1e-6, 1e-6, 1e-6 * tScale, 1e-6 * tScale, 1e-6 * tScale, 1e-6 * camera.f, 1e-3, 1e-3 };
+            for (unsigned j = 0; j < numParameters; ++j)
+            {
+                double delta[NUM_PARAMETERS] = { 0. };
+                delta[j] = steps[j];
+                residuals(update(camera, delta), points, targets, &nudged[0]);
+                delta[j] = -steps[j];
+                residuals(update(camera, delta), points, targets, &current[0]);
+                for (unsigned i = 0; i < numResiduals; ++i) jacobian[i * numParameters + j] = (nudged[i] - current[i]) / (2. * steps[j]);
+            }
+            residuals(camera, points, targets, &current[0]);
+
+            // the normal equations, j^T j and j^T r
+            vector<double> jtj(numParameters * numParameters, 0.), jtr(numParameters, 0.);
+            for (unsigned i = 0; i < numResiduals; ++i)
+            {
+                const double* row = &jacobian[i * numParameters];
+                for (unsigned j = 0; j < numParameters; ++j)
+                {
+                    jtr[j] += row[j] * current[i];
+                    for (unsigned k = 0; k < numParameters; ++k) jtj[j * numParameters + k] += row[j] * row[k];
+                }
+            }
+
+            // try steps, making them more cautious until one makes things better
+            bool improved = false;
+            while (!improved && lambda < 1e10)
+            {
+                vector<double> a = jtj, b(numParameters), step;
+                for (unsigned j = 0; j < numParameters; ++j)
+                {
+                    a[j * numParameters + j] += lambda * max(jtj[j * numParameters + j], 1e-12);
+                    b[j] = -jtr[j];
+                }
+
+                if (solveLinear(a, b, numParameters, step))
+                {
+                    double delta[NUM_PARAMETERS] = { 0. };
+                    for (unsigned j = 0; j < numParameters; ++j) delta[j] = step[j];
+                    const Camera candidate = update(camera, delta);
+                    residuals(candidate, points, targets, &nudged[0]);
+                    const double candidateCost = sumOfSquares(nudged);
+                    if (candidateCost < cost)
+                    {
+                        const double improvement = cost - candidateCost;
+                        camera = candidate;
+                        current.swap(nudged);
+                        cost = candidateCost;
+                        lambda = max(lambda * .1, 1e-12);
+                        improved = true;
+
+                        // stop once we're not getting anywhere
+                        if (improvement < 1e-10 * cost) return iteration + 1;
+                    }
+                }
+                if (!improved) lambda *= 10.;
+            }
+            if (!improved) break;
+        }
+        return iteration;
+    }
+}
+
+ProjectorCalibration::Result::Result() :
+    solved(false),
+    fov(0.f),
+    rmsError(0.f),
+    numIterations(0),
+    usedDlt(false),
+    solveMillis(0.f)
+{
+}
+
+void ProjectorCalibration::setup(const ofVec3f* modelPoints, unsigned numPoints)
+{
+    this->modelPoints.assign(modelPoints, modelPoints + numPoints);
+    targets.assign(numPoints, ofVec2f());
+    hasTargets.assign(numPoints, false);
+}
+
+void ProjectorCalibration::setTarget(unsigned i, const ofVec2f& target)
+{
+    if (i >= targets.size()) return;
+    targets[i] = target;
+    hasTargets[i] = true;
+}
+
+void ProjectorCalibration::clearTarget(unsigned i)
+{
+    if (i < hasTargets.size()) hasTargets[i] = false;
+}
+
+void ProjectorCalibration::clearTargets()
+{
+    hasTargets.assign(hasTargets.size(), false);
+}
+
+unsigned ProjectorCalibration::getNumTargets() const
+{
+    return count(hasTargets.begin(), hasTargets.end(), true);
+}
+
+ProjectorCalibration::Result ProjectorCalibration::solve(const ofCamera& camera, const ofMatrix4x4& modelTransform, const ofRectangle& viewport) const
+{
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    Result result;
+
+    // the points that have targets, in the world
+    vector<ofVec3f> points;
+    vector<ofVec2f> pointTargets;
+    for (unsigned i = 0; i < modelPoints.size(); ++i)
+    {
+        if (!hasTargets[i]) continue;
+        points.push_back(modelPoints[i] * modelTransform);
+        pointTargets.push_back(targets[i] - ofVec2f(viewport.x, viewport.y));
+    }
+    if (points.size() < MIN_TARGETS) return result;
+
+    // where we start from if we can't use the dlt, an openFrameworks camera
+    // looks along -z with y up so we flip those axes to get to our convention
+    Camera solved;
+    const ofVec3f axes[3] = { camera.getXAxis(), -camera.getYAxis(), -camera.getZAxis() };
+    const ofVec3f position = camera.getGlobalPosition();
+    for (unsigned row = 0; row < 3; ++row)
+    {
+        solved.r[row][0] = axes[row].x;
+        solved.r[row][1] = axes[row].y;
+        solved.r[row][2] = axes[row].z;
+        solved.t[row] = -axes[row].dot(position);
+    }
+    solved.f = .5 * viewport.height / tan(.5 * ofDegToRad(camera.getFov()));
+    solved.cx = .5 * viewport.width * (1. - camera.getLensOffset().x);
+    solved.cy = .5 * viewport.height * (1. + camera.getLensOffset().y);
+
+    // the dlt needs six points that aren't all on one plane, if it fails
+    // or comes up with something daft we stick with where we started
+    Camera estimate = solved;
+    if (points.size() >= MIN_TARGETS_FOR_DLT && dlt(points, pointTargets, estimate) && estimate.f > 0.)
+    {
+        solved = estimate;
+        result.usedDlt = true;
+    }
+
+    result.numIterations = levenbergMarquardt(points, pointTargets, points.size() >= MIN_TARGETS_FOR_LENS_OFFSET, solved);
+
+    vector<double> errors(2 * points.size());
+    residuals(solved, points, pointTargets, &errors[0]);
+    result.rmsError = sqrt(sumOfSquares(errors) / points.size());
+
+    // and back to openFrameworks' conventions, the rows of the rotation are
+    // the camera's axes in the world, which is what ofNode::lookAt() uses too
+    ofVec3f xAxis(solved.r[0][0], solved.r[0][1], solved.r[0][2]);
+    ofVec3f yAxis(-solved.r[1][0], -solved.r[1][1], -solved.r[1][2]);
+    ofVec3f zAxis(-solved.r[2][0], -solved.r[2][1], -solved.r[2][2]);
+    ofMatrix4x4 orientation;
+    orientation._mat[0].set(xAxis.x, xAxis.y, xAxis.z, 0.f);
+    orientation._mat[1].set(yAxis.x, yAxis.y, yAxis.z, 0.f);
+    orientation._mat[2].set(zAxis.x, zAxis.y, zAxis.z, 0.f);
+    result.orientation = orientation.getRotate();
+
+    // the camera is at -r^T t
+    result.position.set(0.f, 0.f, 0.f);
+    for (unsigned row = 0; row < 3; ++row)
+    {
+        result.position -= ofVec3f(solved.r[row][0], solved.r[row][1], solved.r[row][2]) * solved.t[row];
+    }
+
+    result.fov = ofRadToDeg(2. * atan(.5 * viewport.height / solved.f));
+    result.lensOffset.set(1. - 2. * solved.cx / viewport.width, 2. * solved.cy / viewport.height - 1.);
+    result.solved = solved.f > 0. && ofInRange(result.fov, 1.f, 170.f);
+    result.solveMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+    return result;
+}
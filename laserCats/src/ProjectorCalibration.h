@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ofMain.h"
+
+// works out where a projector is, which way it's pointing, its field of view
+// and its lens offset from where some known points on the object land in
+// the projector's image
+//
+// each point on the model (e.g. a corner of the box) can be given a target,
+// which is where that point needs to be on the screen for the projection to
+// line up, once there are enough targets solve() finds the camera that puts
+// the points as close to their targets as possible
+//
+// with six or more targets we get a first guess from the direct linear
+// transform (DLT), which needs no idea of where the projector is, with fewer
+// we start from the camera we have, either way this is then refined by
+// minimising the distance between the projected points and their targets
+// using levenberg-marquardt
+class ProjectorCalibration
+{
+public:
+    // the fewest targets we can solve with, with fewer than
+    // MIN_TARGETS_FOR_LENS_OFFSET the lens offset isn't changed
+    static const unsigned MIN_TARGETS = 4;
+    static const unsigned MIN_TARGETS_FOR_LENS_OFFSET = 5;
+    static const unsigned MIN_TARGETS_FOR_DLT = 6;
+
+    struct Result
+    {
+        Result();
+
+        bool solved;
+        ofVec3f position;
+        ofQuaternion orientation;
+
+        // vertical field of view in degrees and lens offset in the same units as ofCamera
+        float fov;
+        ofVec2f lensOffset;
+
+        // root mean square distance between the projected points and their targets in pixels
+        float rmsError;
+        unsigned numIterations;
+        bool usedDlt;
+        float solveMillis;
+    };
+
+    // the points on the model that can be given targets
+    void setup(const ofVec3f* modelPoints, unsigned numPoints);
+
+    unsigned getNumPoints() const { return modelPoints.size(); }
+    const ofVec3f& getModelPoint(unsigned i) const { return modelPoints[i]; }
+
+    // targets are in screen pixels with (0, 0) at the top left
+    void setTarget(unsigned i, const ofVec2f& target);
+    void clearTarget(unsigned i);
+    void clearTargets();
+    bool hasTarget(unsigned i) const { return i < hasTargets.size() && hasTargets[i]; }
+    const ofVec2f& getTarget(unsigned i) const { return targets[i]; }
+    unsigned getNumTargets() const;
+
+    // find the camera that projects the model points onto their targets,
+    // modelTransform puts the model where it is in the world (e.g. rotated
+    // by boxAngle), camera is used as the starting point when there aren't
+    // enough targets for the DLT and viewport is the size of the output
+    Result solve(const ofCamera& camera, const ofMatrix4x4& modelTransform, const ofRectangle& viewport) const;
+
+private:
+    vector<ofVec3f> modelPoints;
+    vector<ofVec2f> targets;
+    vector<bool> hasTargets;
+};
@@ -0,0 +1,75 @@
+#include "ProjectorOutput.h"
+
+void ProjectorOutput::setup(const string& name)
+{
+    // put our projector 200cm away from our object that will be at the origin
+    // and look at the origin where our box is
+    camera.setPosition(0, 0, -200.f);
+    camera.lookAt(ofVec3f(0.f, 0.f, 0.f));
+
+    // the camera follows the parameters, these are called when they're set below
+    position.addListener(this, &ProjectorOutput::positionChanged);
+    tilt.addListener(this, &ProjectorOutput::orientationChanged);
+    pan.addListener(this, &ProjectorOutput::orientationChanged);
+    roll.addListener(this, &ProjectorOutput::orientationChanged);
+    fov.addListener(this, &ProjectorOutput::fovChanged);
+    lensOffset.addListener(this, &ProjectorOutput::lensOffsetChanged);
+
+    parameters.setName(name);
+    parameters.add(tilt.set("projectorTilt", 0.f, -30.f, -10.f));
+    parameters.add(position.set("projectorPosition",
+                                ofVec3f(0.f, 0.f, -200.f),
+                                ofVec3f(-10.f, 20.f, -150.f),
+                                ofVec3f(10.f, 50.f, -100.f)));
+
+    // looking at the box from in front of it means we're turned 180 degrees
+    // around the y axis, these are usually only changed by the calibration
+    parameters.add(pan.set("projectorPan", 180.f, 150.f, 210.f));
+    parameters.add(roll.set("projectorRoll", 0.f, -10.f, 10.f));
+
+    // our camera's vertical field of view
+    // this can be calculated using this spreadsheet
+    // https://docs.google.com/spreadsheets/d/136NbNeFGER7yiOVgik7hueTRkYGkNHcqBlRFdfcix7I/edit#gid=0
+    // or found by the calibration, which also finds the lens offset
+    parameters.add(fov.set("projectorFov", 16.84f, 5.f, 60.f));
+    parameters.add(lensOffset.set("projectorLensOffset", ofVec2f(0.f, 0.f), ofVec2f(-1.f, -1.f), ofVec2f(1.f, 1.f)));
+
+    lastCalibration.solved = false;
+}
+
+void ProjectorOutput::applyCalibration(const ProjectorCalibration::Result& result)
+{
+    // the position, fov and lens offset go through their listeners as usual,
+    // for the orientation we set the angles without calling the listener and
+    // use the exact rotation the calibration found instead
+    position = result.position;
+    fov = result.fov;
+    lensOffset = result.lensOffset;
+
+    const ofVec3f euler = result.orientation.getEuler();
+    tilt.setWithoutEventNotifications(euler.x);
+    pan.setWithoutEventNotifications(euler.y);
+    roll.setWithoutEventNotifications(euler.z);
+    camera.setOrientation(result.orientation);
+}
+
+void ProjectorOutput::positionChanged(ofVec3f& position)
+{
+    camera.setPosition(position);
+}
+
+void ProjectorOutput::orientationChanged(float& angle)
+{
+    // tilt, pan and roll are the rotations around the x, y and z axes
+    camera.setOrientation(ofVec3f(tilt, pan, roll));
+}
+
+void ProjectorOutput::fovChanged(float& fov)
+{
+    camera.setFov(fov);
+}
+
+void ProjectorOutput::lensOffsetChanged(ofVec2f& lensOffset)
+{
+    camera.setLensOffset(lensOffset);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ProjectorCalibration.h"
+#include "WarpRemap.h"
+
+// everything that belongs to one projector when we're driving several of
+// them from one app, the scene is shared and each projector just looks at
+// it from a different place
+//
+// the parameters have the same names as when there was only one projector
+// so the first output can be added to the gui on its own and still load
+// the settings that were saved before, the rest go in their own groups
+class ProjectorOutput
+{
+public:
+    // name is what the group of parameters is called in the gui
+    void setup(const string& name);
+
+    // put the projector where a calibration says it is
+    void applyCalibration(const ProjectorCalibration::Result& result);
+
+    ofCamera camera;
+
+    ofParameterGroup parameters;
+    ofParameter<ofVec3f> position;
+    ofParameter<float> tilt;
+    ofParameter<float> pan;
+    ofParameter<float> roll;
+    ofParameter<float> fov;
+    ofParameter<ofVec2f> lensOffset;
+
+    // each projector is calibrated on its own against the same corners of the box
+    ProjectorCalibration calibration;
+    ProjectorCalibration::Result lastCalibration;
+
+    // the box as this projector sees it for when remapBox is on
+    WarpRemap remap;
+
+private:
+    void positionChanged(ofVec3f& position);
+    void orientationChanged(float& angle);
+    void fovChanged(float& fov);
+    void lensOffsetChanged(ofVec2f& lensOffset);
+};
@@ -0,0 +1,154 @@
+#include "SpectrumAnalyser.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define SPECTRUM_ANALYSER_SSE
+#endif
+
+SpectrumAnalyser::SpectrumAnalyser() :
+    numRawBins(0),
+    numBands(0),
+    numPaddedBands(0),
+    decay(0.96f),
+    bands(NULL),
+    smoothed(NULL),
+    maxima(NULL),
+    normalised(NULL)
+{
+}
+
+void SpectrumAnalyser::setup(unsigned numRawBins, unsigned numBands)
+{
+    this->numRawBins = numRawBins;
+    this->numBands = numBands;
+    numPaddedBands = SIMD_WIDTH * ((numBands + SIMD_WIDTH - 1) / SIMD_WIDTH);
+
+    // allocate all four arrays in one go with enough extra
+    // room to line the first one up on a 16 byte boundary
+    storage.assign(4 * numPaddedBands + SIMD_WIDTH, 0.f);
+    uintptr_t address = (uintptr_t)&storage[0];
+    bands = (float*)((address + 15) & ~(uintptr_t)15);
+    smoothed = bands + numPaddedBands;
+    maxima = smoothed + numPaddedBands;
+    normalised = maxima + numPaddedBands;
+
+    // work out where each band starts, the bands are spaced evenly on a
+    // log scale from the first bin above dc to the top of the spectrum
+    bandEdges.resize(numBands + 1);
+    if (numRawBins == numBands)
+    {
+        for (unsigned i = 0; i <= numBands; ++i) bandEdges[i] = i;
+    }
+    else
+    {
+        const float minBin = 1.f;
+        const float maxBin = numRawBins;
+        bandEdges[0] = 1;
+        for (unsigned i = 1; i <= numBands; ++i)
+        {
+            unsigned edge = floor(minBin * pow(maxBin / minBin, i / (float)numBands) + .5f);
+
+            // low bands would be narrower than a bin so make sure every
+            // band gets at least one and that we don't run off the end
+            edge = max(edge, bandEdges[i - 1] + 1);
+            bandEdges[i] = min(edge, numRawBins);
+        }
+    }
+}
+
+void SpectrumAnalyser::reset()
+{
+    if (!storage.empty()) memset(maxima, 0, sizeof(float) * numPaddedBands);
+}
+
+void SpectrumAnalyser::update(const float* spectrum, float elapsedSeconds)
+{
+    aggregate(spectrum);
+    smooth(elapsedSeconds);
+}
+
+void SpectrumAnalyser::aggregate(const float* spectrum)
+{
+    for (unsigned i = 0; i < numBands; ++i)
+    {
+        // if we've got more bands than bins there will be bands at the
+        // top that are empty, these just hold on to their last bin
+        const unsigned begin = min(bandEdges[i], numRawBins - 1);
+        const unsigned end = max(bandEdges[i + 1], begin + 1);
+
+        float sum = 0.f;
+        for (unsigned j = begin; j < end; ++j) sum += spectrum[j];
+        bands[i] = sum / (end - begin);
+    }
+}
+
+void SpectrumAnalyser::smooth(float elapsedSeconds)
+{
+    // how much is left after this long rather than after a 60th of a second
+    const float elapsedDecay = pow(decay, max(elapsedSeconds, 0.f) * DECAY_RATE);
+#ifdef SPECTRUM_ANALYSER_SSE
+    const __m128 decays = _mm_set1_ps(elapsedDecay);
+    const __m128 zeros = _mm_setzero_ps();
+    for (unsigned i = 0; i < numPaddedBands; i += SIMD_WIDTH)
+    {
+        const __m128 band = _mm_load_ps(bands + i);
+
+        // let the smoothed value sink to zero and then take the maximum of
+        // that and the new value so it rises immediately and falls smoothly
+        const __m128 smooth = _mm_max_ps(band, _mm_mul_ps(_mm_load_ps(smoothed + i), decays));
+        _mm_store_ps(smoothed + i, smooth);
+
+        // hold on to the loudest value we've seen for each band
+        const __m128 maximum = _mm_max_ps(band, _mm_load_ps(maxima + i));
+        _mm_store_ps(maxima + i, maximum);
+
+        // divide by the maximum to get a value between 0 and 1, rather than
+        // branching we use a mask to keep the old value where the maximum is zero
+        const __m128 mask = _mm_cmpneq_ps(maximum, zeros);
+        const __m128 divided = _mm_div_ps(smooth, maximum);
+        const __m128 previous = _mm_load_ps(normalised + i);
+        _mm_store_ps(normalised + i, _mm_or_ps(_mm_and_ps(mask, divided), _mm_andnot_ps(mask, previous)));
+    }
+#else
+    for (unsigned i = 0; i < numPaddedBands; ++i)
+    {
+        smoothed[i] = max(bands[i], smoothed[i] * elapsedDecay);
+        maxima[i] = max(bands[i], maxima[i]);
+        if (maxima[i] != 0.f) normalised[i] = smoothed[i] / maxima[i];
+    }
+#endif
+}
+
+string SpectrumAnalyser::benchmark(unsigned numIterations)
+{
+    static const unsigned RAW_BINS[] = { 512, 1024, 2048 };
+    static const unsigned BANDS[] = { 8, 16, 32, 64, 128 };
+
+    stringstream report;
+    report << "rawBins, bands, usPerUpdate, nsPerBand" << endl;
+
+    for (unsigned i = 0; i < sizeof(RAW_BINS) / sizeof(RAW_BINS[0]); ++i)
+    {
+        // make up a spectrum that falls off with frequency like real music
+        vector<float> spectrum(RAW_BINS[i]);
+        for (unsigned j = 0; j < spectrum.size(); ++j) spectrum[j] = 1.f / (1.f + j);
+
+        for (unsigned j = 0; j < sizeof(BANDS) / sizeof(BANDS[0]); ++j)
+        {
+            SpectrumAnalyser analyser;
+            analyser.setup(RAW_BINS[i], BANDS[j]);
+
+            unsigned long long start = ofGetElapsedTimeMicros();
+            for (unsigned k = 0; k < numIterations; ++k)
+            {
+                // wobble the input a little so the smoothing has something to do
+                spectrum[k % spectrum.size()] *= (k & 1) ? 1.1f : .9f;
+                analyser.update(&spectrum[0]);
+            }
+            const double microsPerUpdate = (ofGetElapsedTimeMicros() - start) / (double)numIterations;
+
+            report << RAW_BINS[i] << ", " << BANDS[j] << ", " << microsPerUpdate << ", " << 1000. * microsPerUpdate / BANDS[j] << endl;
+        }
+    }
+    return report.str();
+}
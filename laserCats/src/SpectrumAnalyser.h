@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ofMain.h"
+
+// takes the raw spectrum from the fft, groups the bins into bands that
+// are spaced logarithmically in frequency (which is much closer to how
+// we hear) and then smooths and normalises each band
+//
+// the band data is held as separate aligned arrays (rather than an array
+// of structs) so that the smoothing can be done four bands at a time
+// using SIMD instructions
+class SpectrumAnalyser
+{
+public:
+    static const unsigned SIMD_WIDTH = 4;
+
+    // the decay is how much is left after 1 / DECAY_RATE seconds, which is
+    // a frame at 60fps where the bands used to be updated
+    static const unsigned DECAY_RATE = 60;
+
+    SpectrumAnalyser();
+
+    // the band arrays point into storage, a copy would point into ours
+    SpectrumAnalyser(const SpectrumAnalyser&) = delete;
+    SpectrumAnalyser& operator=(const SpectrumAnalyser&) = delete;
+
+    // numRawBins is how many bins we get from the fft, numBands is how
+    // many bands we want to display, if they are the same then the
+    // raw bins are used as they are
+    void setup(unsigned numRawBins, unsigned numBands);
+
+    // process a new spectrum, it must contain numRawBins values, elapsedSeconds
+    // is how long it's been since the last one so the bands fall at the same
+    // speed however often we're called
+    void update(const float* spectrum, float elapsedSeconds = 1.f / DECAY_RATE);
+
+    // values between 0 and 1 for each band
+    const float* getNormalised() const { return normalised; }
+    const float* getSmoothed() const { return smoothed; }
+
+    unsigned getNumRawBins() const { return numRawBins; }
+    unsigned getNumBands() const { return numBands; }
+
+    // the first raw bin of a band, band numBands is where the last one stops
+    unsigned getBandEdge(unsigned band) const { return bandEdges[band]; }
+
+    // how much of the smoothed value is left after 1 / DECAY_RATE seconds
+    void setDecay(float decay) { this->decay = decay; }
+    float getDecay() const { return decay; }
+
+    // forget the loudest value we've seen for each band
+    void reset();
+
+    // times the analyser with a range of raw bin and band counts and
+    // returns a report of how long each update takes
+    static string benchmark(unsigned numIterations = 10000);
+
+private:
+    // group the raw bins into bands
+    void aggregate(const float* spectrum);
+
+    // decay, peak hold and normalisation, four bands at a time
+    void smooth(float elapsedSeconds);
+
+    unsigned numRawBins;
+    unsigned numBands;
+
+    // the number of bands rounded up to a multiple of SIMD_WIDTH
+    unsigned numPaddedBands;
+
+    float decay;
+
+    // the first raw bin of each band, there's an extra
+    // one on the end which is where the last band stops
+    vector<unsigned> bandEdges;
+
+    // all of the band arrays live in here and are aligned to 16 bytes
+    vector<float> storage;
+    float* bands;
+    float* smoothed;
+    float* maxima;
+    float* normalised;
+};
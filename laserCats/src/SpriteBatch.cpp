@@ -0,0 +1,71 @@
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch() : texture(NULL), numSprites(0)
+{
+    // every sprite is made up of two triangles
+    mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+
+    // the mesh is rebuilt every frame so let the driver
+    // know that we will be streaming new data into it
+    mesh.setUsage(GL_STREAM_DRAW);
+}
+
+void SpriteBatch::setTexture(ofTexture& texture)
+{
+    this->texture = &texture;
+
+    // work out the texture coordinates of the corners of the texture
+    // this works for both rectangle (pixel) and normalised textures
+    texCoordTopLeft = texture.getCoordFromPercent(0.f, 0.f);
+    texCoordBottomRight = texture.getCoordFromPercent(1.f, 1.f);
+}
+
+void SpriteBatch::clear()
+{
+    // clearing the vectors keeps their memory around
+    // so we don't reallocate every frame
+    mesh.getVertices().clear();
+    mesh.getColors().clear();
+    mesh.getTexCoords().clear();
+    mesh.getIndices().clear();
+    numSprites = 0;
+}
+
+void SpriteBatch::add(float x, float y, float w, float h, const ofFloatColor& colour)
+{
+    const ofIndexType first = mesh.getNumVertices();
+
+    // add the four corners in the same order that ofTexture::draw()
+    // does so that a negative width or height flips the sprite
+    mesh.addVertex(ofVec3f(x, y, 0.f));
+    mesh.addVertex(ofVec3f(x + w, y, 0.f));
+    mesh.addVertex(ofVec3f(x + w, y + h, 0.f));
+    mesh.addVertex(ofVec3f(x, y + h, 0.f));
+
+    mesh.addTexCoord(texCoordTopLeft);
+    mesh.addTexCoord(ofVec2f(texCoordBottomRight.x, texCoordTopLeft.y));
+    mesh.addTexCoord(texCoordBottomRight);
+    mesh.addTexCoord(ofVec2f(texCoordTopLeft.x, texCoordBottomRight.y));
+
+    // the tint is stored per vertex rather than set with ofSetColor()
+    // which is what lets us draw lots of different colours at once
+    for (unsigned i = 0; i < 4; ++i) mesh.addColor(colour);
+
+    mesh.addIndex(first);
+    mesh.addIndex(first + 1);
+    mesh.addIndex(first + 2);
+    mesh.addIndex(first);
+    mesh.addIndex(first + 2);
+    mesh.addIndex(first + 3);
+
+    ++numSprites;
+}
+
+void SpriteBatch::draw()
+{
+    if (!numSprites || !texture) return;
+
+    texture->bind();
+    mesh.draw();
+    texture->unbind();
+}
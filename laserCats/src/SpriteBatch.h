@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+
+// a sprite batch collects lots of tinted copies of the same texture
+// into a single mesh so that they can all be sent to the graphics
+// card and drawn with one draw call rather than one call per sprite
+class SpriteBatch
+{
+public:
+    SpriteBatch();
+
+    // set the texture that all of the sprites in the batch will use
+    void setTexture(ofTexture& texture);
+
+    // remove all of the sprites from the batch
+    void clear();
+
+    // add a sprite, the arguments work in the same way as ofImage::draw()
+    // so a negative width or height will flip the sprite
+    void add(float x, float y, float w, float h, const ofFloatColor& colour);
+
+    // draw all of the sprites that have been added since the last clear()
+    void draw();
+
+    unsigned getNumSprites() const { return numSprites; }
+
+private:
+    ofVboMesh mesh;
+    ofTexture* texture;
+    ofVec2f texCoordTopLeft;
+    ofVec2f texCoordBottomRight;
+    unsigned numSprites;
+};
@@ -0,0 +1,335 @@
+#include "StreamingFft.h"
+#include "SpectrumAnalyser.h"
+
+StreamingFft::StreamingFft() :
+    fftSize(0),
+    hopSize(0),
+    windowGain(1.f),
+    writePosition(0),
+    numSamplesInHistory(0),
+    samplesSinceLastFrame(0)
+{
+}
+
+void StreamingFft::setup(unsigned fftSize, unsigned hopSize, Window windowType)
+{
+    if (fftSize < 4 || (fftSize & (fftSize - 1)))
+    {
+        ofLogError("StreamingFft") << "fft size must be a power of two, got " << fftSize;
+        return;
+    }
+
+    this->fftSize = fftSize;
+    this->hopSize = max(1u, hopSize);
+
+    history.assign(fftSize, 0.f);
+    frame.assign(fftSize, 0.f);
+    magnitudes.assign(fftSize / 2, 0.f);
+    writePosition = 0;
+    numSamplesInHistory = 0;
+    samplesSinceLastFrame = 0;
+
+    // work out the window and how much it scales the
+    // signal down by so that we can undo that afterwards
+    window.resize(fftSize);
+    float windowSum = 0.f;
+    for (unsigned i = 0; i < fftSize; ++i)
+    {
+        const float phase = TWO_PI * i / fftSize;
+        switch (windowType)
+        {
+            case HANN:
+                window[i] = .5f - .5f * cos(phase);
+                break;
+
+            case HAMMING:
+                window[i] = .54f - .46f * cos(phase);
+                break;
+
+            case BLACKMAN_HARRIS:
+                window[i] = .35875f - .48829f * cos(phase) + .14128f * cos(2.f * phase) - .01168f * cos(3.f * phase);
+                break;
+
+            default:
+                window[i] = 1.f;
+                break;
+        }
+        windowSum += window[i];
+    }
+    windowGain = 2.f / windowSum;
+
+    // we do a real fft of size n using a complex fft of size n / 2
+    // so the tables are for the smaller complex fft
+    const unsigned n = fftSize / 2;
+    twiddles.resize(n);
+    for (unsigned i = 0; i < n / 2; ++i)
+    {
+        twiddles[2 * i] = cos(TWO_PI * i / n);
+        twiddles[2 * i + 1] = -sin(TWO_PI * i / n);
+    }
+
+    // and these are for untangling the result of that into the real fft
+    realTwiddles.resize(fftSize);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        realTwiddles[2 * i] = cos(TWO_PI * i / fftSize);
+        realTwiddles[2 * i + 1] = -sin(TWO_PI * i / fftSize);
+    }
+
+    unsigned numBits = 0;
+    while ((1u << numBits) < n) ++numBits;
+    bitReversed.resize(n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        unsigned reversed = 0;
+        for (unsigned bit = 0; bit < numBits; ++bit)
+        {
+            if (i & (1u << bit)) reversed |= 1u << (numBits - 1 - bit);
+        }
+        bitReversed[i] = reversed;
+    }
+}
+
+void StreamingFft::process(const float* samples, unsigned numFrames, unsigned numChannels)
+{
+    if (!fftSize || !numChannels) return;
+
+    const float channelScale = 1.f / numChannels;
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        // mix down to mono
+        float sample = 0.f;
+        for (unsigned j = 0; j < numChannels; ++j) sample += samples[i * numChannels + j];
+
+        history[writePosition] = sample * channelScale;
+        writePosition = (writePosition + 1) & (fftSize - 1);
+        if (numSamplesInHistory < fftSize) ++numSamplesInHistory;
+
+        // once we've got a full fft's worth of samples analyse every hop
+        if (++samplesSinceLastFrame >= hopSize && numSamplesInHistory == fftSize)
+        {
+            samplesSinceLastFrame = 0;
+            analyse();
+        }
+    }
+}
+
+void StreamingFft::analyse()
+{
+    // unwrap the history so the oldest sample is first and apply the window
+    for (unsigned i = 0; i < fftSize; ++i)
+    {
+        frame[i] = history[(writePosition + i) & (fftSize - 1)] * window[i];
+    }
+
+    // treat pairs of real samples as complex numbers and do a half size fft
+    complexFft(&frame[0]);
+
+    // then untangle the even and odd parts to get the spectrum of the real signal
+    const unsigned n = fftSize / 2;
+    for (unsigned k = 0; k < n; ++k)
+    {
+        const unsigned conjugate = (n - k) & (n - 1);
+        const float zr = frame[2 * k], zi = frame[2 * k + 1];
+        const float cr = frame[2 * conjugate], ci = -frame[2 * conjugate + 1];
+
+        // even part (z + conj) / 2 and odd part (z - conj) / 2i
+        const float er = .5f * (zr + cr), ei = .5f * (zi + ci);
+        const float or_ = .5f * (zi - ci), oi = -.5f * (zr - cr);
+
+        const float wr = realTwiddles[2 * k], wi = realTwiddles[2 * k + 1];
+        const float xr = er + wr * or_ - wi * oi;
+        const float xi = ei + wr * oi + wi * or_;
+
+        magnitudes[k] = windowGain * sqrt(xr * xr + xi * xi);
+    }
+
+    if (listener) listener(&magnitudes[0], n);
+}
+
+void StreamingFft::complexFft(float* data)
+{
+    const unsigned n = fftSize / 2;
+
+    for (unsigned i = 0; i < n; ++i)
+    {
+        const unsigned j = bitReversed[i];
+        if (j > i)
+        {
+            swap(data[2 * i], data[2 * j]);
+            swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+
+    // iterative radix 2 butterflies
+    for (unsigned size = 2; size <= n; size <<= 1)
+    {
+        const unsigned half = size / 2;
+        const unsigned twiddleStep = n / size;
+        for (unsigned start = 0; start < n; start += size)
+        {
+            for (unsigned i = 0; i < half; ++i)
+            {
+                const float wr = twiddles[2 * i * twiddleStep];
+                const float wi = twiddles[2 * i * twiddleStep + 1];
+                float* a = data + 2 * (start + i);
+                float* b = data + 2 * (start + i + half);
+                const float tr = wr * b[0] - wi * b[1];
+                const float ti = wr * b[1] + wi * b[0];
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+string StreamingFft::benchmark(unsigned fftSize, unsigned hopSize, unsigned sampleRate, unsigned blockSize)
+{
+    StreamingFft fft;
+    fft.setup(fftSize, hopSize);
+    const float binWidth = sampleRate / (float)fftSize;
+
+    // sweep a full scale sine from 100Hz to 10kHz over two seconds
+    const float startFrequency = 100.f;
+    const float endFrequency = 10000.f;
+    const unsigned numSamples = 2 * sampleRate;
+
+    unsigned numFrames = 0;
+    float maxBinError = 0.f;
+    float minPeak = numeric_limits<float>::max();
+    float maxPeak = 0.f;
+    fft.setListener([&](const float* magnitudes, unsigned numBins)
+    {
+        // frames finish every hop once the first fft's worth of samples
+        // are in so we can work out the frequency in the middle of the window
+        const float t = (fftSize / 2.f + numFrames * hopSize) / numSamples;
+        const float expected = startFrequency * pow(endFrequency / startFrequency, t);
+
+        const unsigned peak = max_element(magnitudes, magnitudes + numBins) - magnitudes;
+        maxBinError = max(maxBinError, fabs(peak - expected / binWidth));
+        minPeak = min(minPeak, magnitudes[peak]);
+        maxPeak = max(maxPeak, magnitudes[peak]);
+        ++numFrames;
+    });
+
+    vector<float> block(blockSize);
+    double phase = 0.;
+    unsigned long long processingMicros = 0;
+    unsigned numBlocks = 0;
+    for (unsigned i = 0; i + blockSize <= numSamples; i += blockSize)
+    {
+        for (unsigned j = 0; j < blockSize; ++j)
+        {
+            const double t = (i + j) / (double)numSamples;
+            phase += TWO_PI * startFrequency * pow(endFrequency / startFrequency, t) / sampleRate;
+            block[j] = sin(phase);
+        }
+
+        const unsigned long long start = ofGetElapsedTimeMicros();
+        fft.process(&block[0], blockSize, 1);
+        processingMicros += ofGetElapsedTimeMicros() - start;
+        ++numBlocks;
+    }
+
+    stringstream report;
+    report << "fft size " << fftSize << ", hop " << hopSize << " (" << 100.f * fft.getOverlap() << "% overlap, "
+           << 1000.f * hopSize / sampleRate << "ms): " << numFrames << " frames, peak bin within "
+           << maxBinError << " bins of the sweep, full scale peak " << minPeak << " to " << maxPeak << ", "
+           << processingMicros / (float)numBlocks << "us per " << blockSize << " sample block";
+    return report.str();
+}
+
+bool StreamingFft::test(unsigned fftSize, unsigned hopSize, unsigned numBands, string& report,
+                        unsigned sampleRate, unsigned blockSize)
+{
+    // a hann window spreads a tone in the middle of a bin into the bins
+    // either side at half its level, so a band next to a one bin band can
+    // get up to half of it, anything further away should be next to nothing
+    const float amplitude = .5f;
+    const float levelTolerance = .05f;
+    const float adjacentTolerance = .6f;
+    const float otherTolerance = .01f;
+
+    stringstream out;
+    out << "fft size " << fftSize << ", hop " << hopSize << ", " << numBands << " bands: ";
+    bool passed = true;
+
+    unsigned long long processingMicros = 0;
+    unsigned numBlocks = 0;
+    vector<float> block(blockSize);
+    for (unsigned band = 0; band < numBands; ++band)
+    {
+        StreamingFft fft;
+        fft.setup(fftSize, hopSize);
+        SpectrumAnalyser analyser;
+        analyser.setup(fftSize / 2, numBands);
+
+        // right in the middle of a bin so none of it leaks past the next ones
+        const unsigned bin = (analyser.getBandEdge(band) + analyser.getBandEdge(band + 1) - 1) / 2;
+        const double frequency = bin * sampleRate / (double)fftSize;
+
+        float level = 0.f;
+        fft.setListener([&](const float* magnitudes, unsigned numBins)
+        {
+            analyser.update(magnitudes);
+            level = magnitudes[bin];
+        });
+
+        // enough for the window to fill up and a few frames after that
+        for (unsigned i = 0; i < 4 * fftSize; i += blockSize)
+        {
+            for (unsigned j = 0; j < blockSize; ++j)
+            {
+                block[j] = amplitude * sin(TWO_PI * frequency * (i + j) / sampleRate);
+            }
+
+            const unsigned long long start = ofGetElapsedTimeMicros();
+            fft.process(&block[0], blockSize, 1);
+            processingMicros += ofGetElapsedTimeMicros() - start;
+            ++numBlocks;
+        }
+
+        const float* bands = analyser.getSmoothed();
+        float adjacent = 0.f;
+        float other = 0.f;
+        for (unsigned i = 0; i < numBands; ++i)
+        {
+            if (i == band) continue;
+            if (i + 1 == band || i == band + 1) adjacent = max(adjacent, bands[i]);
+            else other = max(other, bands[i]);
+        }
+
+        stringstream failure;
+        if (fabs(level - amplitude) > levelTolerance * amplitude)
+        {
+            failure << " level " << level << " rather than " << amplitude;
+        }
+        if (!(bands[band] > 0.f) || adjacent > adjacentTolerance * bands[band])
+        {
+            failure << " next band " << adjacent << " against " << bands[band];
+        }
+        if (other > otherTolerance * bands[band])
+        {
+            failure << " other bands up to " << other << " against " << bands[band];
+        }
+        if (!failure.str().empty())
+        {
+            out << "band " << band << " (" << frequency << "Hz) failed:" << failure.str() << ", ";
+            passed = false;
+        }
+    }
+
+    const float blockMicros = 1000000.f * blockSize / sampleRate;
+    const float averageMicros = processingMicros / (float)max(1u, numBlocks);
+    if (averageMicros > blockMicros)
+    {
+        out << "too slow, ";
+        passed = false;
+    }
+
+    out << (passed ? "passed, " : "failed, ") << averageMicros << "us per " << blockMicros << "us block";
+    report = out.str();
+    return passed;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ofMain.h"
+
+// runs a real input fft over a stream of pcm samples as they arrive
+//
+// every hopSize samples the last fftSize samples are windowed and
+// transformed, so with a hop smaller than the fft size the frames
+// overlap and we get a new spectrum much more often than once per
+// fft length, e.g. a 1024 point fft with a hop of 256 at 44.1kHz
+// gives a new spectrum every 5.8ms
+class StreamingFft
+{
+public:
+    enum Window
+    {
+        RECTANGULAR,
+        HANN,
+        HAMMING,
+        BLACKMAN_HARRIS
+    };
+
+    // called with fftSize / 2 magnitudes every time a frame is analysed,
+    // a full scale sine wave gives a magnitude of roughly 1
+    typedef function<void(const float* magnitudes, unsigned numBins)> Listener;
+
+    StreamingFft();
+
+    // fftSize must be a power of two
+    void setup(unsigned fftSize, unsigned hopSize, Window window = HANN);
+
+    void setListener(Listener listener) { this->listener = listener; }
+
+    // feed in interleaved samples, these are mixed down to mono before
+    // being analysed, this is safe to call from the audio thread
+    void process(const float* samples, unsigned numFrames, unsigned numChannels);
+
+    // the magnitudes from the most recent frame
+    const vector<float>& getMagnitudes() const { return magnitudes; }
+
+    unsigned getFftSize() const { return fftSize; }
+    unsigned getHopSize() const { return hopSize; }
+    unsigned getNumBins() const { return fftSize / 2; }
+
+    // 50% overlap is a hop of half the fft size and so on
+    float getOverlap() const { return 1.f - hopSize / (float)fftSize; }
+
+    // feeds a synthetic sine sweep through an fft with the given settings and
+    // reports how closely the loudest bin follows the sweep, how loud a full
+    // scale sine comes out and how long each block of audio takes to process
+    static string benchmark(unsigned fftSize, unsigned hopSize, unsigned sampleRate = 44100, unsigned blockSize = 256);
+
+    // plays a sine in the middle of each of the eq's bands through an fft
+    // with the given settings and a SpectrumAnalyser like the app's and
+    // checks the tone comes out at the right level, its band is loudest,
+    // the bands next to it only get what the window's main lobe spreads
+    // into them, the rest stay quiet and the audio is processed faster
+    // than it plays, returns false and says why in report if not
+    static bool test(unsigned fftSize, unsigned hopSize, unsigned numBands, string& report,
+                     unsigned sampleRate = 44100, unsigned blockSize = 256);
+
+private:
+    // transform the last fftSize samples and tell the listener
+    void analyse();
+
+    // in place complex fft of fftSize / 2 points held as interleaved real, imaginary
+    void complexFft(float* data);
+
+    unsigned fftSize;
+    unsigned hopSize;
+    float windowGain;
+
+    // the last fftSize samples, written round and round
+    vector<float> history;
+    unsigned writePosition;
+    unsigned numSamplesInHistory;
+    unsigned samplesSinceLastFrame;
+
+    // precalculated tables
+    vector<float> window;
+    vector<float> twiddles;
+    vector<float> realTwiddles;
+    vector<unsigned> bitReversed;
+
+    // working space so that we never allocate on the audio thread
+    vector<float> frame;
+    vector<float> magnitudes;
+
+    Listener listener;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+
+// a triple buffer lets one thread keep writing new values while another
+// thread reads the latest complete one, without either of them ever
+// having to wait for the other
+//
+// the writer fills in the back buffer and then publish() swaps it with the
+// middle buffer, the reader calls update() which swaps the middle buffer with
+// the front buffer if there's something new in it, these swaps are single
+// atomic exchanges so there are no locks
+//
+// this only works with one writing thread and one reading thread
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2)
+    {
+    }
+
+    // writer: the buffer to fill in before calling publish()
+    T& getWriteBuffer()
+    {
+        return buffers[back];
+    }
+
+    // writer: hand the buffer that has just been written to the reader
+    void publish()
+    {
+        back = middle.exchange(back | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // reader: grab the most recently published buffer if there is
+    // one, returns false if nothing has been published since last time
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_acquire) & NEW_DATA)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // reader: the buffer that was current at the last update()
+    const T& getReadBuffer() const
+    {
+        return buffers[front];
+    }
+
+    // set every buffer to the same value, only call this
+    // before either of the threads have started using it
+    void fill(const T& value)
+    {
+        for (unsigned i = 0; i < 3; ++i) buffers[i] = value;
+    }
+
+private:
+    // the middle index has a flag that says whether
+    // the writer has put something new in there
+    static const int INDEX_MASK = 3;
+    static const int NEW_DATA = 4;
+
+    T buffers[3];
+    int back;
+    std::atomic<int> middle;
+    int front;
+};
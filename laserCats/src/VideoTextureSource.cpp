@@ -0,0 +1,163 @@
+#include "VideoTextureSource.h"
+
+VideoTextureSource::VideoTextureSource() :
+    frameRate(30.f),
+    numFramesShown(0),
+    numFramesDropped(0),
+    lastFrameNumber(0),
+    lastUploadMillis(0.f)
+{
+}
+
+VideoTextureSource::~VideoTextureSource()
+{
+    close();
+}
+
+bool VideoTextureSource::load(const string& path, float frameRate)
+{
+    close();
+    paths.clear();
+    numFramesShown = 0;
+    numFramesDropped = 0;
+    lastFrameNumber = 0;
+
+    if (ofFile(path).isDirectory())
+    {
+        // the images are played in the order of their names
+        ofDirectory directory(path);
+        directory.allowExt("png");
+        directory.allowExt("jpg");
+        directory.allowExt("jpeg");
+        directory.allowExt("tga");
+        directory.allowExt("tif");
+        directory.allowExt("bmp");
+        directory.listDir();
+        directory.sort();
+        for (unsigned i = 0; i < directory.size(); ++i) paths.push_back(directory.getPath(i));
+
+        if (paths.empty() || frameRate <= 0.f)
+        {
+            ofLogError("VideoTextureSource") << "no images to play in " << path;
+            return false;
+        }
+        this->frameRate = frameRate;
+        ofLogNotice("VideoTextureSource") << "playing " << paths.size() << " images from " << path << " at " << frameRate << "fps";
+        startThread();
+        return true;
+    }
+
+    // we only want the pixels from the player, the uploads are ours
+    movie.setUseTexture(false);
+    if (!movie.load(path))
+    {
+        ofLogError("VideoTextureSource") << "couldn't load " << path;
+        return false;
+    }
+    movie.setLoopState(OF_LOOP_NORMAL);
+    movie.play();
+    ofLogNotice("VideoTextureSource") << "playing " << path << ", " << movie.getWidth() << "x" << movie.getHeight();
+    return true;
+}
+
+void VideoTextureSource::close()
+{
+    if (isThreadRunning()) waitForThread(true);
+    if (movie.isLoaded()) movie.close();
+}
+
+void VideoTextureSource::threadedFunction()
+{
+    // like the sound, when each frame is due is worked out
+    // from the start so that we don't drift
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    unsigned long number = 0;
+
+    while (isThreadRunning())
+    {
+        // decode the next frame straight away so it's ready when it's due,
+        // the texture is rgb or rgba so anything else is converted here
+        Frame& frame = frames.getWriteBuffer();
+        const bool loaded = ofLoadImage(frame.pixels, paths[number % paths.size()]);
+        if (!loaded) ofLogWarning("VideoTextureSource") << "couldn't load " << paths[number % paths.size()];
+        else if (frame.pixels.getNumChannels() < 3) frame.pixels.setImageType(OF_IMAGE_COLOR);
+        frame.number = number;
+
+        const unsigned long long due = start + (unsigned long long)(number * 1000000. / frameRate);
+        const unsigned long long now = ofGetElapsedTimeMicros();
+        if (due > now) this_thread::sleep_for(chrono::microseconds(due - now));
+        if (loaded) frames.publish();
+
+        // if that frame took longer than a frame to decode then
+        // we skip ahead to the one that's due now
+        const unsigned long long elapsed = ofGetElapsedTimeMicros() - start;
+        number = max<unsigned long>(number + 1, elapsed * frameRate / 1000000.);
+    }
+}
+
+bool VideoTextureSource::update()
+{
+    if (movie.isLoaded())
+    {
+        // this only copies the frame the backend has decoded, if there's a new one
+        movie.update();
+        if (!movie.isFrameNew()) return false;
+        upload(movie.getPixels());
+        shown(max(0, movie.getCurrentFrame()));
+        return true;
+    }
+
+    if (!frames.update()) return false;
+    const Frame& frame = frames.getReadBuffer();
+    upload(frame.pixels);
+    shown(frame.number);
+    return true;
+}
+
+void VideoTextureSource::upload(const ofPixels& pixels)
+{
+    const unsigned long long start = ofGetElapsedTimeMicros();
+
+    if (!texture.isAllocated() || texture.getWidth() != pixels.getWidth() || texture.getHeight() != pixels.getHeight() ||
+        texture.getTextureData().glInternalFormat != ofGetGLInternalFormat(pixels))
+    {
+        texture.allocate(pixels.getWidth(), pixels.getHeight(), ofGetGLInternalFormat(pixels), false);
+    }
+
+    // giving the buffer new storage before we write to it means the driver
+    // never has to wait for the gpu to finish with what was in it before
+    if (!pixelBuffer.isAllocated()) pixelBuffer.allocate();
+    pixelBuffer.setData(pixels.getTotalBytes(), NULL, GL_STREAM_DRAW);
+    unsigned char* data = (unsigned char*)pixelBuffer.map(GL_WRITE_ONLY);
+    if (data)
+    {
+        // the first row of the image is the top but the first row of the
+        // texture is the bottom, eqFbo is drawn into upside down for the
+        // same reason, so we turn it over as we copy it
+        const size_t rowBytes = pixels.getWidth() * pixels.getBytesPerPixel();
+        const unsigned char* row = pixels.getData() + (pixels.getHeight() - 1) * rowBytes;
+        for (size_t y = 0; y < pixels.getHeight(); ++y, row -= rowBytes) memcpy(data + y * rowBytes, row, rowBytes);
+        pixelBuffer.unmap();
+
+        // this returns as soon as the copy from the buffer has been queued
+        texture.loadData(pixelBuffer, ofGetGLFormat(pixels), GL_UNSIGNED_BYTE);
+    }
+
+    lastUploadMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+}
+
+void VideoTextureSource::shown(unsigned long number)
+{
+    // the movie going back to the start isn't a drop
+    if (numFramesShown && number > lastFrameNumber + 1) numFramesDropped += number - lastFrameNumber - 1;
+    lastFrameNumber = number;
+    ++numFramesShown;
+}
+
+string VideoTextureSource::getStatus() const
+{
+    stringstream status;
+    status << "video: " << numFramesShown << " frames, " << numFramesDropped << " dropped, upload "
+           << fixed << setprecision(2) << lastUploadMillis << "ms";
+    return status.str();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TripleBuffer.h"
+
+// plays pre-rendered video into a texture that can be drawn on the box in
+// place of the eq
+//
+// the video is either a directory of numbered images, which is how our
+// content is usually exported and is decoded on this object's own thread at
+// the frame rate we give it, or a movie file, which ofVideoPlayer decodes on
+// its backend's own threads with its texture turned off so it never uploads
+//
+// either way the newest decoded frame is copied into a pixel buffer object
+// and the texture is loaded from there, which means the copy to the texture
+// is done by the driver in the background rather than glTexSubImage waiting
+// for it, the buffer's storage is orphaned before each copy so we never
+// write into memory that the gpu may still be reading from, the driver
+// gives us new memory instead, which is what a ring of buffers would do
+//
+// the texture is GL_TEXTURE_2D so it can be used with the normalised texture
+// coordinates that ofMesh::box() makes, the same as eqFbo, and the rows are
+// put in upside down on the way like eqFbo's are so the video is the same
+// way up on the box as the eq
+class VideoTextureSource : public ofThread
+{
+public:
+    VideoTextureSource();
+    ~VideoTextureSource();
+
+    // load a directory of images to be played at frameRate or a movie file,
+    // which plays at its own rate, either way it starts playing straight away
+    bool load(const string& path, float frameRate = 30.f);
+
+    // stop decoding and wait for the thread to finish
+    void close();
+
+    // call this on the render thread once a frame, it uploads the newest
+    // frame if there is one and returns true if it did
+    bool update();
+
+    // true once the first frame has been uploaded
+    bool isReady() const { return numFramesShown > 0; }
+
+    ofTexture& getTexture() { return texture; }
+
+    // frames that were decoded late and skipped, or decoded but replaced
+    // by a newer one before they could be uploaded
+    unsigned long getNumFramesShown() const { return numFramesShown; }
+    unsigned long getNumFramesDropped() const { return numFramesDropped; }
+
+    // how long the render thread spent handing the last frame to the gpu
+    float getLastUploadMillis() const { return lastUploadMillis; }
+
+    // the frames shown, dropped and the upload time on one line
+    string getStatus() const;
+
+private:
+    struct Frame
+    {
+        ofPixels pixels;
+
+        // counts up forever rather than going back to the start of the
+        // sequence when it loops so we can tell when frames are skipped
+        unsigned long number;
+    };
+
+    // decode the images one after another, each one is handed over at the
+    // time it's due and if we fall behind we skip ahead to catch up
+    void threadedFunction();
+
+    // copy pixels through the pixel buffer object into the texture
+    void upload(const ofPixels& pixels);
+
+    // count the frames between the last one shown and this one as dropped
+    void shown(unsigned long number);
+
+    // the image sequence, decoded on our thread
+    vector<string> paths;
+    float frameRate;
+    TripleBuffer<Frame> frames;
+
+    // or the movie, decoded by ofVideoPlayer's backend
+    ofVideoPlayer movie;
+
+    ofBufferObject pixelBuffer;
+    ofTexture texture;
+
+    unsigned long numFramesShown;
+    unsigned long numFramesDropped;
+    unsigned long lastFrameNumber;
+    float lastUploadMillis;
+};
@@ -0,0 +1,141 @@
+#include "WarpRemap.h"
+
+namespace
+{
+    // stores where in the content each pixel of the mesh is and how deep it is
+    const string BAKE_SOURCE = R"(
+        void main()
+        {
+            gl_FragColor = vec4(gl_TexCoord[0].st, gl_FragCoord.z, 1.0);
+        }
+    )";
+
+    // looks up the content for each pixel covered by the mesh, the remap is
+    // read at the pixel we're drawing rather than with texture coordinates
+    // so it lines up however the matrices are set
+    const string DRAW_SOURCE = R"(
+        uniform sampler2D remap;
+        uniform sampler2D content;
+        uniform vec2 remapSize;
+
+        void main()
+        {
+            vec4 texel = texture2D(remap, gl_FragCoord.xy / remapSize);
+            if (texel.a < 0.5) discard;
+            gl_FragColor = gl_Color * texture2D(content, texel.st);
+            gl_FragDepth = texel.b;
+        }
+    )";
+}
+
+WarpRemap::WarpRemap() :
+    baked(false),
+    meshDirty(false),
+    lastBakeMillis(0.f),
+    numBakes(0)
+{
+}
+
+void WarpRemap::setup()
+{
+    bakeShader.setupShaderFromSource(GL_FRAGMENT_SHADER, BAKE_SOURCE);
+    bakeShader.linkProgram();
+    drawShader.setupShaderFromSource(GL_FRAGMENT_SHADER, DRAW_SOURCE);
+    drawShader.linkProgram();
+
+    quad.setMode(OF_PRIMITIVE_TRIANGLE_FAN);
+    quad.addVertex(ofVec3f(-1.f, -1.f, 0.f));
+    quad.addVertex(ofVec3f(1.f, -1.f, 0.f));
+    quad.addVertex(ofVec3f(1.f, 1.f, 0.f));
+    quad.addVertex(ofVec3f(-1.f, 1.f, 0.f));
+}
+
+void WarpRemap::bake(ofMesh& mesh, const ofCamera& camera, const ofMatrix4x4& transform, unsigned width, unsigned height)
+{
+    const unsigned long long start = ofGetElapsedTimeMicros();
+
+    if (!remap.isAllocated() || remap.getWidth() != width || remap.getHeight() != height)
+    {
+        // texture coordinates need more precision than 8 bits
+        // and mustn't be blended between neighbouring pixels
+        ofFbo::Settings settings;
+        settings.width = width;
+        settings.height = height;
+        settings.textureTarget = GL_TEXTURE_2D;
+        settings.internalformat = GL_RGBA32F;
+        settings.useDepth = true;
+        settings.minFilter = GL_NEAREST;
+        settings.maxFilter = GL_NEAREST;
+        settings.wrapModeHorizontal = GL_CLAMP_TO_EDGE;
+        settings.wrapModeVertical = GL_CLAMP_TO_EDGE;
+        remap.allocate(settings);
+    }
+
+    // set up the camera the same way as ofxPostProcessing::begin() does
+    // so that the remap lines up exactly with what it is drawn into
+    remap.begin(false);
+    ofPushView();
+    ofViewport(0, 0, width, height);
+    ofMatrixMode(OF_MATRIX_PROJECTION);
+    ofLoadMatrix(camera.getProjectionMatrix(ofRectangle(0, 0, width, height)));
+    ofMatrixMode(OF_MATRIX_MODELVIEW);
+    ofLoadMatrix(transform * camera.getModelViewMatrix());
+
+    ofPushStyle();
+    ofClear(0, 0);
+    ofDisableBlendMode();
+    ofEnableDepthTest();
+    bakeShader.begin();
+    mesh.draw();
+    bakeShader.end();
+    ofDisableDepthTest();
+    ofPopStyle();
+
+    ofPopView();
+    remap.end();
+
+    bakedModelViewProjection = transform * camera.getModelViewProjectionMatrix(ofRectangle(0, 0, width, height));
+    baked = true;
+    meshDirty = false;
+    ++numBakes;
+    lastBakeMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+}
+
+bool WarpRemap::update(ofMesh& mesh, const ofCamera& camera, const ofMatrix4x4& transform, unsigned width, unsigned height)
+{
+    // comparing the matrices catches every change to the camera or transform,
+    // including the ones made by calibrating, without having to be told
+    const ofMatrix4x4 modelViewProjection = transform * camera.getModelViewProjectionMatrix(ofRectangle(0, 0, width, height));
+    if (baked && !meshDirty && remap.getWidth() == width && remap.getHeight() == height &&
+        !memcmp(modelViewProjection.getPtr(), bakedModelViewProjection.getPtr(), 16 * sizeof(float)))
+    {
+        return false;
+    }
+
+    bake(mesh, camera, transform, width, height);
+    return true;
+}
+
+void WarpRemap::draw(ofTexture& content)
+{
+    if (!baked) return;
+
+    drawShader.begin();
+    drawShader.setUniformTexture("remap", remap.getTexture(), 1);
+    drawShader.setUniformTexture("content", content, 2);
+    drawShader.setUniform2f("remapSize", remap.getWidth(), remap.getHeight());
+
+    ofMatrixMode(OF_MATRIX_PROJECTION);
+    ofPushMatrix();
+    ofLoadIdentityMatrix();
+    ofMatrixMode(OF_MATRIX_MODELVIEW);
+    ofPushMatrix();
+    ofLoadIdentityMatrix();
+    quad.draw();
+    ofPopMatrix();
+    ofMatrixMode(OF_MATRIX_PROJECTION);
+    ofPopMatrix();
+    ofMatrixMode(OF_MATRIX_MODELVIEW);
+
+    drawShader.end();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ofMain.h"
+
+// draws a textured mesh as seen by a camera with a single full screen pass
+//
+// every frame the box gets drawn through the projector, which means all of
+// its triangles get transformed and rasterised even though the warp and the
+// projector hardly ever change, so instead we draw the mesh once into a
+// floating point texture where each pixel holds the texture coordinate and
+// depth of the mesh at that pixel, drawing the mesh is then just a case of
+// looking up where each pixel is in the content, which costs the same
+// however many vertices the mesh has
+//
+// the bake has to be done again whenever the mesh, its transform or the
+// camera change, update() looks after that
+class WarpRemap
+{
+public:
+    WarpRemap();
+
+    // compile the shaders, this needs to be done after the window has been created
+    void setup();
+
+    // draw mesh into the remap from camera's point of view with transform
+    // applied, in the same way as ofxPostProcessing does, width and height
+    // should be the size of what the remap will be drawn into
+    void bake(ofMesh& mesh, const ofCamera& camera, const ofMatrix4x4& transform, unsigned width, unsigned height);
+
+    // bake only if the camera, transform or size are different from last
+    // time or meshChanged() has been called, returns true if it baked
+    bool update(ofMesh& mesh, const ofCamera& camera, const ofMatrix4x4& transform, unsigned width, unsigned height);
+
+    // call this when the mesh's vertices move
+    void meshChanged() { meshDirty = true; }
+
+    // draw content where the mesh was when it was baked, tinted by the current
+    // colour, this writes the mesh's depth so it still hides things behind it,
+    // it's drawn to the whole of the current viewport whatever the matrices are
+    void draw(ofTexture& content);
+
+    bool isBaked() const { return baked; }
+    float getLastBakeMillis() const { return lastBakeMillis; }
+    unsigned getNumBakes() const { return numBakes; }
+
+private:
+    ofFbo remap;
+    ofShader bakeShader;
+    ofShader drawShader;
+
+    // covers the whole viewport when drawn with no transform
+    ofMesh quad;
+
+    // what the last bake was done with, the transform and camera multiplied together
+    ofMatrix4x4 bakedModelViewProjection;
+    bool baked;
+    bool meshDirty;
+    float lastBakeMillis;
+    unsigned numBakes;
+};
@@ -1,13 +1,58 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "HeadlessBenchmark.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	// --outputs n drives n projectors side by side across the window,
+	// --latency path times how long sounds take to reach the eq and writes
+	// the results to path and --null-audio plays without a sound card, e.g.
+	// xvfb-run ./laserCats --benchmark --frames 6000 --latency latency.json --null-audio
+	// --video path plays a movie or a directory of images on the box instead
+	// of the eq, images play at 30fps unless --video-fps says otherwise
+	// --laser path writes the visible outline to an ILDA file, or with
+	// udp:port or udp:host:port sends it there, at --laser-pps points a second
+	// --dump prefix saves the last frame of a benchmark and each output in
+	// it, e.g. --outputs 3 --dump out/ saves out/frame.png and out/output1.png
+	// to out/output3.png, benchmark-outputs.sh times 1 to 4 outputs
+	// --fft-test checks the eq's bands with sine tones without opening a
+	// window and exits with 1 if any of them are wrong
+	for (int i = 1; i < argc; ++i)
+	{
+		if (string(argv[i]) == "--fft-test") return ofApp::testFft() ? 0 : 1;
+	}
+
+	float videoFrameRate = 30.f;
+	string videoPath;
+	unsigned laserPointsPerSecond = 30000;
+	string laserDestination;
+	ofApp* app = new ofApp();
+	for (int i = 1; i < argc; ++i)
+	{
+		const string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--outputs" && hasValue) app->setNumOutputs(ofToInt(argv[++i]));
+		else if (argument == "--latency" && hasValue) app->setLatencyProbe(argv[++i]);
+		else if (argument == "--null-audio") app->setNullAudio(true);
+		else if (argument == "--video" && hasValue) videoPath = argv[++i];
+		else if (argument == "--video-fps" && hasValue) videoFrameRate = ofToFloat(argv[++i]);
+		else if (argument == "--laser" && hasValue) laserDestination = argv[++i];
+		else if (argument == "--laser-pps" && hasValue) laserPointsPerSecond = ofToInt(argv[++i]);
+		else if (argument == "--dump" && hasValue) app->setDump(argv[++i]);
+	}
+	if (!videoPath.empty()) app->setVideo(videoPath, videoFrameRate);
+	if (!laserDestination.empty()) app->setLaser(laserDestination, laserPointsPerSecond);
+
+	// run with --benchmark to render a fixed number of frames in a hidden
+	// window and write out how long they took rather than running normally
+	HeadlessBenchmark::Settings benchmark;
+	if (benchmark.parse(argc, argv)) return HeadlessBenchmark::run(app, benchmark);
+
 	ofSetupOpenGL(1024, 768, OF_FULLSCREEN);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofRunApp(app);
 
 }
@@ -27,26 +27,86 @@ const unsigned ofApp::OUTLINE_INDICES[] = {
     0,4, 1,5, 2,6, 3,7
 };
 
+//--------------------------------------------------------------
+ofApp::ofApp() :
+    requestedNumOutputs(0),
+    nullAudio(false),
+    videoFrameRate(30.f),
+    laserPointsPerSecond(30000),
+    loading(true),
+    startupMicros(0),
+    setupMicros(0)
+{
+}
+
+//--------------------------------------------------------------
+bool ofApp::testFft()
+{
+    bool passed = true;
+    const unsigned settings[][3] = {
+        { FFT_SIZE, FFT_HOP_SIZE, NUM_FFT_BANDS },
+        { FFT_SIZE, FFT_SIZE / 2, NUM_FFT_BANDS },
+        { 2 * FFT_SIZE, FFT_HOP_SIZE / 2, 4 * NUM_FFT_BANDS }
+    };
+    for (auto& setting : settings)
+    {
+        string report;
+        if (StreamingFft::test(setting[0], setting[1], setting[2], report)) ofLogNotice("ofApp") << report;
+        else
+        {
+            ofLogError("ofApp") << report;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
 //--------------------------------------------------------------
 void ofApp::setup()
 {
-    // set some openFrameworks settings
-    ofSetFrameRate(60);
+    // set some openFrameworks settings, the frames are
+    // paced to the display's refresh rather than 60fps
+    framePacer.setup();
     ofBackground(0);
     
-    // check whether we've previously saved meshes
-    if (ofFile("outline.ply").exists() && ofFile("box.ply").exists())
+    // the benchmark tells us once it's timed the last frame
+    if (!dumpPrefix.empty()) HeadlessBenchmark::setLastFrameListener([this]() { dumpOutputs(); });
+    
+    // read and decode the files on other threads while we set up everything
+    // else here, anything that needs the gl context or the sound system is
+    // finished off on this thread once its file has been loaded
+    startupMicros = ofGetElapsedTimeMicros();
+    loading = true;
+    
+    // the meshes mustn't be warped with the mouse while they're being loaded into
+    updateMeshEvents();
+    
+    // we save the meshes as binary as well as ply because the binary
+    // versions are much quicker to load, if neither is there then we
+    // use model.ply if there is one or the default box is made once
+    // we're back on this thread
+    assetLoader.add("box mesh", [this]()
     {
-        // we have saved meshes so load them up
-        outlineMesh.load("outline.ply");
-        outlineMesh.setMode(OF_PRIMITIVE_LINES);
-        boxMesh.load("box.ply");
-    }
-    else
+        return loadMesh(boxMesh, "box") || loadModel(boxMesh, false);
+    },
+    [this](bool loaded)
+    {
+        // we make the dimensions very slightly smaller than the dimensions
+        // of the outline of the box so that the computer knows that the
+        // outline is to be rendered outside of the box and we can use
+        // it to hide the outline at the back of the box
+        if (!loaded) boxMesh = ofMesh::box(.999f * BOX_DIMS.x, .999f * BOX_DIMS.y, .999f * BOX_DIMS.z, 1, 1, 1);
+    });
+    assetLoader.add("outline mesh", [this]()
+    {
+        return loadMesh(outlineMesh, "outline") || loadModel(outlineMesh, true);
+    },
+    [this](bool loaded)
     {
-        // create an outline of a box using a mesh in OF_PRIMITIVE_LINES mode
+        // the outline of the box is a mesh in OF_PRIMITIVE_LINES mode
         // so that every two vertices represents a line
         outlineMesh.setMode(OF_PRIMITIVE_LINES);
+        if (loaded) return;
         
         // add in all the vertices to the mesh
         for (unsigned i = 0; i < NUM_BOX_VERTICES; ++i)
@@ -61,80 +121,156 @@ void ofApp::setup()
         {
             outlineMesh.addIndex(OUTLINE_INDICES[i]);
         }
+    });
+    
+    // the settings from the previous time we ran the application are parsed
+    // on a thread and put into the gui here, which is set up by then
+    assetLoader.add("settings.xml", [this]()
+    {
+        return ofFile("settings.xml").exists() && settingsXml.load("settings.xml");
+    },
+    [this](bool loaded)
+    {
+        if (loaded) settingsXml.deserialize(gui.getParameter());
+        settingsXml.clear();
         
-        // create the box mesh
-        // we make the dimensions very slightly smaller than the dimensions
-        // of the outline of the box so that the computer knows that the
-        // outline is to be rendered outside of the box and we can use
-        // it to hide the outline at the back of the box
-        boxMesh = ofMesh::box(.999f * BOX_DIMS.x, .999f * BOX_DIMS.y, .999f * BOX_DIMS.z, 1, 1, 1);
+        // the number of outputs on the command line wins over the saved one
+        if (requestedNumOutputs) numOutputs = (int)ofClamp(requestedNumOutputs, 1, MAX_OUTPUTS);
+        
+        // make sure the bloom matches the settings even if they didn't change it
+        int mode = bloomMode;
+        bloomModeChanged(mode);
+    });
+    
+    // the cat image for the eq is decoded on a thread and uploaded to a texture here
+    assetLoader.add("cat.png", [this]()
+    {
+        return ofLoadImage(catPixels, "cat.png");
+    },
+    [this](bool loaded)
+    {
+        if (loaded) catImage.setFromPixels(catPixels);
+        catPixels.clear();
+        
+        // all of the cats in the eq are drawn in one go using this batch
+        catBatch.setTexture(catImage.getTexture());
+    });
+    
+    // the wav is read and converted on a thread, when we're measuring latency
+    // we play bursts that we've made instead of the music, they go through the
+    // same player and analysis as the wav would
+    assetLoader.add("audio", [this]()
+    {
+        if (!latencyProbePath.empty())
+        {
+            latencyProbe.setup(LATENCY_PROBE_SAMPLE_RATE, 2);
+            pcmPlayer.setSamples(latencyProbe.getSamples(), latencyProbe.getNumChannels(), latencyProbe.getSampleRate());
+            return true;
+        }
+        return ofFile("Quirky Dog.wav").exists() && pcmPlayer.load("Quirky Dog.wav");
+    },
+    [this](bool loaded)
+    {
+        startAudio();
+    });
+    assetLoader.start();
+    
+    // every projector has its own camera and settings, the corners
+    // of the box are what we line up when calibrating each of them
+    for (unsigned i = 0; i < MAX_OUTPUTS; ++i)
+    {
+        outputs[i].setup("output" + ofToString(i + 1));
+        outputs[i].calibration.setup(BOX_VERTICES, NUM_BOX_VERTICES);
     }
     
-    // set the camera in the meshes, this is needed so that we know
-    // how to translate from screen coordinates to world coordinated to be able
-    // to pick points to warp
-    outlineMesh.setCamera(projector);
-    boxMesh.setCamera(projector);
-    
-    // enable keyboard and mouse events for the meshes
-    // so that they can be warped
-    outlineMesh.setEventsEnabled(true);
-    boxMesh.setEventsEnabled(true);
-    
-    // enable keyboard and mouse events for the meshes
-    // so that they can be warped
-    outlineMesh.setEventsEnabled(true);
-    boxMesh.setEventsEnabled(true);
-    
-    // put our projector 200cm away from our object that will be at the origin
-    projector.setPosition(0, 0, -200.f);
-    
-    // set our camera's vertical field of view
-    // this can be calculated using this spreadsheet
-    // https://docs.google.com/spreadsheets/d/136NbNeFGER7yiOVgik7hueTRkYGkNHcqBlRFdfcix7I/edit#gid=0
-    projector.setFov(16.84f);
-    
-    // look at the origin where our box is
-    projector.lookAt(ofVec3f(0.f, 0.f, 0.f));
-    
-    // add functions to be called when the projector position and tilt are changed
-    // and the boxAngle in relation to the camera
-    projectorPosition.addListener(this, &ofApp::projectorPositionChanged);
-    projectorTilt.addListener(this, &ofApp::projectorTiltChanged);
+    // nothing can be picked until the meshes have loaded
+    hoveredPicker = NULL;
+    hoveredVertex = -1;
+    clearSelection();
+    
+    // don't draw the gui to begin with
+    // in ofApp::keyPressed() we'll add some code to toggle this
+    drawGui = false;
+    
+    calibrating = false;
+    calibrationOutput = 0;
+    selectedCalibrationPoint = -1;
+    
+    // add functions to be called when the boxAngle in relation
+    // to the camera and the number of projectors are changed
     boxAngle.addListener(this, &ofApp::boxAngleChanged);
+    numOutputs.addListener(this, &ofApp::numOutputsChanged);
+    bloomMode.addListener(this, &ofApp::bloomModeChanged);
     
     // set up user interface so we can tweak the projection
     gui.setup();
     gui.add(boxAngle.set("boxAngle", 0.f, -90.f, 90.f));
-    gui.add(projectorTilt.set("projectorTilt", 0.f, -30.f, -10.f));
-    gui.add(projectorPosition.set("projectorPosition",
-                                  ofVec3f(0.f, 0.f, -200.f),
-                                  ofVec3f(-10.f, 20.f, -150.f),
-                                  ofVec3f(10.f, 50.f, -100.f)));
     
-    // load the settings from the previous time we ran the application
-    gui.loadFromFile("settings.xml");
+    // the first projector's settings go straight into the gui as they
+    // did when there was only one so the saved settings still load
+    gui.add(outputs[0].tilt);
+    gui.add(outputs[0].position);
+    gui.add(outputs[0].pan);
+    gui.add(outputs[0].roll);
+    gui.add(outputs[0].fov);
+    gui.add(outputs[0].lensOffset);
     
-    // don't draw the gui to begin with
-    // in ofApp::keyPressed() we'll add some code to toggle this
-    drawGui = false;
+    // the others are folded away until they're needed
+    gui.add(numOutputs.set("numOutputs", 1, 1, MAX_OUTPUTS));
+    for (unsigned i = 1; i < MAX_OUTPUTS; ++i)
+    {
+        gui.add(outputs[i].parameters);
+        gui.getGroup(outputs[i].parameters.getName()).minimize();
+    }
+    
+    // only redraw the columns of the eq that have changed
+    gui.add(incrementalEq.set("incrementalEq", true));
+    
+    // 0 is the original full resolution bloom, 1 to 3 are the low,
+    // medium and high quality versions of the mip bloom
+    gui.add(bloomMode.set("bloomMode", 0, 0, 3));
+    
+    // draw the box by looking up the eq through a baked remap
+    // rather than drawing the box's triangles every frame
+    gui.add(remapBox.set("remapBox", false));
+    
+    // when there's a video it goes on the box in place of the eq
+    gui.add(showVideo.set("showVideo", true));
     
-    // initialise the outline effects
-    outlineEffects.init();
+    // when there's more than one output each of them fades out towards the
+    // edges of its image where another projector covers the same part of
+    // the box, the gamma should match the projectors' so the light adds up
+    gui.add(blendEdges.set("blendEdges", true));
+    gui.add(blendFeather.set("blendFeather", .15f, .01f, .5f));
+    gui.add(blendGamma.set("blendGamma", 2.2f, 1.f, 3.f));
+    
+    gui.add(framePacer.parameters);
+    
+    // initialise the outline effects, they're shared by the outputs
+    // and run once for each of them at the size of one output
+    resizeOutputs();
     
     // add a bloom (glow) pass and an FXAA (anti-aliasing) pass
-    // to the post processing chain
-    outlineEffects.createPass<BloomPass>();
+    // to the post processing chain, we add both kinds of bloom
+    // and bloomMode decides which one of them is used
+    bloomPass = outlineEffects.createPass<BloomPass>();
+    mipBloomPass = outlineEffects.createPass<MipBloomPass>();
     outlineEffects.createPass<FxaaPass>();
     
-    // load the audio
-    soundPlayer.load("Quirky Dog.mp3");
-    soundPlayer.setLoop(OF_LOOP_NORMAL);
-    soundPlayer.play();
-
-    // load cat image for eq
-    catImage.load("cat.png");
-
+    // time the eq, the scene, the post processing as a whole and each
+    // pass inside it, and the gui so that we can see what is expensive
+    eqStage = profiler.addStage("eqFbo");
+    videoStage = profiler.addStage("videoUpload");
+    remapStage = profiler.addStage("remapBake");
+    edgeBlendStage = profiler.addStage("edgeBlend");
+    laserStage = profiler.addStage("laser");
+    sceneStage = profiler.addStage("scene");
+    postProcessingStage = profiler.addStage("postProcessing");
+    profiler.timePasses(outlineEffects, "  ");
+    otherOutputsStage = profiler.addStage("otherOutputs");
+    guiStage = profiler.addStage("gui");
+    drawProfiler = false;
+    
     // set up an fbo to draw the eq int
     // using GL_TEXTURE_2D enables us to use the normalised texture
     // coordinates generated by ofMesh::box()o
@@ -143,81 +279,408 @@ void ofApp::setup()
     s.height = 1024;
     s.textureTarget = GL_TEXTURE_2D;
     eqFbo.allocate(s);
+    
+    // the remaps are only baked when remapBox is turned on
+    for (ProjectorOutput& output : outputs) output.remap.setup();
+    
+    // the blend masks are only made when there's more than one output
+    edgeBlend.setup();
+
+    // cycle through the rainbow for the bars, the colours never
+    // change so we work them out once here rather than every frame
+    for (unsigned i = 0; i < NUM_FFT_BANDS; ++i)
+    {
+        eqColumnColours[i] = ofFloatColor::fromHsb(i / (float)(NUM_FFT_BANDS - 1), 1.f, 1.f);
+    }
+    
+    // nothing has been drawn into the eq frame buffer yet
+    memset(eqCatsInColumn, 0, sizeof(unsigned) * NUM_FFT_BANDS);
+    eqFboDrawn = false;
+    numEqFramesFull = 0;
+    numEqFramesPartial = 0;
+    numEqFramesSkipped = 0;
+    
+    // the analyser groups the raw fft bins into logarithmically
+    // spaced bands, one for each column of the eq
+    analysisThread.setup(NUM_RAW_FFT_BINS, NUM_FFT_BANDS);
+    
+    // the video starts decoding now and is shown once its first frame is uploaded
+    if (!videoPath.empty()) videoSource.load(videoPath, videoFrameRate);
+    
+    // the laser's thread starts sending as soon as the first frame is made
+    if (!laserDestination.empty())
+    {
+        LaserOutput::Settings laserSettings;
+        laserSettings.pointsPerSecond = laserPointsPerSecond;
+        laserOutput.setup(laserDestination, laserSettings);
+    }
+    
+    // everything else is ready so we show a loading bar until the files are,
+    // when benchmarking every frame has to be a real one so we wait for them here
+    setupMicros = ofGetElapsedTimeMicros() - startupMicros;
+    if (HeadlessBenchmark::isRunning())
+    {
+        assetLoader.finish();
+        assetsLoaded();
+    }
+}
 
-    // initialise the smoothed fft and max fft values to zero
-    memset(smoothedFft, 0, sizeof(float) * NUM_FFT_BANDS);
-    memset(maxFft, 0, sizeof(float) * NUM_FFT_BANDS);
-    memset(normalisedFft, 0, sizeof(float) * NUM_FFT_BANDS);
+bool ofApp::loadMesh(ofxWarpableMesh& mesh, const string& name)
+{
+    // this is on one of the loader's threads, nothing else
+    // touches the mesh until everything has loaded
+    // the binary mesh is only used if the ply hasn't been changed since and
+    // it leaves the mesh alone if it doesn't load, ofMesh::load adds to
+    // what's there so the mesh is cleared before falling back to the ply
+    if (BinaryMesh::isUpToDate(name + ".mesh", name + ".ply") && BinaryMesh::load(name + ".mesh", mesh)) return true;
+    if (!ofFile(name + ".ply").exists()) return false;
+    mesh.clear();
+    mesh.load(name + ".ply");
+    return mesh.getNumVertices() > 0;
 }
 
-//--------------------------------------------------------------
-void ofApp::update()
+bool ofApp::loadModel(ofxWarpableMesh& mesh, bool outline)
 {
-    // get the fft
-    float* spectrum = ofSoundGetSpectrum(NUM_FFT_BANDS);
-    for (int i = 0; i < NUM_FFT_BANDS; ++i)
+    // whichever of the box and the outline gets here first parses the model
+    // for both of them while the other waits, after that it's only read
+    call_once(modelLoaded, [this]()
     {
-        // let the smoothed value sink to zero:
-        smoothedFft[i] *= 0.96f;
-        
-        // then let the smoothed fft value be the maximum
-        // of the previous falling value or the new value
-        // so each will rise immediately and then fall smoothly
-        smoothedFft[i] = max(spectrum[i], smoothedFft[i]);
-        
-        // in maxFft we hold the maximum value for this
-        // frequency band so far
-        maxFft[i] = max(spectrum[i], maxFft[i]);
+        if (ofFile("model.ply").exists()) model.load("model.ply");
+    });
+    if (!model.getNumVertices()) return false;
+    
+    // the outline is worked out from where the model's surface folds, like
+    // the box the model itself is drawn very slightly smaller than its
+    // outline so that the outline isn't hidden by it
+    if (outline)
+    {
+        FeatureEdgeExtractor::Stats stats;
+        mesh = FeatureEdgeExtractor::extract(model, 30.f, .001f, 0, &stats);
+        ofLogNotice("ofApp") << "extracted " << mesh.getNumIndices() / 2 << " outline edges from "
+                             << stats.numTriangles << " triangles in " << stats.totalMillis << "ms";
+    }
+    else
+    {
+        mesh = model;
+        FeatureEdgeExtractor::scaleAboutCentre(mesh, .999f);
+    }
+    return true;
+}
+
+void ofApp::startAudio()
+{
+    if (pcmPlayer.isLoaded())
+    {
+        // if we've got an uncompressed version of the audio then we play it
+        // ourselves and run our own fft over exactly what is being played,
+        // every FFT_HOP_SIZE samples we analyse the last FFT_SIZE samples
+        streamingFft.setup(FFT_SIZE, FFT_HOP_SIZE, StreamingFft::HANN);
+        // the hops come in bursts, a whole audio buffer at a time, so the
+        // bands fall by the audio between them rather than by the clock
+        const float hopSeconds = FFT_HOP_SIZE / (float)pcmPlayer.getSampleRate();
+        streamingFft.setListener([this, hopSeconds](const float* magnitudes, unsigned numBins)
+        {
+            analysisThread.analyse(magnitudes, hopSeconds);
+        });
+        pcmPlayer.setListener([this](const float* samples, unsigned numFrames, unsigned numChannels)
+        {
+            // the probe has to see the start of a burst before the analysis does
+            if (!latencyProbePath.empty()) latencyProbe.audioPlayed(samples, numFrames, numChannels);
+            streamingFft.process(samples, numFrames, numChannels);
+        });
+        pcmPlayer.setLoop(true);
+        pcmPlayer.play();
         
-        // using maxFft, we then get a normalised value
-        //(a value between 0 and 1) and use this to draw the eq
-        if (maxFft[i] != 0.f) normalisedFft[i] = ofMap(smoothedFft[i], 0.f, maxFft[i], 0.f, 1.f);
+        if (nullAudio)
+        {
+            nullSoundStream.setOutput(pcmPlayer);
+            nullSoundStream.setup(2, 0, pcmPlayer.getSampleRate(), AUDIO_BUFFER_SIZE, 4);
+        }
+        else
+        {
+            soundStream.setOutput(pcmPlayer);
+            soundStream.setup(2, 0, pcmPlayer.getSampleRate(), AUDIO_BUFFER_SIZE, 4);
+        }
+    }
+    else
+    {
+        // otherwise use ofSoundPlayer and analyse its spectrum on its own thread,
+        // this always needs a sound card, fmod has to load it on this thread
+        soundPlayer.load("Quirky Dog.mp3");
+        soundPlayer.setLoop(OF_LOOP_NORMAL);
+        soundPlayer.play();
+        analysisThread.startPolling();
     }
 }
 
-//--------------------------------------------------------------
-void ofApp::draw()
+void ofApp::assetsLoaded()
 {
-    // begin drawing the eq into the frame buffer
-    eqFbo.begin();
+    loading = false;
+    
+    // the box and the outline have been made from the model if they needed it
+    model.clear();
+    
+    // set the camera in the meshes, this is needed so that we know
+    // how to translate from screen coordinates to world coordinated to be able
+    // to pick points to warp, the warp is shared by all of the outputs
+    // so we always warp it as the first projector sees it
+    outlineMesh.setCamera(outputs[0].camera);
+    boxMesh.setCamera(outputs[0].camera);
+    
+    // the pickers need the same camera to work out where
+    // the vertices are on the screen
+    boxPicker.setup(boxMesh, outputs[0].camera);
+    outlinePicker.setup(outlineMesh, outputs[0].camera);
+    
+    // the settings may have turned the box before the meshes were here
+    float angle = boxAngle;
+    boxAngleChanged(angle);
+    
+    // keep a journal of every vertex that we warp so that we don't lose our
+    // alignment if we crash, this also puts back anything that was warped
+    // after the meshes were last saved in full
+    warpJournal.addMesh(boxMesh, "box.mesh");
+    warpJournal.addMesh(outlineMesh, "outline.mesh");
+    warpJournal.setup("warp.journal");
+    
+    // the journal already looks for the vertices that have moved so it
+    // tells the pickers and the remaps rather than them looking as well
+    warpJournal.setListener([this](unsigned mesh, unsigned vertex)
+    {
+        if (mesh == 0)
+        {
+            boxPicker.vertexMoved(vertex);
+            for (ProjectorOutput& output : outputs) output.remap.meshChanged();
+            edgeBlend.meshChanged();
+            laserOutput.meshChanged();
+        }
+        else outlinePicker.vertexMoved(vertex);
+    });
+    
+    // load the settings and the ply meshes again if they're changed while
+    // we're running, when a mesh is swapped in everything that follows its
+    // vertices has to catch up and the journal keeps the new ones safe
+    hotReloader.addSettings(gui.getParameter(), "settings.xml");
+    hotReloader.addMesh(boxMesh, "box.ply");
+    hotReloader.addMesh(outlineMesh, "outline.ply");
+    hotReloader.setListener([this](const string& path)
+    {
+        if (path == "settings.xml") return;
+        if (path == "box.ply")
+        {
+            boxPicker.verticesChanged();
+            for (ProjectorOutput& output : outputs) output.remap.meshChanged();
+            edgeBlend.meshChanged();
+            laserOutput.meshChanged();
+        }
+        else
+        {
+            outlineMesh.setMode(OF_PRIMITIVE_LINES);
+            outlinePicker.verticesChanged();
+        }
+        hoveredPicker = NULL;
+        hoveredVertex = -1;
+        clearSelection();
+        warpJournal.verticesChanged();
+    });
+    hotReloader.setup();
+    
+    // the gui's save button writes settings.xml while we're watching it
+    ofAddListener(gui.savePressedE, this, &ofApp::savePressed);
+    
+    updateMeshEvents();
+    
+    // say where the time before the first real frame went
+    ofLogNotice("ofApp") << "started up in " << (ofGetElapsedTimeMicros() - startupMicros) / 1000.f << "ms, "
+                         << setupMicros / 1000.f << "ms of it setting up on this thread while loading" << endl
+                         << assetLoader.getReport();
+}
 
-    // clear the frame buffer to brightness 0 (black)
-    // and alpha 255 (opaque)
-    ofClear(0, 255);
+void ofApp::drawLoading()
+{
+    // a thin bar across the bottom of each output so we can see that
+    // something is happening without lighting up the box
+    const float progress = assetLoader.getProgress();
+    ofSetColor(64);
+    for (int i = 0; i < numOutputs; ++i)
+    {
+        const ofRectangle viewport = getOutputViewport(i);
+        ofDrawRectangle(viewport.x, viewport.getBottom() - 4.f, progress * viewport.width, 4.f);
+    }
+}
 
-    // calculate how wide each bar of the eq needs to be
-    const float barWidth = eqFbo.getWidth() / NUM_FFT_BANDS;
+//--------------------------------------------------------------
+void ofApp::update()
+{
+    // finish off whatever has loaded since last frame, once
+    // it's all here we can finish setting up with it
+    if (loading)
+    {
+        if (!assetLoader.update()) return;
+        assetsLoaded();
+    }
+    
+    // write any vertices that have been warped to the journal
+    warpJournal.update();
+    
+    // pick up the latest smoothed and normalised fft (values between 0 and 1)
+    // from the analysis thread so we can use it to draw the eq
+    if (analysisThread.update() && !latencyProbePath.empty()) latencyProbe.spectrumUpdated(analysisThread.getSnapshot());
+}
 
-    // make the same number of vertical as horizontal divisions
-    const float barHeight = eqFbo.getHeight() / NUM_FFT_BANDS;
+//--------------------------------------------------------------
+void ofApp::draw()
+{
+    if (loading)
+    {
+        drawLoading();
+        return;
+    }
     
-    // loop through all of the bands of the FFT
-    for (unsigned i = 0; i < NUM_FFT_BANDS; ++i)
+    profiler.beginFrame();
+    
+    // draw the eq into the frame buffer
+    profiler.begin(eqStage);
+    updateEqFbo();
+    profiler.end(eqStage);
+    
+    // hand the newest video frame to the gpu if there's one that we haven't shown yet
+    if (!videoPath.empty())
     {
-        // cycle through the rainbow for the bars
-        ofSetColor(ofFloatColor::fromHsb(i / (float)(NUM_FFT_BANDS - 1), 1.f, 1.f));
-        
-        // work out how many cats are in this column
-        unsigned numCatsInColumn = ROUND(normalisedFft[i] * NUM_FFT_BANDS);
-        
-        for (unsigned j = 0; j < numCatsInColumn; ++j)
+        FrameProfiler::Scope videoScope(profiler, videoStage);
+        videoSource.update();
+    }
+    
+    // when probing, check whether the first row of cats has been drawn yet,
+    // this is outside of the eq stage so the read back isn't counted in it
+    if (!latencyProbePath.empty())
+    {
+        const float barHeight = eqFbo.getHeight() / NUM_FFT_BANDS;
+        latencyProbe.eqDrawn(eqFbo, ofRectangle(0.f, .15f * barHeight, eqFbo.getWidth(), .7f * barHeight));
+    }
+    
+    // bake the box into each output's remap again if its projector, the box
+    // angle or the warp have changed, they're the same size as the outputs
+    const ofMatrix4x4 boxTransform = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
+    if (remapBox)
+    {
+        FrameProfiler::Scope remapScope(profiler, remapStage);
+        for (int i = 0; i < numOutputs; ++i)
         {
-            // draw the cat image at the appropriate place at 0.7 times
-            // the size of a division to leave a margin on each
-            // side of 0.15 times the size of a division
-            catImage.draw(barWidth * (i + .15f), barHeight * (j + .85f), barWidth * .7f, -barHeight * .7f);
+            const ofRectangle viewport = getOutputViewport(i);
+            outputs[i].remap.update(boxMesh, outputs[i].camera, boxTransform, viewport.width, viewport.height);
         }
     }
-
-    // end drawing to the frame buffer
-    eqFbo.end();
     
-    // look at the scene from the perspective of the projector
-    // when using ofxPostProcessing with a camera object we do this
-    // by passing the camera to the ofxPostProcessing::begin()
-    // function as an argument
-    outlineEffects.begin(projector);
+    // the blend masks only need making again when a projector, the box
+    // angle or the warp change, otherwise this just checks that they haven't
+    if (blendEdges)
+    {
+        FrameProfiler::Scope edgeBlendScope(profiler, edgeBlendStage);
+        vector<EdgeBlend::Projector> projectors;
+        for (int i = 0; i < numOutputs; ++i)
+        {
+            const ofRectangle viewport = getOutputViewport(i);
+            projectors.push_back(EdgeBlend::Projector(outputs[i].camera, viewport.width, viewport.height));
+        }
+        edgeBlend.setFeather(blendFeather);
+        edgeBlend.update(projectors, boxMesh, boxTransform);
+    }
+    
+    // the laser is next to the first projector and traces the parts of
+    // the outline that it can see, the box is what's in the way
+    if (laserOutput.isOpen())
+    {
+        FrameProfiler::Scope laserScope(profiler, laserStage);
+        laserOutput.update(outlineMesh, boxMesh, boxTransform, outputs[0].camera, getOutputViewport(0), getOutlineColour());
+    }
+    
+    // everything above is done once a frame however many projectors there
+    // are, now the scene is drawn from each of their points of view, the
+    // scene and post processing stages only time the first one so they
+    // can be compared with one output, the rest are timed together, the
+    // passes are run for every output and show the time of the last one
+    for (int i = 0; i < numOutputs; ++i)
+    {
+        if (i == 1) profiler.begin(otherOutputsStage);
+        
+        // look at the scene from the perspective of the projector
+        // when using ofxPostProcessing with a camera object we do this
+        // by passing the camera to the ofxPostProcessing::begin()
+        // function as an argument
+        outlineEffects.begin(outputs[i].camera);
+        if (i == 0) profiler.begin(sceneStage);
+        drawScene(outputs[i]);
+        if (i == 0) profiler.end(sceneStage);
+        
+        // finish drawing the scene from the perspective of the projector
+        // this is where all of the post processing passes are run, then
+        // it's drawn into this projector's part of the window with its
+        // blend mask applied
+        if (i == 0) profiler.begin(postProcessingStage);
+        const ofRectangle viewport = getOutputViewport(i);
+        outlineEffects.end(false);
+        ofSetColor(255);
+        if (blendEdges) edgeBlend.begin(i, blendGamma);
+        outlineEffects.draw(viewport.x, viewport.y, viewport.width, viewport.height);
+        if (blendEdges) edgeBlend.end();
+        if (i == 0) profiler.end(postProcessingStage);
+    }
+    if (numOutputs > 1) profiler.end(otherOutputsStage);
     
+    // draw the user interface
+    if (drawGui)
+    {
+        FrameProfiler::Scope guiScope(profiler, guiStage);
+        gui.draw();
+        
+        // show how many eq frames we've saved by only redrawing what changed
+        ofSetColor(255);
+        ofDrawBitmapString("eq frames full: " + ofToString(numEqFramesFull) +
+                           "\neq frames partial: " + ofToString(numEqFramesPartial) +
+                           "\neq frames skipped: " + ofToString(numEqFramesSkipped) +
+                           "\nspectrum age (ms): " + ofToString(analysisThread.getSnapshotAgeMicros() / 1000.f, 1) +
+                           "\nremap bakes: " + ofToString(outputs[0].remap.getNumBakes()) +
+                           " (last took " + ofToString(outputs[0].remap.getLastBakeMillis(), 2) + "ms)" +
+                           "\nblend masks: " + ofToString(edgeBlend.getNumComputes()) + " made" +
+                           " (last took " + ofToString(edgeBlend.getLastComputeMillis(), 2) + "ms), " +
+                           ofToString(edgeBlend.getNumCacheLoads()) + " loaded" +
+                           (edgeBlend.isComputing() ? ", making new ones" : "") +
+                           "\n" + framePacer.getStatus() +
+                           (videoPath.empty() ? "" : "\n" + videoSource.getStatus()) +
+                           (laserDestination.empty() ? "" : "\n" + laserOutput.getStatus()) +
+                           (latencyProbePath.empty() ? "" : "\n" + latencyProbe.getSummary()),
+                           gui.getPosition().x, gui.getShape().getBottom() + 20.f);
+    }
+    
+    if (calibrating) drawCalibration();
+    
+    // circle the vertex that the mouse is over
+    else if (hoveredPicker && hoveredVertex >= 0)
+    {
+        ofPushStyle();
+        ofNoFill();
+        ofSetColor(255, 255, 0);
+        ofDrawCircle(hoveredPicker->getScreenPosition(hoveredVertex), 10.f);
+        ofPopStyle();
+    }
+    
+    // and fill in the one that's selected for warping
+    if (!calibrating && selectedPicker)
+    {
+        ofPushStyle();
+        ofSetColor(255, 0, 0);
+        ofDrawCircle(selectedPicker->getScreenPosition(selectedVertex), 5.f);
+        ofPopStyle();
+    }
+    
+    if (drawProfiler) profiler.draw(gui.getPosition().x, gui.getShape().getBottom() + 175.f);
+    
+    profiler.endFrame();
+}
+
+void ofApp::drawScene(ProjectorOutput& output)
+{
     // rotate our box so by 45 degrees around the y axis
     // so it's not face on to the projector
     ofPushMatrix();
@@ -234,67 +697,483 @@ void ofApp::draw()
     // longer present in newer versions of OpenGL
     ofSetLineWidth(5.f);
     
-    // draw our box mesh with the EQ texture
-    eqFbo.getTexture().bind();
-    boxMesh.draw();
-    eqFbo.getTexture().unbind();
+    // draw our box mesh with the EQ texture, the cats carry their own
+    // colours so we make sure the box itself isn't tinted
+    ofSetColor(255);
+    if (remapBox)
+    {
+        // one full screen pass that looks up the eq for every pixel of the box
+        output.remap.draw(getBoxTexture());
+    }
+    else
+    {
+        ofTexture& boxTexture = getBoxTexture();
+        boxTexture.bind();
+        boxMesh.draw();
+        boxTexture.unbind();
+    }
     
     // now draw a glowing green outline
-    // we want the outline to pulsate slightly, so we map sin(ofGetElapsedTimef())
-    // from its initial range (-1 to 1) to between 127 (half brightness)
-    // and 255 (full brightness)
-    ofSetColor(0, ofMap(sin(ofGetElapsedTimef()), -1.f, 1.f, 127.f, 255.f), 0);
+    ofSetColor(getOutlineColour());
     outlineMesh.draw();
-    outlineMesh.drawSelectedVertices();
     
     // disable depth testing
     ofDisableDepthTest();
     
     // reset the transform to what it was before we rotated it
     ofPopMatrix();
+}
+
+ofColor ofApp::getOutlineColour() const
+{
+    // we want the outline to pulsate slightly, so we map sin() of the elapsed time
+    // from its initial range (-1 to 1) to between 127 (half brightness)
+    // and 255 (full brightness)
+    return ofColor(0, ofMap(sin(HeadlessBenchmark::getElapsedTimef()), -1.f, 1.f, 127.f, 255.f), 0);
+}
+
+ofTexture& ofApp::getBoxTexture()
+{
+    if (showVideo && videoSource.isReady()) return videoSource.getTexture();
+    return eqFbo.getTexture();
+}
+
+ofRectangle ofApp::getOutputViewport(unsigned output) const
+{
+    const float width = ofGetWidth() / (float)numOutputs;
+    return ofRectangle(ROUND(output * width), 0.f, ROUND((output + 1) * width) - ROUND(output * width), ofGetHeight());
+}
+
+unsigned ofApp::getOutputAt(float x, float y) const
+{
+    for (int i = 1; i < numOutputs; ++i)
+    {
+        if (x < getOutputViewport(i).x) return i - 1;
+    }
+    return numOutputs - 1;
+}
+
+void ofApp::resizeOutputs()
+{
+    const ofRectangle viewport = getOutputViewport(0);
+    outlineEffects.init(viewport.width, viewport.height);
+}
+
+void ofApp::updateMeshEvents()
+{
+    // the meshes' own events look at every vertex to find the one to move
+    outlineMesh.setEventsEnabled(false);
+    boxMesh.setEventsEnabled(false);
+    if (loading || numOutputs != 1 || calibrating)
+    {
+        hoveredPicker = NULL;
+        hoveredVertex = -1;
+        clearSelection();
+    }
+}
+
+void ofApp::updateEqFbo()
+{
+    // calculate how wide each bar of the eq needs to be
+    const float barWidth = eqFbo.getWidth() / NUM_FFT_BANDS;
+    
+    // make the same number of vertical as horizontal divisions
+    const float barHeight = eqFbo.getHeight() / NUM_FFT_BANDS;
     
-    // finish drawing the scene from the perspective of the projector
-    outlineEffects.end();
+    const float* normalisedFft = &analysisThread.getSnapshot().normalised[0];
     
-    // draw the user interface
-    if (drawGui) gui.draw();
+    // work out how many cats are in each column and which columns
+    // are different from what is already in the frame buffer
+    bool columnChanged[NUM_FFT_BANDS];
+    unsigned numChangedColumns = 0;
+    for (unsigned i = 0; i < NUM_FFT_BANDS; ++i)
+    {
+        const unsigned numCatsInColumn = ROUND(normalisedFft[i] * NUM_FFT_BANDS);
+        
+        // if we're not redrawing incrementally or there's nothing
+        // in the frame buffer yet then every column needs drawing
+        columnChanged[i] = !incrementalEq || !eqFboDrawn || numCatsInColumn != eqCatsInColumn[i];
+        if (columnChanged[i]) ++numChangedColumns;
+        
+        eqCatsInColumn[i] = numCatsInColumn;
+    }
+    
+    // if nothing has changed then the frame buffer already
+    // has the right thing in it so we don't need to touch it
+    if (numChangedColumns == 0)
+    {
+        ++numEqFramesSkipped;
+        return;
+    }
+    
+    // begin drawing the eq into the frame buffer
+    eqFbo.begin();
+    
+    if (numChangedColumns == NUM_FFT_BANDS)
+    {
+        // clear the frame buffer to brightness 0 (black)
+        // and alpha 255 (opaque)
+        ofClear(0, 255);
+        ++numEqFramesFull;
+    }
+    else
+    {
+        // only clear the columns that have changed, the scissor test
+        // stops ofClear() from touching anything outside of the rectangle
+        glEnable(GL_SCISSOR_TEST);
+        for (unsigned i = 0; i < NUM_FFT_BANDS; ++i)
+        {
+            if (!columnChanged[i]) continue;
+            const int x = floor(barWidth * i);
+            glScissor(x, 0, ceil(barWidth * (i + 1)) - x, eqFbo.getHeight());
+            ofClear(0, 255);
+        }
+        glDisable(GL_SCISSOR_TEST);
+        ++numEqFramesPartial;
+    }
+    
+    // rather than drawing each cat separately, which would mean a draw
+    // call per cat, we add them all to a batch and draw them in one go
+    catBatch.clear();
+    
+    // loop through all of the bands of the FFT
+    for (unsigned i = 0; i < NUM_FFT_BANDS; ++i)
+    {
+        // the cats in this column are still in the frame buffer from before
+        if (!columnChanged[i]) continue;
+        
+        for (unsigned j = 0; j < eqCatsInColumn[i]; ++j)
+        {
+            // add the cat image at the appropriate place at 0.7 times
+            // the size of a division to leave a margin on each
+            // side of 0.15 times the size of a division
+            catBatch.add(barWidth * (i + .15f), barHeight * (j + .85f), barWidth * .7f, -barHeight * .7f, eqColumnColours[i]);
+        }
+    }
+    
+    // draw all of the cats with a single draw call
+    catBatch.draw();
+    
+    // end drawing to the frame buffer
+    eqFbo.end();
+    
+    eqFboDrawn = true;
 }
 
 void ofApp::exit()
 {
+    // say how well we kept up with the display
+    ofLogNotice("ofApp") << "frame pacing: " << framePacer.getStatus();
+    
+    // stop watching the files before we save them ourselves
+    hotReloader.close();
+    
+    // finish writing the frame times if we were
+    profiler.stopCsv();
+    
+    // write out how long the bursts took to get to the eq
+    if (!latencyProbePath.empty())
+    {
+        ofLogNotice("ofApp") << "latency probe" << endl << latencyProbe.getReport();
+        latencyProbe.save(latencyProbePath);
+    }
+    
+    // stop the audio and the analysis thread and wait for it to finish
+    soundStream.close();
+    nullSoundStream.close();
+    analysisThread.waitForThread(true);
+    
+    // and the video's thread if it has one
+    videoSource.close();
+    
+    // and the laser's, which finishes off its file if it's writing one
+    laserOutput.close();
+    
+    // if we're closed before everything has loaded then we haven't
+    // got anything to save and mustn't overwrite what's there
+    if (loading)
+    {
+        assetLoader.close();
+        return;
+    }
+    
+    // a benchmark only renders frames, it mustn't save over the
+    // settings and meshes that the app loads next time it's run
+    if (HeadlessBenchmark::isRunning())
+    {
+        warpJournal.close(false);
+        return;
+    }
+    
+    // save the meshes one last time from the journal
+    // and wait for it to finish writing
+    warpJournal.close();
+    
     // save the settings
     gui.saveToFile("settings.xml");
     
-    // save the meshes
+    // save the meshes, ply so they can be opened in other
+    // software and binary so they load quickly next time
     boxMesh.save("box.ply");
     outlineMesh.save("outline.ply");
+    BinaryMesh::save(boxMesh, "box.mesh");
+    BinaryMesh::save(outlineMesh, "outline.mesh");
+}
+
+void ofApp::calibrateProjector()
+{
+    ProjectorOutput& output = outputs[calibrationOutput];
+    const ofMatrix4x4 boxTransform = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
+    const ProjectorCalibration::Result result = output.calibration.solve(output.camera, boxTransform,
+                                                                         getOutputViewport(calibrationOutput));
+    
+    // if there weren't enough targets we keep the last result
+    // on screen but leave the projector where it is
+    if (!result.solved)
+    {
+        output.lastCalibration.solved = false;
+        return;
+    }
+    output.lastCalibration = result;
+    output.applyCalibration(result);
+}
+
+int ofApp::getNearestCalibrationPoint(float x, float y, float maxDistance) const
+{
+    const ProjectorOutput& output = outputs[calibrationOutput];
+    const ProjectorCalibration& calibration = output.calibration;
+    const ofMatrix4x4 boxTransform = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
+    const ofRectangle viewport = getOutputViewport(calibrationOutput);
+    const ofVec2f mouse(x, y);
+    
+    int nearest = -1;
+    float nearestDistance = maxDistance;
+    for (unsigned i = 0; i < calibration.getNumPoints(); ++i)
+    {
+        const ofVec2f point = calibration.hasTarget(i) ? calibration.getTarget(i) :
+            output.camera.worldToScreen(calibration.getModelPoint(i) * boxTransform, viewport);
+        const float distance = point.distance(mouse);
+        if (distance < nearestDistance)
+        {
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+void ofApp::drawCalibration()
+{
+    const ProjectorOutput& output = outputs[calibrationOutput];
+    const ProjectorCalibration& calibration = output.calibration;
+    const ProjectorCalibration::Result& lastCalibration = output.lastCalibration;
+    const ofMatrix4x4 boxTransform = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
+    const ofRectangle viewport = getOutputViewport(calibrationOutput);
+    
+    ofPushStyle();
+    
+    // outline the projector we're calibrating if there's more than one
+    if (numOutputs > 1)
+    {
+        ofNoFill();
+        ofSetColor(255, 255, 0);
+        ofDrawRectangle(viewport.x + 1.f, viewport.y + 1.f, viewport.width - 2.f, viewport.height - 2.f);
+    }
+    
+    float squaredError = 0.f;
+    for (unsigned i = 0; i < calibration.getNumPoints(); ++i)
+    {
+        // where the corner is projected to now in yellow
+        const ofVec2f projected = output.camera.worldToScreen(calibration.getModelPoint(i) * boxTransform, viewport);
+        ofNoFill();
+        ofSetColor(255, 255, 0);
+        ofDrawCircle(projected, 8.f);
+        ofDrawBitmapString(ofToString(i + 1), projected + ofVec2f(10.f, -10.f));
+        
+        // where it should be as a red cross, with a line to where it is
+        if (calibration.hasTarget(i))
+        {
+            const ofVec2f target = calibration.getTarget(i);
+            ofSetColor(255, 0, 0);
+            ofDrawLine(target - ofVec2f(8.f, 8.f), target + ofVec2f(8.f, 8.f));
+            ofDrawLine(target - ofVec2f(8.f, -8.f), target + ofVec2f(8.f, -8.f));
+            ofDrawLine(target, projected);
+            squaredError += target.squareDistance(projected);
+        }
+    }
+    
+    // the error is measured with openFrameworks' own projection
+    // so it shows exactly what ends up on the screen
+    const unsigned numTargets = calibration.getNumTargets();
+    string status = (numOutputs > 1 ? "output " + ofToString(calibrationOutput + 1) + ", " : string()) +
+                    "calibrating: drag the corners to where they really are, right click to remove,\n"
+                    "1-8 put that corner at the mouse, backspace clears them all, k to finish\n" +
+                    ofToString(numTargets) + " of " + ofToString(calibration.getNumPoints()) + " corners placed";
+    if (numTargets < ProjectorCalibration::MIN_TARGETS)
+    {
+        status += ", place at least " + ofToString(ProjectorCalibration::MIN_TARGETS) + " to solve";
+    }
+    else if (lastCalibration.solved)
+    {
+        status += "\nerror: " + ofToString(sqrt(squaredError / numTargets), 2) + "px" +
+                  "\nfov: " + ofToString(lastCalibration.fov, 2) +
+                  " lens offset: " + ofToString(lastCalibration.lensOffset) +
+                  "\nsolved in " + ofToString(lastCalibration.solveMillis, 3) + "ms, " +
+                  ofToString(lastCalibration.numIterations) + " iterations" +
+                  (lastCalibration.usedDlt ? " from the dlt" : " from the current projector");
+    }
+    ofDrawBitmapStringHighlight(status, viewport.x + 20.f, ofGetHeight() - 100.f);
+    ofPopStyle();
+}
+
+void ofApp::dumpOutputs()
+{
+    vector<pair<string, ofRectangle> > regions;
+    regions.push_back(make_pair("frame", ofRectangle(0, 0, ofGetWidth(), ofGetHeight())));
+    for (unsigned i = 0; i < (unsigned)numOutputs; ++i) regions.push_back(make_pair("output" + ofToString(i + 1), getOutputViewport(i)));
+    for (unsigned i = 0; i < regions.size(); ++i)
+    {
+        const ofRectangle& region = regions[i].second;
+        const string path = dumpPrefix + regions[i].first + ".png";
+        ofImage image;
+        image.grabScreen(region.x, region.y, region.width, region.height);
+        image.save(path);
+        ofLogNotice("ofApp") << "saved " << path;
+    }
 }
 
-void ofApp::projectorPositionChanged(ofVec3f& projectorPosition)
+void ofApp::updateHoveredVertex(float x, float y)
 {
-    projector.setPosition(projectorPosition);
+    hoveredPicker = NULL;
+    hoveredVertex = -1;
+    if (loading || calibrating || numOutputs > 1 || (drawGui && gui.getShape().inside(x, y))) return;
+    
+    // the box and the outline have their corners in the same places so
+    // the outline only wins if its vertex is strictly nearer
+    const ofVec2f mouse(x, y);
+    float maxDistance = 20.f;
+    VertexPicker* pickers[] = { &boxPicker, &outlinePicker };
+    for (VertexPicker* picker : pickers)
+    {
+        const int vertex = picker->getNearest(mouse, maxDistance);
+        if (vertex >= 0)
+        {
+            hoveredPicker = picker;
+            hoveredVertex = vertex;
+            maxDistance = mouse.distance(picker->getScreenPosition(vertex));
+        }
+    }
 }
 
-void ofApp::projectorTiltChanged(float& projectorTilt)
+void ofApp::moveSelectedVertex(const ofVec2f& screen)
 {
-    // get the current orientation
-    ofVec3f orientation = projector.getOrientationEuler();
+    ofxWarpableMesh& mesh = selectedPicker == &boxPicker ? boxMesh : outlineMesh;
+    mesh.getVertices()[selectedVertex] = selectedPicker->unproject(selectedVertex, screen);
     
-    // change the tilt (x rotation)
-    projector.setOrientation(ofVec3f(projectorTilt, orientation.y, orientation.z));
+    // the picker needs to know straight away so the next move starts from
+    // here, the journal tells it again along with the remaps and the blend,
+    // it only has to look at the one vertex rather than all of them
+    selectedPicker->vertexMoved(selectedVertex);
+    warpJournal.verticesMoved(selectedPicker == &boxPicker ? 0 : 1, vector<unsigned>(1, selectedVertex));
+}
+
+void ofApp::clearSelection()
+{
+    selectedPicker = NULL;
+    selectedVertex = -1;
+    dragging = false;
 }
 
 void ofApp::boxAngleChanged(float& boxAngle)
 {
+    // the meshes may still be loading, they're turned once they're here
+    if (loading) return;
+    
     ofMatrix4x4 rotation = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
     boxMesh.setTransform(rotation);
     outlineMesh.setTransform(rotation);
+    boxPicker.setTransform(rotation);
+    outlinePicker.setTransform(rotation);
+}
+
+void ofApp::numOutputsChanged(int& numOutputs)
+{
+    // this gets called when the settings are loaded before the post processing is set up
+    if (!bloomPass) return;
+    
+    if (calibrationOutput >= (unsigned)numOutputs) calibrationOutput = 0;
+    resizeOutputs();
+    updateMeshEvents();
+}
+
+void ofApp::bloomModeChanged(int& bloomMode)
+{
+    // this gets called when the settings are loaded before there are any passes
+    if (!bloomPass || !mipBloomPass) return;
+    
+    FrameProfiler::setPassEnabled(outlineEffects, bloomPass, bloomMode == 0);
+    FrameProfiler::setPassEnabled(outlineEffects, mipBloomPass, bloomMode > 0);
+    if (bloomMode > 0) mipBloomPass->setQuality((MipBloomPass::Quality)(bloomMode - 1));
+}
+
+bool ofApp::savePressed()
+{
+    // save it ourselves rather than letting the gui do it so that we can tell
+    // the hot reloader it's us and it doesn't load the settings back in
+    gui.saveToFile("settings.xml");
+    hotReloader.fileSaved("settings.xml");
+    return true;
 }
 
 void ofApp::keyPressed(int key)
 {
     if (key == 'f') ofToggleFullscreen();
+    else if (key == 'l') ofLogNotice("ofApp") << "mesh load benchmark: " << BinaryMesh::benchmark();
+    else if (key == 'o') ofLogNotice("ofApp") << "outline extraction benchmark: " << FeatureEdgeExtractor::benchmark();
+    else if (key == 'v') ofLogNotice("ofApp") << "vertex picking benchmark: " << VertexPicker::benchmark();
+    else if (key == 'e') ofLogNotice("ofApp") << "edge blend benchmark" << endl << EdgeBlend::benchmark();
+    else if (key == 'i') ofLogNotice("ofApp") << "laser benchmark" << endl << LaserOutput::benchmark();
     else if (key == 'g') drawGui = !drawGui;
+    else if (key == 'k')
+    {
+        // while calibrating the mouse moves the calibration targets
+        // rather than warping the meshes, we calibrate the projector
+        // whose output the mouse is in
+        calibrating = !calibrating;
+        calibrationOutput = getOutputAt(ofGetMouseX(), ofGetMouseY());
+        selectedCalibrationPoint = -1;
+        updateMeshEvents();
+    }
+    else if (calibrating && key >= '1' && key < '1' + (int)NUM_BOX_VERTICES)
+    {
+        outputs[calibrationOutput].calibration.setTarget(key - '1', ofVec2f(ofGetMouseX(), ofGetMouseY()));
+        calibrateProjector();
+    }
+    else if (calibrating && key == OF_KEY_BACKSPACE)
+    {
+        outputs[calibrationOutput].calibration.clearTargets();
+        outputs[calibrationOutput].lastCalibration.solved = false;
+    }
+    else if (selectedPicker && key >= OF_KEY_LEFT && key <= OF_KEY_DOWN)
+    {
+        const ofVec2f steps[] = { ofVec2f(-1.f, 0.f), ofVec2f(0.f, -1.f), ofVec2f(1.f, 0.f), ofVec2f(0.f, 1.f) };
+        moveSelectedVertex(selectedPicker->getScreenPosition(selectedVertex) + steps[key - OF_KEY_LEFT]);
+    }
+    else if (key == 'p') drawProfiler = !drawProfiler;
+    else if (key == 'c')
+    {
+        // start or stop writing the time of every stage of every frame to a csv
+        if (profiler.isWritingCsv()) profiler.stopCsv();
+        else profiler.startCsv("profile-" + ofGetTimestampString() + ".csv");
+    }
+    else if (key == 'b')
+    {
+        ofLogNotice("ofApp") << "spectrum analyser benchmark" << endl << SpectrumAnalyser::benchmark();
+        ofLogNotice("ofApp") << "streaming fft benchmark" << endl
+                             << StreamingFft::benchmark(FFT_SIZE, FFT_HOP_SIZE) << endl
+                             << StreamingFft::benchmark(FFT_SIZE, FFT_SIZE / 2) << endl
+                             << StreamingFft::benchmark(2 * FFT_SIZE, FFT_HOP_SIZE / 2);
+    }
 }
 
 //--------------------------------------------------------------
@@ -303,28 +1182,75 @@ void ofApp::keyReleased(int key){
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseMoved(int x, int y ){
-
+void ofApp::mouseMoved(int x, int y)
+{
+    updateHoveredVertex(x, y);
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseDragged(int x, int y, int button){
-
+void ofApp::mouseDragged(int x, int y, int button)
+{
+    updateHoveredVertex(x, y);
+    if (dragging) moveSelectedVertex(ofVec2f(x, y) + dragOffset);
+    
+    // re-solve as the target is dragged so we can see it line up
+    if (calibrating && selectedCalibrationPoint >= 0)
+    {
+        outputs[calibrationOutput].calibration.setTarget(selectedCalibrationPoint, ofVec2f(x, y));
+        calibrateProjector();
+    }
 }
 
 //--------------------------------------------------------------
-void ofApp::mousePressed(int x, int y, int button){
-
+void ofApp::mousePressed(int x, int y, int button)
+{
+    if (drawGui && gui.getShape().inside(x, y)) return;
+    
+    // pick whatever is circled, or nothing if we clicked away from the
+    // meshes, there's never anything circled when we can't warp
+    if (!calibrating)
+    {
+        updateHoveredVertex(x, y);
+        selectedPicker = hoveredPicker;
+        selectedVertex = hoveredVertex;
+        dragging = selectedPicker != NULL;
+        if (dragging) dragOffset = selectedPicker->getScreenPosition(selectedVertex) - ofVec2f(x, y);
+        return;
+    }
+    
+    // clicking in another output moves on to calibrating that projector
+    calibrationOutput = getOutputAt(x, y);
+    ProjectorCalibration& calibration = outputs[calibrationOutput].calibration;
+    
+    const int nearest = getNearestCalibrationPoint(x, y, 40.f);
+    if (button == OF_MOUSE_BUTTON_RIGHT)
+    {
+        if (nearest >= 0)
+        {
+            calibration.clearTarget(nearest);
+            calibrateProjector();
+        }
+    }
+    else if (nearest >= 0)
+    {
+        selectedCalibrationPoint = nearest;
+        calibration.setTarget(nearest, ofVec2f(x, y));
+        calibrateProjector();
+    }
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseReleased(int x, int y, int button){
-
+void ofApp::mouseReleased(int x, int y, int button)
+{
+    selectedCalibrationPoint = -1;
+    dragging = false;
 }
 
 //--------------------------------------------------------------
-void ofApp::windowResized(int w, int h){
-
+void ofApp::windowResized(int w, int h)
+{
+    // the outputs share the window so they change size with it
+    resizeOutputs();
 }
 
 //--------------------------------------------------------------
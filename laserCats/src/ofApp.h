@@ -5,6 +5,27 @@
 #include "HsbShiftPass.h"
 #include "ofxWarpableMesh.h"
 #include "ofxGui.h"
+#include "SpriteBatch.h"
+#include "BinaryMesh.h"
+#include "HeadlessBenchmark.h"
+#include "FrameProfiler.h"
+#include "MipBloomPass.h"
+#include "ProjectorCalibration.h"
+#include "ProjectorOutput.h"
+#include "EdgeBlend.h"
+#include "WarpJournal.h"
+#include "VertexPicker.h"
+#include "AudioAnalysisThread.h"
+#include "PcmPlayer.h"
+#include "StreamingFft.h"
+#include "NullSoundStream.h"
+#include "LatencyProbe.h"
+#include "FramePacer.h"
+#include "HotReloader.h"
+#include "AssetLoader.h"
+#include "VideoTextureSource.h"
+#include "FeatureEdgeExtractor.h"
+#include "LaserOutput.h"
 
 class ofApp : public ofBaseApp
 {
@@ -16,6 +37,41 @@ public:
     static const unsigned NUM_OUTLINE_INDICES = 24;
     static const unsigned OUTLINE_INDICES[NUM_OUTLINE_INDICES];
     static const unsigned NUM_FFT_BANDS = 8;
+    static const unsigned NUM_RAW_FFT_BINS = 512;
+    static const unsigned FFT_SIZE = 2 * NUM_RAW_FFT_BINS;
+    static const unsigned FFT_HOP_SIZE = 256;
+    static const unsigned AUDIO_BUFFER_SIZE = 256;
+    static const unsigned LATENCY_PROBE_SAMPLE_RATE = 44100;
+    static const unsigned MAX_OUTPUTS = 6;
+    
+    ofApp();
+    
+    // drive this many projectors rather than however many were
+    // saved in the settings, call this before the app is run
+    void setNumOutputs(unsigned numOutputs) { requestedNumOutputs = numOutputs; }
+    
+    // play tone bursts instead of the music and time how long they take to
+    // show up in the eq, the results are written to outputPath on exit
+    void setLatencyProbe(const string& outputPath) { latencyProbePath = outputPath; }
+    
+    // play the wav or the bursts to no sound card at all, e.g. on a build server
+    void setNullAudio(bool nullAudio) { this->nullAudio = nullAudio; }
+    
+    // play a movie or a directory of images at frameRate on the box instead
+    // of the eq, showVideo in the gui switches back to the eq
+    void setVideo(const string& path, float frameRate) { videoPath = path; videoFrameRate = frameRate; }
+    
+    // trace the parts of the outline that the first projector can see with a
+    // laser as well, destination is an ILDA file to write or udp:[host:]port
+    void setLaser(const string& destination, unsigned pointsPerSecond) { laserDestination = destination; laserPointsPerSecond = pointsPerSecond; }
+    
+    // when benchmarking save the last frame as prefixframe.png and each
+    // projector's part of it as prefixoutput1.png and so on
+    void setDump(const string& prefix) { dumpPrefix = prefix; }
+    
+    // checks the eq's fft settings with StreamingFft::test, and the other
+    // sizes the 'b' key benchmarks, and logs how it went
+    static bool testFft();
     
     void setup();
     void update();
@@ -33,36 +89,222 @@ public:
     void gotMessage(ofMessage msg);
 
 private:
-    void projectorPositionChanged(ofVec3f& projectorPosition);
-    void projectorTiltChanged(float& projectorTilt);
+    // saves the settings when the gui's save button is pressed
+    bool savePressed();
+    
+    // load one of the meshes from its binary or ply file, this
+    // is called on one of the asset loader's threads
+    bool loadMesh(ofxWarpableMesh& mesh, const string& name);
+    
+    // if nothing has been saved but there's a model.ply then we use that as
+    // the box, or work its outline out from it, also on a loader thread
+    bool loadModel(ofxWarpableMesh& mesh, bool outline);
+    
+    // play the wav or the bursts ourselves if we've got them, the mp3 if not
+    void startAudio();
+    
+    // finish setting up everything that needs the meshes once they've loaded
+    void assetsLoaded();
+    
+    // a progress bar across the bottom of each output until then
+    void drawLoading();
+    
     void boxAngleChanged(float& boxAngle);
+    void numOutputsChanged(int& numOutputs);
+    
+    // find the vertex of either mesh nearest to the mouse
+    void updateHoveredVertex(float x, float y);
+    
+    // move the selected vertex so that it's at screen
+    void moveSelectedVertex(const ofVec2f& screen);
+    void clearSelection();
+    void bloomModeChanged(int& bloomMode);
+    
+    // draws the cats into eqFbo, only touching the columns that have changed
+    void updateEqFbo();
+    
+    // the video if there is one and it's switched on, the eq if not
+    ofTexture& getBoxTexture();
+    
+    // the outline pulses between half and full brightness green
+    ofColor getOutlineColour() const;
+    
+    // draws the box and its outline, this is the same for every output,
+    // only the camera that ofxPostProcessing is given changes
+    void drawScene(ProjectorOutput& output);
+    
+    // the outputs are side by side across the window, each
+    // one goes to a projector when the window spans them all
+    ofRectangle getOutputViewport(unsigned output) const;
+    
+    // the output that (x, y) on the screen is in
+    unsigned getOutputAt(float x, float y) const;
+    
+    // set the post processing up at the size of one output
+    void resizeOutputs();
+    
+    // the meshes can only be warped with the mouse when there's one output as
+    // that's the only camera they know about, and not while we're calibrating,
+    // we pick and drag the vertices ourselves so the meshes' own events are off
+    void updateMeshEvents();
+    
+    // solve for the projector being calibrated from its targets
+    // and put the result into its parameters and camera
+    void calibrateProjector();
+    
+    // draw where the corners of the box are and where they should be
+    void drawCalibration();
+    
+    // save the window and each output in it for setDump()
+    void dumpOutputs();
+    
+    // the corner of the box nearest to (x, y) on the screen, going by its
+    // target if it has one and where it's projected to if it doesn't,
+    // returns -1 if none of them are within maxDistance pixels
+    int getNearestCalibrationPoint(float x, float y, float maxDistance) const;
+    
+    // each projector has its own camera, settings and calibration, the
+    // scene and the warped meshes are shared by all of them
+    ProjectorOutput outputs[MAX_OUTPUTS];
+    unsigned requestedNumOutputs;
     
-    ofCamera projector;
     ofxWarpableMesh boxMesh;
     ofxWarpableMesh outlineMesh;
     
+    // this saves our warping as we go
+    WarpJournal warpJournal;
+    
+    // these find the vertex under the mouse without looking at
+    // every vertex, however dense the meshes get
+    VertexPicker boxPicker;
+    VertexPicker outlinePicker;
+    
+    // the vertex the mouse is over is circled so we can see what will be picked
+    VertexPicker* hoveredPicker;
+    int hoveredVertex;
+    
+    // clicking picks the vertex to warp, it follows the mouse while it's
+    // dragged, keeping where on the vertex it was grabbed, and the arrow
+    // keys nudge it a pixel at a time until another one is picked
+    VertexPicker* selectedPicker;
+    int selectedVertex;
+    ofVec2f dragOffset;
+    bool dragging;
+    
     // user interface
     ofxPanel gui;
-    ofParameter<ofVec3f> projectorPosition;
-    ofParameter<float> projectorTilt;
+    ofParameter<int> numOutputs;
     ofParameter<float> boxAngle;
+    ofParameter<bool> incrementalEq;
+    ofParameter<int> bloomMode;
+    ofParameter<bool> remapBox;
+    ofParameter<bool> showVideo;
+    ofParameter<bool> blendEdges;
+    ofParameter<float> blendFeather;
+    ofParameter<float> blendGamma;
     bool drawGui;
     
+    // in calibration mode we click and drag where the corners of the
+    // box really are and the projector is solved to match, with several
+    // outputs it's the one the mouse was in when we started
+    bool calibrating;
+    unsigned calibrationOutput;
+    int selectedCalibrationPoint;
+    
+    // fades the outputs out where they overlap on the box
+    EdgeBlend edgeBlend;
+    
     // outline
     ofxPostProcessing outlineEffects;
     
+    // the original full resolution bloom and the cheaper one that works on
+    // smaller copies of the image, only one of these is enabled at a time
+    shared_ptr<BloomPass> bloomPass;
+    MipBloomPass::Ptr mipBloomPass;
+    
     // this plays our audio file
     ofSoundPlayer soundPlayer;
+    
+    // if we have a wav version of our audio file then we play it with
+    // these instead so that we can analyse the samples as they are played
+    ofSoundStream soundStream;
+    PcmPlayer pcmPlayer;
+    StreamingFft streamingFft;
+    
+    // takes the place of the sound card when there isn't one
+    NullSoundStream nullSoundStream;
+    bool nullAudio;
+    
+    // times the bursts from being played to being drawn when we're probing
+    LatencyProbe latencyProbe;
+    string latencyProbePath;
+    
+    string dumpPrefix;
 
-    // these variables will hold the data related to the
-    // levels of frequency bands in the sound file
-    float smoothedFft[NUM_FFT_BANDS];
-    float maxFft[NUM_FFT_BANDS];
-    float normalisedFft[NUM_FFT_BANDS];
+    // this analyses the sound on another thread and will hold the
+    // data related to the levels of frequency bands in the sound file
+    AudioAnalysisThread analysisThread;
 
     // this frame buffer is where we will hold the eq
     ofFbo eqFbo;
-
-    // this is our laser cat image
+    
+    // pre-rendered content that is shown on the box instead of the eq
+    VideoTextureSource videoSource;
+    string videoPath;
+    float videoFrameRate;
+    
+    // the outline as ILDA frames for a laser next to the first projector
+    LaserOutput laserOutput;
+    string laserDestination;
+    unsigned laserPointsPerSecond;
+    
+    // this is our laser cat image, it's decoded into the
+    // pixels on another thread and then uploaded
     ofImage catImage;
+    ofPixels catPixels;
+
+    // this batches up all of the cats so they're drawn in one go
+    SpriteBatch catBatch;
+    
+    // this is what is currently in eqFbo so that we
+    // only need to redraw the columns that change
+    ofFloatColor eqColumnColours[NUM_FFT_BANDS];
+    unsigned eqCatsInColumn[NUM_FFT_BANDS];
+    bool eqFboDrawn;
+    
+    // how many times we've had to redraw all, some or none of the eq
+    unsigned long numEqFramesFull;
+    unsigned long numEqFramesPartial;
+    unsigned long numEqFramesSkipped;
+    
+    // times each part of the frame on the cpu and the gpu
+    FrameProfiler profiler;
+    unsigned eqStage;
+    unsigned videoStage;
+    unsigned remapStage;
+    unsigned edgeBlendStage;
+    unsigned laserStage;
+    unsigned sceneStage;
+    unsigned postProcessingStage;
+    unsigned otherOutputsStage;
+    unsigned guiStage;
+    bool drawProfiler;
+    
+    // waits for the display to refresh rather than a fixed frame rate
+    FramePacer framePacer;
+    
+    // loads the settings and meshes again when they change on disk
+    HotReloader hotReloader;
+    
+    // reads and decodes the files on other threads while we start up, until
+    // it's done only the loading bar is drawn, settingsXml is parsed there
+    AssetLoader assetLoader;
+    ofXml settingsXml;
+    
+    // model.ply, loaded once for both the box and the outline if they need it
+    ofMesh model;
+    once_flag modelLoaded;
+    bool loading;
+    unsigned long long startupMicros;
+    unsigned long long setupMicros;
 };
@@ -5,8 +5,9 @@ const ofVec3f ofApp::BOX_DIMS = ofVec3f(26.65f, 26.65f, 11.f);
 //--------------------------------------------------------------
 void ofApp::setup()
 {
-    // set some openFrameworks settings
-    ofSetFrameRate(60);
+    // set some openFrameworks settings, the frames are
+    // paced to the display's refresh rather than 60fps
+    framePacer.setup();
     ofBackground(0);
     
     // create a mesh that we will render as a wireframe so that we can
@@ -45,8 +46,17 @@ void ofApp::setup()
                                   ofVec3f(-10.f, 20.f, -150.f),
                                   ofVec3f(10.f, 50.f, -100.f)));
     
+    gui.add(framePacer.parameters);
+    
     // load the settings from the previous time we ran the application
     gui.loadFromFile("settings.xml");
+    
+    // load the settings again if they're changed while we're running
+    hotReloader.addSettings(gui.getParameter(), "settings.xml");
+    hotReloader.setup();
+    
+    // the gui's save button writes settings.xml while we're watching it
+    ofAddListener(gui.savePressedE, this, &ofApp::savePressed);
 }
 
 //--------------------------------------------------------------
@@ -95,6 +105,16 @@ void ofApp::draw()
 
 void ofApp::exit()
 {
+    // say how well we kept up with the display
+    ofLogNotice("ofApp") << "frame pacing: " << framePacer.getStatus();
+    
+    // stop watching the files before we save them ourselves
+    hotReloader.close();
+    
+    // a benchmark only renders frames, it mustn't save over
+    // the settings that the app loads next time it's run
+    if (HeadlessBenchmark::isRunning()) return;
+    
     // save the settings
     gui.saveToFile("settings.xml");
 }
@@ -113,6 +133,15 @@ void ofApp::projectorTiltChanged(float& projectorTilt)
     projector.setOrientation(ofVec3f(projectorTilt, orientation.y, orientation.z));
 }
 
+bool ofApp::savePressed()
+{
+    // save it ourselves rather than letting the gui do it so that we can tell
+    // the hot reloader it's us and it doesn't load the settings back in
+    gui.saveToFile("settings.xml");
+    hotReloader.fileSaved("settings.xml");
+    return true;
+}
+
 void ofApp::keyPressed(int key)
 {
     if (key == 'f') ofToggleFullscreen();
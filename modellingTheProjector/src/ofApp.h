@@ -4,6 +4,9 @@
 #include "ofxPostProcessing.h"
 #include "ofxGui.h"
 #include "ofxWarpableMesh.h"
+#include "FramePacer.h"
+#include "HotReloader.h"
+#include "HeadlessBenchmark.h"
 
 class ofApp : public ofBaseApp
 {
@@ -26,6 +29,9 @@ public:
     void gotMessage(ofMessage msg);
 
 private:
+    // saves the settings when the gui's save button is pressed
+    bool savePressed();
+    
     void projectorPositionChanged(ofVec3f& projectorPosition);
     void projectorTiltChanged(float& projectorTilt);
     
@@ -38,4 +44,10 @@ private:
     ofParameter<ofVec3f> projectorPosition;
     ofParameter<float> projectorTilt;
     ofParameter<float> boxAngle;
+    
+    // waits for the display to refresh rather than a fixed frame rate
+    FramePacer framePacer;
+    
+    // loads the settings and meshes again when they change on disk
+    HotReloader hotReloader;
 };
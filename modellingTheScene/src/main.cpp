@@ -1,8 +1,14 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "HeadlessBenchmark.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	// run with --benchmark to render a fixed number of frames in a hidden
+	// window and write out how long they took rather than running normally
+	HeadlessBenchmark::Settings benchmark;
+	if (benchmark.parse(argc, argv)) return HeadlessBenchmark::run(new ofApp(), benchmark);
+
 	ofSetupOpenGL(1024, 768, OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
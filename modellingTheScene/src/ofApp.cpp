@@ -5,8 +5,9 @@ const ofVec3f ofApp::BOX_DIMS = ofVec3f(26.65f, 26.65f, 11.f);
 //--------------------------------------------------------------
 void ofApp::setup()
 {
-    // set some openFrameworks settings
-    ofSetFrameRate(60);
+    // set some openFrameworks settings, the frames are
+    // paced to the display's refresh rather than 60fps
+    framePacer.setup();
     ofBackground(0);
     
     // create a mesh that we will render as a wireframe so that we can
@@ -59,6 +60,8 @@ void ofApp::draw()
 
 void ofApp::exit()
 {
+    // say how well we kept up with the display
+    ofLogNotice("ofApp") << "frame pacing: " << framePacer.getStatus();
 }
 
 void ofApp::keyPressed(int key)
@@ -4,6 +4,7 @@
 #include "ofxPostProcessing.h"
 #include "ofxGui.h"
 #include "ofxWarpableMesh.h"
+#include "FramePacer.h"
 
 class ofApp : public ofBaseApp
 {
@@ -29,4 +30,7 @@ private:
     ofVboMesh boxMesh;
     ofVboMesh wireframeMesh;
     ofEasyCam camera;
+    
+    // waits for the display to refresh rather than a fixed frame rate
+    FramePacer framePacer;
 };
@@ -0,0 +1,390 @@
+#include "MeshDeformer.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    // below this many vertices handing work to another thread costs more than it saves
+    const unsigned MIN_VERTICES_PER_THREAD = 4096;
+
+    // added to the diagonal to keep the solve stable when two controls are very close together
+    const double REGULARISATION = 1e-6;
+}
+
+MeshDeformer::MeshDeformer() :
+    mesh(NULL),
+    radius(1.f),
+    weightsDirty(false),
+    lastUpdateMillis(0.f)
+{
+}
+
+void MeshDeformer::setup(ofMesh& mesh, float radius)
+{
+    this->mesh = &mesh;
+    this->radius = radius;
+
+    // we use a const reference so that looking at the vertices
+    // doesn't make a vbo mesh think it needs to upload them again
+    const ofMesh& constMesh = mesh;
+    rest = constMesh.getVertices();
+    deformed = rest;
+    controls.clear();
+    affected.clear();
+    weights.clear();
+    weightsDirty = false;
+    moved.clear();
+    isMoved.assign(rest.size(), 0);
+}
+
+void MeshDeformer::setRadius(float radius)
+{
+    if (radius == this->radius) return;
+    this->radius = radius;
+    if (!controls.empty()) weightsDirty = true;
+}
+
+void MeshDeformer::vertexMoved(unsigned index)
+{
+    if (!mesh || index >= deformed.size() || mesh->getNumVertices() != deformed.size()) return;
+
+    // if the vertex is where we put it then it was us that moved it
+    const ofMesh& constMesh = *mesh;
+    const ofVec3f& vertex = constMesh.getVertices()[index];
+    if (vertex == deformed[index]) return;
+    addMoved(index);
+
+    for (unsigned i = 0; i < controls.size(); ++i)
+    {
+        if (controls[i].vertex == index)
+        {
+            controls[i].displacement = vertex - rest[index];
+            return;
+        }
+    }
+
+    if (controls.size() >= MAX_CONTROLS)
+    {
+        // bake the shape from before this vertex was moved, the mesh has it
+        // where it's just been put so baking the mesh would make that its
+        // rest position and nothing around it would follow, any control that
+        // has moved since the last update keeps where it was put
+        for (unsigned i = 0; i < controls.size(); ++i)
+        {
+            deformed[controls[i].vertex] = rest[controls[i].vertex] + controls[i].displacement;
+        }
+        rest = deformed;
+        controls.clear();
+        affected.clear();
+        weights.clear();
+    }
+
+    Control control;
+    control.vertex = index;
+    control.displacement = vertex - rest[index];
+    control.appliedDisplacement = control.displacement;
+    controls.push_back(control);
+    weightsDirty = true;
+}
+
+bool MeshDeformer::update()
+{
+    if (!mesh) return false;
+
+    // if the mesh has been replaced then start again from its new shape
+    if (mesh->getNumVertices() != rest.size())
+    {
+        setup(*mesh, radius);
+        return false;
+    }
+
+    const unsigned long long start = ofGetElapsedTimeMicros();
+    const unsigned numControls = controls.size();
+
+    if (weightsDirty)
+    {
+        // the vertices that were following the controls go back to where
+        // they started and the ones that are within reach now move
+        weightsDirty = false;
+        addMoved(affected);
+        rebuildWeights();
+        addMoved(affected);
+
+        // put every vertex back where it started and then add on
+        // the whole of each control's displacement
+        for (unsigned i = 0; i < numControls; ++i) controls[i].appliedDisplacement = controls[i].displacement;
+        parallelFor(rest.size(), [&](unsigned begin, unsigned end)
+        {
+            copy(rest.begin() + begin, rest.begin() + end, deformed.begin() + begin);
+        });
+        parallelFor(affected.size(), [&](unsigned begin, unsigned end)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                const float* vertexWeights = &weights[i * numControls];
+                ofVec3f& vertex = deformed[affected[i]];
+                for (unsigned j = 0; j < numControls; ++j) vertex += vertexWeights[j] * controls[j].displacement;
+            }
+        });
+
+        vector<ofVec3f>& vertices = mesh->getVertices();
+        parallelFor(rest.size(), [&](unsigned begin, unsigned end)
+        {
+            copy(deformed.begin() + begin, deformed.begin() + end, vertices.begin() + begin);
+        });
+    }
+    else
+    {
+        // only add on how far each control has moved since last time,
+        // normally that's just the one being dragged
+        vector<pair<unsigned, ofVec3f> > changes;
+        for (unsigned i = 0; i < numControls; ++i)
+        {
+            if (controls[i].displacement != controls[i].appliedDisplacement)
+            {
+                changes.push_back(make_pair(i, controls[i].displacement - controls[i].appliedDisplacement));
+                controls[i].appliedDisplacement = controls[i].displacement;
+            }
+        }
+        if (changes.empty()) return false;
+        addMoved(affected);
+
+        vector<ofVec3f>& vertices = mesh->getVertices();
+        parallelFor(affected.size(), [&](unsigned begin, unsigned end)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                const float* vertexWeights = &weights[i * numControls];
+                ofVec3f& vertex = deformed[affected[i]];
+                for (unsigned j = 0; j < changes.size(); ++j) vertex += vertexWeights[changes[j].first] * changes[j].second;
+                vertices[affected[i]] = vertex;
+            }
+        });
+    }
+
+    lastUpdateMillis = (ofGetElapsedTimeMicros() - start) / 1000.f;
+    return true;
+}
+
+void MeshDeformer::bake()
+{
+    if (!mesh) return;
+    const ofMesh& constMesh = *mesh;
+    rest = constMesh.getVertices();
+    deformed = rest;
+    controls.clear();
+    affected.clear();
+    weights.clear();
+    weightsDirty = false;
+
+    // the moves so far still need saving unless the mesh has been replaced
+    if (isMoved.size() != rest.size())
+    {
+        moved.clear();
+        isMoved.assign(rest.size(), 0);
+    }
+}
+
+void MeshDeformer::takeMovedVertices(vector<unsigned>& vertices)
+{
+    vertices.clear();
+    vertices.swap(moved);
+    for (unsigned vertex : vertices) isMoved[vertex] = 0;
+}
+
+void MeshDeformer::addMoved(unsigned vertex)
+{
+    if (isMoved[vertex]) return;
+    isMoved[vertex] = 1;
+    moved.push_back(vertex);
+}
+
+void MeshDeformer::addMoved(const vector<unsigned>& vertices)
+{
+    for (unsigned vertex : vertices) addMoved(vertex);
+}
+
+float MeshDeformer::getWeight(float distance) const
+{
+    const float r = distance / radius;
+    if (r >= 1.f) return 0.f;
+    const float t = 1.f - r;
+    return t * t * t * t * (4.f * r + 1.f);
+}
+
+void MeshDeformer::rebuildWeights()
+{
+    const unsigned numControls = controls.size();
+    affected.clear();
+    weights.clear();
+    if (!numControls) return;
+
+    // the bumps around the controls have to add up to each control's
+    // displacement at each control, that's a set of linear equations
+    // a * heights = displacements, where a[i][j] is the weight of
+    // control j at control i, because the weights only depend on where
+    // the controls are we invert a once and reuse it as they're dragged
+    vector<double> a(numControls * numControls);
+    for (unsigned i = 0; i < numControls; ++i)
+    {
+        for (unsigned j = 0; j < numControls; ++j)
+        {
+            a[i * numControls + j] = getWeight(rest[controls[i].vertex].distance(rest[controls[j].vertex]));
+        }
+        a[i * numControls + i] += REGULARISATION;
+    }
+
+    // a is symmetric and positive definite so we can use a cholesky
+    // decomposition, a = l * l^T, and then solve for each column of the inverse
+    vector<double> l(numControls * numControls, 0.0);
+    for (unsigned i = 0; i < numControls; ++i)
+    {
+        for (unsigned j = 0; j <= i; ++j)
+        {
+            double sum = a[i * numControls + j];
+            for (unsigned k = 0; k < j; ++k) sum -= l[i * numControls + k] * l[j * numControls + k];
+            if (i == j) l[i * numControls + i] = sqrt(max(sum, REGULARISATION));
+            else l[i * numControls + j] = sum / l[j * numControls + j];
+        }
+    }
+
+    vector<float> inverse(numControls * numControls);
+    vector<double> column(numControls);
+    for (unsigned c = 0; c < numControls; ++c)
+    {
+        // forward substitution for l * y = e_c then back substitution for l^T * x = y
+        for (unsigned i = 0; i < numControls; ++i)
+        {
+            double sum = i == c ? 1.0 : 0.0;
+            for (unsigned k = 0; k < i; ++k) sum -= l[i * numControls + k] * column[k];
+            column[i] = sum / l[i * numControls + i];
+        }
+        for (int i = numControls - 1; i >= 0; --i)
+        {
+            double sum = column[i];
+            for (unsigned k = i + 1; k < numControls; ++k) sum -= l[k * numControls + i] * column[k];
+            column[i] = sum / l[i * numControls + i];
+        }
+        for (unsigned i = 0; i < numControls; ++i) inverse[i * numControls + c] = column[i];
+    }
+
+    // only vertices within radius of a control can move, which
+    // for a local warp on a dense mesh is only a few of them
+    vector<unsigned char> isAffected(rest.size());
+    parallelFor(rest.size(), [&](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            isAffected[i] = 0;
+            for (unsigned j = 0; j < numControls && !isAffected[i]; ++j)
+            {
+                isAffected[i] = rest[i].squareDistance(rest[controls[j].vertex]) < radius * radius;
+            }
+        }
+    });
+    for (unsigned i = 0; i < rest.size(); ++i)
+    {
+        if (isAffected[i]) affected.push_back(i);
+    }
+
+    // each affected vertex moves by its weight for each control times the
+    // heights, i.e. by (its weights * the inverse of a) * displacements,
+    // the first part of that is what we keep
+    weights.resize(affected.size() * numControls);
+    parallelFor(affected.size(), [&](unsigned begin, unsigned end)
+    {
+        vector<pair<unsigned, float> > controlWeights;
+        for (unsigned i = begin; i < end; ++i)
+        {
+            // most controls are too far away to have any weight so we skip them
+            const ofVec3f& vertex = rest[affected[i]];
+            controlWeights.clear();
+            for (unsigned j = 0; j < numControls; ++j)
+            {
+                const float weight = getWeight(vertex.distance(rest[controls[j].vertex]));
+                if (weight > 0.f) controlWeights.push_back(make_pair(j, weight));
+            }
+
+            float* vertexWeights = &weights[i * numControls];
+            fill(vertexWeights, vertexWeights + numControls, 0.f);
+            for (unsigned j = 0; j < controlWeights.size(); ++j)
+            {
+                const float* row = &inverse[controlWeights[j].first * numControls];
+                const float weight = controlWeights[j].second;
+                for (unsigned k = 0; k < numControls; ++k) vertexWeights[k] += weight * row[k];
+            }
+        }
+    });
+}
+
+void MeshDeformer::parallelFor(unsigned size, const function<void(unsigned, unsigned)>& body)
+{
+    // small meshes don't need the pool at all so it isn't even started
+    const unsigned maxParts = size / MIN_VERTICES_PER_THREAD;
+    if (maxParts <= 1)
+    {
+        if (size) body(0, size);
+        return;
+    }
+
+    WorkerPool& pool = WorkerPool::get();
+    pool.parallelFor(size, min(maxParts, pool.getNumThreads()), [&](size_t begin, size_t end)
+    {
+        body(begin, end);
+    });
+}
+
+string MeshDeformer::benchmark(unsigned numVertices)
+{
+    const unsigned resolution = ceil(sqrt((float)numVertices));
+    ofMesh mesh = ofMesh::plane(100.f, 100.f, resolution, resolution);
+
+    MeshDeformer deformer;
+    deformer.setup(mesh, 30.f);
+
+    // move some vertices spread over the plane, like pulling the corners
+    // and edges of a surface into place, each one adds a control
+    const unsigned numControls = 8;
+    float addMillis = 0.f;
+    for (unsigned i = 0; i < numControls; ++i)
+    {
+        const unsigned row = ofMap(i / 3, 0, 2, .1f, .9f) * (resolution - 1);
+        const unsigned column = ofMap(i % 3, 0, 2, .1f, .9f) * (resolution - 1);
+        const unsigned vertex = row * resolution + column;
+        mesh.getVertices()[vertex] += ofVec3f(1.f, 2.f, 3.f);
+        deformer.vertexMoved(vertex);
+        deformer.update();
+        addMillis = deformer.getLastUpdateMillis();
+    }
+
+    // then drag the last one around for a couple of seconds worth of frames
+    const unsigned numFrames = 120;
+    const unsigned dragged = deformer.controls.back().vertex;
+    float dragMillis = 0.f;
+    float maxDragMillis = 0.f;
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        mesh.getVertices()[dragged] += ofVec3f(.1f, 0.f, 0.f);
+        deformer.vertexMoved(dragged);
+        deformer.update();
+        dragMillis += deformer.getLastUpdateMillis();
+        maxDragMillis = max(maxDragMillis, deformer.getLastUpdateMillis());
+    }
+
+    // the worst case for adding a control is when there are already lots of them
+    for (unsigned i = deformer.getNumControls(); i < MAX_CONTROLS; ++i)
+    {
+        const unsigned vertex = ofRandom(mesh.getNumVertices());
+        mesh.getVertices()[vertex] += ofVec3f(0.f, 0.f, 1.f);
+        deformer.vertexMoved(vertex);
+    }
+    deformer.update();
+    const float maxAddMillis = deformer.getLastUpdateMillis();
+
+    stringstream report;
+    report << mesh.getNumVertices() << " vertices on " << max(1u, thread::hardware_concurrency()) << " cores: "
+           << "adding control " << numControls << " " << addMillis << "ms, "
+           << "dragging " << dragMillis / numFrames << "ms (worst " << maxDragMillis << "ms), "
+           << "rebuilding with " << MAX_CONTROLS << " controls " << maxAddMillis << "ms ("
+           << deformer.getNumAffectedVertices() << " vertices affected)";
+    return report.str();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ofMain.h"
+
+// smoothly bends a dense mesh when a few of its vertices are moved
+//
+// dragging thousands of vertices one at a time isn't a sensible way to
+// warp a finely subdivided mesh, so instead any vertex that gets moved by
+// hand becomes a control and every other vertex near it follows along
+//
+// how far each vertex moves is worked out with radial basis functions
+// (rbf), each control has a smooth bump around it that falls to nothing
+// at radius, the heights of the bumps are solved for so that the controls
+// end up exactly where they were put, because the bumps fall to nothing
+// anything further than radius from every control stays where it is
+//
+// the expensive part is working out how much each control moves each
+// vertex, this only has to be done when a control is added or the radius
+// changes, dragging a control just adds on how far it moved times its
+// weights, which is cheap enough to do every frame with 100k vertices,
+// both are split across all of the cpu's cores by a pool of threads that
+// are kept waiting rather than started every time
+class MeshDeformer
+{
+public:
+    // with more controls than this the current shape is
+    // baked in and we start again with no controls
+    static const unsigned MAX_CONTROLS = 64;
+
+    MeshDeformer();
+
+    // the current shape of the mesh is what it's deformed from, the mesh
+    // must stay around for as long as the deformer
+    void setup(ofMesh& mesh, float radius);
+
+    // how far the influence of each control reaches, in the same units as the mesh
+    void setRadius(float radius);
+    float getRadius() const { return radius; }
+
+    // call this for any vertex that might have been moved, if it has been
+    // moved by something other than this deformer it becomes a control
+    void vertexMoved(unsigned index);
+
+    // move the rest of the vertices to follow the controls, returns
+    // true if any vertices were moved
+    bool update();
+
+    // keep the mesh as it is now and forget the controls, so
+    // the next vertex that is moved starts from this shape
+    void bake();
+
+    // the vertices that have moved since this was last called, the controls
+    // as well as the ones that followed them, so that they can be saved
+    // without looking through every vertex for the ones that moved
+    void takeMovedVertices(vector<unsigned>& vertices);
+
+    unsigned getNumControls() const { return controls.size(); }
+    unsigned getNumAffectedVertices() const { return affected.size(); }
+    float getLastUpdateMillis() const { return lastUpdateMillis; }
+
+    // makes a plane with about numVertices vertices and returns a report of how
+    // long it takes to add controls and to drag them
+    static string benchmark(unsigned numVertices = 100000);
+
+private:
+    struct Control
+    {
+        unsigned vertex;
+
+        // how far the control has been moved from where it was in rest,
+        // and how far it had been moved when the mesh was last updated
+        ofVec3f displacement;
+        ofVec3f appliedDisplacement;
+    };
+
+    // the compactly supported wendland function, one at
+    // the control and falling smoothly to zero at radius
+    float getWeight(float distance) const;
+
+    // work out how much each control moves each vertex
+    void rebuildWeights();
+
+    // add vertices to the ones that have moved if they aren't already
+    void addMoved(unsigned vertex);
+    void addMoved(const vector<unsigned>& vertices);
+
+    // split [0, size) across the pool's threads and call body on each part
+    static void parallelFor(unsigned size, const function<void(unsigned, unsigned)>& body);
+
+    ofMesh* mesh;
+    float radius;
+
+    // where the vertices are with no controls and where we last put them,
+    // if a vertex isn't where we put it then something else has moved it
+    vector<ofVec3f> rest;
+    vector<ofVec3f> deformed;
+
+    vector<Control> controls;
+
+    // the vertices that are within radius of a control and, for each of
+    // them, how much each control moves it, stored as controls.size()
+    // floats per vertex, i.e. affected[i] moves by the sum over the
+    // controls c of weights[i * controls.size() + c] * displacement
+    vector<unsigned> affected;
+    vector<float> weights;
+    bool weightsDirty;
+
+    // what takeMovedVertices() hands over, with a flag for each
+    // vertex so that each one is only in the list once
+    vector<unsigned> moved;
+    vector<unsigned char> isMoved;
+
+    float lastUpdateMillis;
+};
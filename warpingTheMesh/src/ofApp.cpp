@@ -5,29 +5,37 @@ const ofVec3f ofApp::BOX_DIMS = ofVec3f(26.65f, 26.65f, 11.f);
 //--------------------------------------------------------------
 void ofApp::setup()
 {
-    // set some openFrameworks settings
-    ofSetFrameRate(60);
+    // set some openFrameworks settings, the frames are
+    // paced to the display's refresh rather than 60fps
+    framePacer.setup();
     ofBackground(0);
     
-    // check whether we've previously saved meshes
-    if (ofFile("wireframe.ply").exists() && ofFile("box.ply").exists())
+    // check whether we've previously saved meshes, we save them as binary
+    // as well as ply because the binary versions are much quicker to load,
+    // unless a ply has been changed since, both are loaded before either
+    // is used so we never end up with one from each
+    const unsigned long long meshLoadStart = ofGetElapsedTimeMicros();
+    ofMesh binaryWireframe;
+    ofMesh binaryBox;
+    if (BinaryMesh::isUpToDate("wireframe.mesh", "wireframe.ply") && BinaryMesh::isUpToDate("box.mesh", "box.ply") &&
+        BinaryMesh::load("wireframe.mesh", binaryWireframe) && BinaryMesh::load("box.mesh", binaryBox))
+    {
+        wireframeMesh = binaryWireframe;
+        boxMesh = binaryBox;
+        ofLogNotice("ofApp") << "loaded binary meshes in " << (ofGetElapsedTimeMicros() - meshLoadStart) / 1000.f << "ms";
+    }
+    else if (ofFile("wireframe.ply").exists() && ofFile("box.ply").exists())
     {
         // we have saved meshes so load them up
         wireframeMesh.load("wireframe.ply");
         boxMesh.load("box.ply");
+        ofLogNotice("ofApp") << "loaded ply meshes in " << (ofGetElapsedTimeMicros() - meshLoadStart) / 1000.f << "ms";
     }
     else
     {
-        // create a mesh that we will render as a wireframe so that we can
-        // see where the edges of the box are
-        wireframeMesh = ofMesh::box(BOX_DIMS.x, BOX_DIMS.y, BOX_DIMS.z, 1, 1, 1);
-        
-        // create a new box mesh that is the dimensions that we want
-        // we make the dimensions very slightly smaller than the dimensions
-        // of the outline of the box so that the computer knows that the
-        // outline is to be rendered outside of the box and we can use
-        // it to hide the outline at the back of the box
-        boxMesh = ofMesh::box(.999f * BOX_DIMS.x, .999f * BOX_DIMS.y, .999f * BOX_DIMS.z, 1, 1, 1);
+        // to start with we just have a box with its eight corners,
+        // press n to make meshes with the resolution in the gui
+        createMeshes(1, false);
     }
     
     // set the camera in the meshes, this is needed so that we know
@@ -36,10 +44,41 @@ void ofApp::setup()
     wireframeMesh.setCamera(projector);
     boxMesh.setCamera(projector);
     
-    // enable keyboard and mouse events for the meshes
-    // so that they can be warped
-    wireframeMesh.setEventsEnabled(true);
-    boxMesh.setEventsEnabled(true);
+    // the pickers need the same camera to work out where
+    // the vertices are on the screen
+    boxPicker.setup(boxMesh, projector);
+    wireframePicker.setup(wireframeMesh, projector);
+    hoveredPicker = NULL;
+    hoveredVertex = -1;
+    clearSelection();
+    
+    // we pick and drag the vertices ourselves with the pickers, the meshes'
+    // own mouse and keyboard events look at every vertex so they stay off
+    wireframeMesh.setEventsEnabled(false);
+    boxMesh.setEventsEnabled(false);
+    
+    // keep a journal of every vertex that we warp so that we don't lose our
+    // alignment if we crash, this also puts back anything that was warped
+    // after the meshes were last saved in full
+    warpJournal.addMesh(boxMesh, "box.mesh");
+    warpJournal.addMesh(wireframeMesh, "wireframe.mesh");
+    warpJournal.setup("warp.journal");
+    
+    // the journal already looks for the vertices that have moved so it
+    // tells the pickers and deformers rather than them looking as well
+    warpJournal.setListener([this](unsigned mesh, unsigned vertex)
+    {
+        if (mesh == 0)
+        {
+            boxPicker.vertexMoved(vertex);
+            boxDeformer.vertexMoved(vertex);
+        }
+        else
+        {
+            wireframePicker.vertexMoved(vertex);
+            wireframeDeformer.vertexMoved(vertex);
+        }
+    });
     
     // put our projector 200cm away from our object that will be at the origin
     projector.setPosition(0, 0, -200.f);
@@ -57,6 +96,7 @@ void ofApp::setup()
     projectorPosition.addListener(this, &ofApp::projectorPositionChanged);
     projectorTilt.addListener(this, &ofApp::projectorTiltChanged);
     boxAngle.addListener(this, &ofApp::boxAngleChanged);
+    deformRadius.addListener(this, &ofApp::deformRadiusChanged);
                          
     // set up user interface so we can tweak the projection
     gui.setup();
@@ -66,15 +106,72 @@ void ofApp::setup()
                                   ofVec3f(0.f, 0.f, -200.f),
                                   ofVec3f(-10.f, 20.f, -150.f),
                                   ofVec3f(10.f, 50.f, -100.f)));
+    gui.add(meshResolution.set("meshResolution", 1, 1, 256));
+    gui.add(planeMesh.set("planeMesh", false));
+    gui.add(deformRadius.set("deformRadius", 10.f, 1.f, 50.f));
+    
+    gui.add(framePacer.parameters);
     
     // load the settings from the previous time we ran the application
     gui.loadFromFile("settings.xml");
+    
+    // the deformers start from the meshes as they are now, which
+    // includes anything that the journal has put back
+    boxDeformer.setup(boxMesh, deformRadius);
+    wireframeDeformer.setup(wireframeMesh, deformRadius);
+    
+    // load the settings and the ply meshes again if they're changed while
+    // we're running, a new mesh is treated like pressing n, the deformers
+    // start again from it and the journal keeps the new vertices safe
+    hotReloader.addSettings(gui.getParameter(), "settings.xml");
+    hotReloader.addMesh(boxMesh, "box.ply");
+    hotReloader.addMesh(wireframeMesh, "wireframe.ply");
+    hotReloader.setListener([this](const string& path)
+    {
+        if (path == "settings.xml") return;
+        if (path == "box.ply")
+        {
+            boxDeformer.setup(boxMesh, deformRadius);
+            boxPicker.verticesChanged();
+        }
+        else
+        {
+            wireframeDeformer.setup(wireframeMesh, deformRadius);
+            wireframePicker.verticesChanged();
+        }
+        hoveredPicker = NULL;
+        hoveredVertex = -1;
+        clearSelection();
+        warpJournal.verticesChanged();
+    });
+    hotReloader.setup();
+    
+    // the gui's save button writes settings.xml while we're watching it
+    ofAddListener(gui.savePressedE, this, &ofApp::savePressed);
 }
 
 //--------------------------------------------------------------
 void ofApp::update()
 {
-
+    // write any meshes that have been made or loaded again to the journal
+    warpJournal.update();
+    
+    // move the rest of the vertices to follow the ones that have been moved
+    boxDeformer.update();
+    wireframeDeformer.update();
+    
+    // the deformers know which vertices have moved, by hand and following
+    // along, so only those are journalled and only once a drag is over
+    // rather than thousands of them every step of it, if we crash part
+    // way through a drag we lose that drag and nothing else
+    if (!dragging)
+    {
+        vector<unsigned> movedVertices;
+        boxDeformer.takeMovedVertices(movedVertices);
+        warpJournal.verticesMoved(0, movedVertices);
+        wireframeDeformer.takeMovedVertices(movedVertices);
+        warpJournal.verticesMoved(1, movedVertices);
+    }
 }
 
 //--------------------------------------------------------------
@@ -97,16 +194,10 @@ void ofApp::draw()
     ofSetColor(0);
     boxMesh.draw();
     
-    // draw the selected vertices for mesh warping
-    boxMesh.drawSelectedVertices();
-    
     // now draw a the wireframe
     ofSetColor(255);
     wireframeMesh.drawWireframe();
     
-    // draw the selected vertices for mesh warping
-    wireframeMesh.drawSelectedVertices();
-    
     // reset the transform to what it was before we rotated it
     ofPopMatrix();
     
@@ -117,18 +208,58 @@ void ofApp::draw()
     // of the projector
     projector.end();
     
+    // circle the vertex that the mouse is over
+    if (hoveredPicker && hoveredVertex >= 0)
+    {
+        ofPushStyle();
+        ofNoFill();
+        ofSetColor(255, 255, 0);
+        ofDrawCircle(hoveredPicker->getScreenPosition(hoveredVertex), 10.f);
+        ofPopStyle();
+    }
+    
+    // and fill in the one that's selected for warping
+    if (selectedPicker)
+    {
+        ofPushStyle();
+        ofSetColor(255, 0, 0);
+        ofDrawCircle(selectedPicker->getScreenPosition(selectedVertex), 5.f);
+        ofPopStyle();
+    }
+    
     // draw the user interface
     gui.draw();
 }
 
 void ofApp::exit()
 {
+    // say how well we kept up with the display
+    ofLogNotice("ofApp") << "frame pacing: " << framePacer.getStatus();
+    
+    // stop watching the files before we save them ourselves
+    hotReloader.close();
+    
+    // a benchmark only renders frames, it mustn't save over the
+    // settings and meshes that the app loads next time it's run
+    if (HeadlessBenchmark::isRunning())
+    {
+        warpJournal.close(false);
+        return;
+    }
+    
+    // save the meshes one last time from the journal
+    // and wait for it to finish writing
+    warpJournal.close();
+    
     // save the settings
     gui.saveToFile("settings.xml");
     
-    // save the meshes
+    // save the meshes, ply so they can be opened in other
+    // software and binary so they load quickly next time
     boxMesh.save("box.ply");
     wireframeMesh.save("wireframe.ply");
+    BinaryMesh::save(boxMesh, "box.mesh");
+    BinaryMesh::save(wireframeMesh, "wireframe.mesh");
 }
 
 void ofApp::projectorPositionChanged(ofVec3f& projectorPosition)
@@ -145,16 +276,137 @@ void ofApp::projectorTiltChanged(float& projectorTilt)
     projector.setOrientation(ofVec3f(projectorTilt, orientation.y, orientation.z));
 }
 
+void ofApp::createMeshes(unsigned resolution, bool plane)
+{
+    if (plane)
+    {
+        // ofMesh::plane() takes the number of vertices along each side
+        // rather than the number of times each side is divided
+        ofMesh mesh = ofMesh::plane(BOX_DIMS.x, BOX_DIMS.y, resolution + 1, resolution + 1);
+        wireframeMesh = mesh;
+        
+        // a plane can't hide anything behind it so rather than making it
+        // smaller we just push it back slightly so the wireframe is in front
+        for (ofVec3f& vertex : mesh.getVertices()) vertex.z += .01f;
+        boxMesh = mesh;
+    }
+    else
+    {
+        // create a mesh that we will render as a wireframe so that we can
+        // see where the edges of the box are
+        wireframeMesh = ofMesh::box(BOX_DIMS.x, BOX_DIMS.y, BOX_DIMS.z, resolution, resolution, resolution);
+        
+        // create a new box mesh that is the dimensions that we want
+        // we make the dimensions very slightly smaller than the dimensions
+        // of the outline of the box so that the computer knows that the
+        // outline is to be rendered outside of the box and we can use
+        // it to hide the outline at the back of the box
+        boxMesh = ofMesh::box(.999f * BOX_DIMS.x, .999f * BOX_DIMS.y, .999f * BOX_DIMS.z,
+                              resolution, resolution, resolution);
+    }
+}
+
+void ofApp::updateHoveredVertex(float x, float y)
+{
+    hoveredPicker = NULL;
+    hoveredVertex = -1;
+    if (gui.getShape().inside(x, y)) return;
+    
+    // the box and the wireframe have their corners in the same places so
+    // the wireframe only wins if its vertex is strictly nearer
+    const ofVec2f mouse(x, y);
+    float maxDistance = 20.f;
+    VertexPicker* pickers[] = { &boxPicker, &wireframePicker };
+    for (VertexPicker* picker : pickers)
+    {
+        const int vertex = picker->getNearest(mouse, maxDistance);
+        if (vertex >= 0)
+        {
+            hoveredPicker = picker;
+            hoveredVertex = vertex;
+            maxDistance = mouse.distance(picker->getScreenPosition(vertex));
+        }
+    }
+}
+
+void ofApp::moveSelectedVertex(const ofVec2f& screen)
+{
+    ofxWarpableMesh& mesh = selectedPicker == &boxPicker ? boxMesh : wireframeMesh;
+    MeshDeformer& deformer = selectedPicker == &boxPicker ? boxDeformer : wireframeDeformer;
+    mesh.getVertices()[selectedVertex] = selectedPicker->unproject(selectedVertex, screen);
+    
+    // the picker needs to know straight away so the next move starts from
+    // here and the deformer so the rest follow it on the next update, the
+    // journal tells the picker about those too once the drag is over
+    selectedPicker->vertexMoved(selectedVertex);
+    deformer.vertexMoved(selectedVertex);
+}
+
+void ofApp::clearSelection()
+{
+    selectedPicker = NULL;
+    selectedVertex = -1;
+    dragging = false;
+}
+
 void ofApp::boxAngleChanged(float& boxAngle)
 {
     ofMatrix4x4 rotation = ofMatrix4x4::newRotationMatrix(boxAngle, ofVec3f(0.f, 1.f, 0.f));
     boxMesh.setTransform(rotation);
     wireframeMesh.setTransform(rotation);
+    boxPicker.setTransform(rotation);
+    wireframePicker.setTransform(rotation);
+}
+
+void ofApp::deformRadiusChanged(float& deformRadius)
+{
+    // a new radius means working out all of the weights again, which is
+    // too slow to do for every step of the slider, so while it's being
+    // dragged we wait until the mouse is let go
+    if (ofGetMousePressed()) return;
+    boxDeformer.setRadius(deformRadius);
+    wireframeDeformer.setRadius(deformRadius);
+}
+
+bool ofApp::savePressed()
+{
+    // save it ourselves rather than letting the gui do it so that we can tell
+    // the hot reloader it's us and it doesn't load the settings back in
+    gui.saveToFile("settings.xml");
+    hotReloader.fileSaved("settings.xml");
+    return true;
 }
 
 void ofApp::keyPressed(int key)
 {
     if (key == 'f') ofToggleFullscreen();
+    else if (key == 'l') ofLogNotice("ofApp") << "mesh load benchmark: " << BinaryMesh::benchmark();
+    else if (key == 'v') ofLogNotice("ofApp") << "vertex picking benchmark: " << VertexPicker::benchmark();
+    else if (key == 'd') ofLogNotice("ofApp") << "mesh deformer benchmark: " << MeshDeformer::benchmark();
+    else if (key == 'n')
+    {
+        // start again with new meshes at the current resolution, this throws
+        // away the warp, the journal sees that everything has moved
+        createMeshes(meshResolution, planeMesh);
+        boxDeformer.setup(boxMesh, deformRadius);
+        wireframeDeformer.setup(wireframeMesh, deformRadius);
+        boxPicker.verticesChanged();
+        wireframePicker.verticesChanged();
+        clearSelection();
+        warpJournal.verticesChanged();
+    }
+    else if (key == 'b')
+    {
+        // keep the meshes as they are, the next vertex we
+        // move bends them from this shape rather than the last
+        boxDeformer.bake();
+        wireframeDeformer.bake();
+    }
+    else if (selectedPicker && key >= OF_KEY_LEFT && key <= OF_KEY_DOWN)
+    {
+        const ofVec2f steps[] = { ofVec2f(-1.f, 0.f), ofVec2f(0.f, -1.f), ofVec2f(1.f, 0.f), ofVec2f(0.f, 1.f) };
+        moveSelectedVertex(selectedPicker->getScreenPosition(selectedVertex) + steps[key - OF_KEY_LEFT]);
+    }
 }
 
 //--------------------------------------------------------------
@@ -163,23 +415,39 @@ void ofApp::keyReleased(int key){
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseMoved(int x, int y ){
-
+void ofApp::mouseMoved(int x, int y)
+{
+    updateHoveredVertex(x, y);
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseDragged(int x, int y, int button){
-
+void ofApp::mouseDragged(int x, int y, int button)
+{
+    updateHoveredVertex(x, y);
+    if (dragging) moveSelectedVertex(ofVec2f(x, y) + dragOffset);
 }
 
 //--------------------------------------------------------------
-void ofApp::mousePressed(int x, int y, int button){
-
+void ofApp::mousePressed(int x, int y, int button)
+{
+    if (gui.getShape().inside(x, y)) return;
+    
+    // pick whatever is circled, or nothing if we clicked away from the meshes
+    updateHoveredVertex(x, y);
+    selectedPicker = hoveredPicker;
+    selectedVertex = hoveredVertex;
+    dragging = selectedPicker != NULL;
+    if (dragging) dragOffset = selectedPicker->getScreenPosition(selectedVertex) - ofVec2f(x, y);
 }
 
 //--------------------------------------------------------------
-void ofApp::mouseReleased(int x, int y, int button){
-
+void ofApp::mouseReleased(int x, int y, int button)
+{
+    dragging = false;
+    
+    // catch up with the radius slider, this does nothing if it didn't move
+    boxDeformer.setRadius(deformRadius);
+    wireframeDeformer.setRadius(deformRadius);
 }
 
 //--------------------------------------------------------------
@@ -4,6 +4,13 @@
 #include "ofxPostProcessing.h"
 #include "ofxGui.h"
 #include "ofxWarpableMesh.h"
+#include "BinaryMesh.h"
+#include "WarpJournal.h"
+#include "VertexPicker.h"
+#include "MeshDeformer.h"
+#include "FramePacer.h"
+#include "HotReloader.h"
+#include "HeadlessBenchmark.h"
 
 class ofApp : public ofBaseApp
 {
@@ -26,17 +33,65 @@ public:
     void gotMessage(ofMessage msg);
 
 private:
+    // saves the settings when the gui's save button is pressed
+    bool savePressed();
+    
     void projectorPositionChanged(ofVec3f& projectorPosition);
     void projectorTiltChanged(float& projectorTilt);
     void boxAngleChanged(float& boxAngle);
+    void deformRadiusChanged(float& deformRadius);
+    
+    // make new box and wireframe meshes, or planes, with each side divided resolution times
+    void createMeshes(unsigned resolution, bool plane);
+    
+    // find the vertex of either mesh nearest to the mouse
+    void updateHoveredVertex(float x, float y);
+    
+    // move the selected vertex so that it's at screen
+    void moveSelectedVertex(const ofVec2f& screen);
+    void clearSelection();
     
     ofCamera projector;
     ofxWarpableMesh boxMesh;
     ofxWarpableMesh wireframeMesh;
     
+    // this saves our warping as we go
+    WarpJournal warpJournal;
+    
+    // these find the vertex under the mouse without looking at
+    // every vertex, however dense the meshes get
+    VertexPicker boxPicker;
+    VertexPicker wireframePicker;
+    
+    // the vertex the mouse is over is circled so we can see what will be picked
+    VertexPicker* hoveredPicker;
+    int hoveredVertex;
+    
+    // clicking picks the vertex to warp, it follows the mouse while it's
+    // dragged, keeping where on the vertex it was grabbed, and the arrow
+    // keys nudge it a pixel at a time until another one is picked
+    VertexPicker* selectedPicker;
+    int selectedVertex;
+    ofVec2f dragOffset;
+    bool dragging;
+    
+    // on subdivided meshes these move the vertices around the ones we
+    // move by hand so we only have to move a few of them
+    MeshDeformer boxDeformer;
+    MeshDeformer wireframeDeformer;
+    
     // user interface
     ofxPanel gui;
     ofParameter<ofVec3f> projectorPosition;
     ofParameter<float> projectorTilt;
     ofParameter<float> boxAngle;
+    ofParameter<int> meshResolution;
+    ofParameter<bool> planeMesh;
+    ofParameter<float> deformRadius;
+    
+    // waits for the display to refresh rather than a fixed frame rate
+    FramePacer framePacer;
+    
+    // loads the settings and meshes again when they change on disk
+    HotReloader hotReloader;
 };